@@ -0,0 +1,529 @@
+#if 0
+#include <Arduino.h>
+#include <M5Unified.h>
+#include "led/LEDManager.h"
+#include "led/FaceLayout.h"
+#include "led/JsonPatternPack.h"
+#include <SPIFFS.h>
+#include "core/Constants.h"
+
+// ベンチマーク用のLEDバッファ（20面 × 2LED + オフセット）
+#define BENCH_FACES 20
+#define BENCH_LEDS (BENCH_FACES * 2 + LED_ADDRESS_OFFSET)
+#define BENCH_ITERATIONS 1000
+// 乱数のシード（固定して毎回同じ入力で計測する）
+#define BENCH_SEED 12345
+
+CRGB benchLeds[BENCH_LEDS];
+
+// 1回あたりの平均処理時間（マイクロ秒）を表示
+void printResult(const char* name, unsigned long elapsedUs, int iterations) {
+    Serial.printf("%-32s %8.2f us/frame\n", name, (float)elapsedUs / iterations);
+}
+
+// パーティクルエンジン: 更新と加算描画
+void benchmarkParticles(int particleCount) {
+    ParticleSystem particles(particleCount);
+    particles.setTourPath(FaceTopology::icosahedron());
+    LedRandom random = LedRandom::withSeed(BENCH_SEED);
+    for (int i = 0; i < particleCount; i++) {
+        particles.spawn(random.next8(BENCH_FACES) << 8, random.next16(256, 4096), 0, CHSV(random.next8(), 255, 255));
+    }
+
+    unsigned long start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        particles.update(8);
+        particles.render(benchLeds, LED_ADDRESS_OFFSET, 2);
+    }
+    unsigned long elapsed = micros() - start;
+
+    char name[48];
+    snprintf(name, sizeof(name), "ParticleSystem (%d particles)", particleCount);
+    printResult(name, elapsed, BENCH_ITERATIONS);
+}
+
+// 炎シミュレーション: 1ステップと描画
+void benchmarkFire(int numFaces) {
+    FireSimulation fire;
+    fire.begin(FaceTopology::forFaceCount(numFaces), 2, 0);
+    LedRandom random = LedRandom::withSeed(BENCH_SEED);
+
+    unsigned long start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        fire.update(random);
+        fire.render(benchLeds, LED_ADDRESS_OFFSET);
+    }
+    unsigned long elapsed = micros() - start;
+
+    char name[48];
+    snprintf(name, sizeof(name), "FireSimulation (%d faces)", numFaces);
+    printResult(name, elapsed, BENCH_ITERATIONS);
+}
+
+// 乱数: LED1個ぶん（3チャンネル）の値を引く時間をArduinoのrandom()と比べる
+void benchmarkRandom() {
+    const int samples = BENCH_LEDS * 3;
+    volatile uint32_t sink = 0;
+
+    unsigned long start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        for (int j = 0; j < samples; j++) {
+            sink += random(256);
+        }
+    }
+    printResult("Arduino random(256)", micros() - start, BENCH_ITERATIONS);
+
+    LedRandom rng = LedRandom::withSeed(BENCH_SEED);
+    start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        for (int j = 0; j < samples; j++) {
+            sink += rng.below(256);
+        }
+    }
+    printResult("LedRandom::below(256)", micros() - start, BENCH_ITERATIONS);
+
+    // 同じシードから同じ系列が出ることを確認
+    LedRandom a = LedRandom::withSeed(BENCH_SEED);
+    LedRandom b = LedRandom::withSeed(BENCH_SEED);
+    bool same = true;
+    for (int i = 0; i < 1000; i++) {
+        if (a.range(-50, 50) != b.range(-50, 50)) same = false;
+    }
+    Serial.printf("LedRandom replay: %s\n", same ? "identical" : "MISMATCH");
+}
+
+// 線形光の合成: 全LEDのクロスフェード・減衰の処理時間をガンマ空間（FastLED）と比べる
+void benchmarkLinearLight() {
+    CRGB from[BENCH_LEDS];
+    CRGB to[BENCH_LEDS];
+    LedRandom random = LedRandom::withSeed(BENCH_SEED);
+    for (int i = 0; i < BENCH_LEDS; i++) {
+        from[i] = CRGB(random.next8(), random.next8(), random.next8());
+        to[i] = CRGB(random.next8(), random.next8(), random.next8());
+    }
+
+    unsigned long start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        for (int j = 0; j < BENCH_LEDS; j++) {
+            benchLeds[j] = blend(from[j], to[j], (uint8_t)i);
+        }
+    }
+    printResult("Crossfade gamma (FastLED)", micros() - start, BENCH_ITERATIONS);
+
+    start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        for (int j = 0; j < BENCH_LEDS; j++) {
+            benchLeds[j] = LinearLight::blend(from[j], to[j], (uint8_t)i);
+        }
+    }
+    printResult("Crossfade linear (LinearLight)", micros() - start, BENCH_ITERATIONS);
+
+    start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        if ((i & 31) == 0) memcpy(benchLeds, from, sizeof(from));
+        fadeToBlackBy(benchLeds, BENCH_LEDS, 20);
+    }
+    printResult("Fade gamma (FastLED)", micros() - start, BENCH_ITERATIONS);
+
+    start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        if ((i & 31) == 0) memcpy(benchLeds, from, sizeof(from));
+        LinearLight::fadeToBlackBy(benchLeds, BENCH_LEDS, 20);
+    }
+    printResult("Fade linear (LinearLight)", micros() - start, BENCH_ITERATIONS);
+}
+
+// 面ごとの色補正: 出力段で確定したフレームに行列を掛ける1パスの処理時間
+void benchmarkColorCorrection() {
+    LedColorMatrix matrices[BENCH_LEDS];
+    const float warm[9] = {1.0f, 0.05f, 0.0f, 0.0f, 0.92f, 0.0f, 0.0f, 0.02f, 0.85f};
+    for (int i = 0; i < BENCH_LEDS; i++) {
+        matrices[i] = (i & 1) ? LedColorMatrix::fromFloats(warm) : LedColorMatrix::identity();
+    }
+    CRGB corrected[BENCH_LEDS];
+
+    unsigned long start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        for (int j = 0; j < BENCH_LEDS; j++) {
+            corrected[j] = matrices[j].apply(benchLeds[j]);
+        }
+    }
+    printResult("Color correction pass", micros() - start, BENCH_ITERATIONS);
+}
+
+// 面配置ごとの描画ループ: 面ごとに色相をずらして塗る（RainbowPatternと同じ処理）
+struct BenchHueRingOp {
+    BenchHueRingOp(CRGB* leds, uint8_t baseHue) : leds(leds), baseHue(baseHue) {}
+    template <typename Layout>
+    void operator()(const Layout& layout) const {
+        for (int i = 0; i < layout.faceCount(); i++) {
+            layout.setFace(leds, i, CHSV(baseHue + i * 256 / layout.faceCount(), 255, 255));
+        }
+    }
+    CRGB* leds;
+    uint8_t baseHue;
+};
+
+// 面配置: コンパイル時に展開した形状（dispatchFaceLayout）と実行時版を比べる
+void benchmarkFaceLayout(int numFaces) {
+    // 最適化で面数が定数にならないようにする（実機では実行時の設定値）
+    volatile int faces = numFaces;
+    char name[48];
+
+    unsigned long start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        BenchHueRingOp op(benchLeds, i);
+        dispatchFaceLayout(BENCH_LEDS, LED_ADDRESS_OFFSET, faces, op);
+    }
+    snprintf(name, sizeof(name), "Face loop static (%d faces)", numFaces);
+    printResult(name, micros() - start, BENCH_ITERATIONS);
+
+    start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        BenchHueRingOp op(benchLeds, i);
+        op(DynamicFaceLayout(faces, 2, LED_ADDRESS_OFFSET, BENCH_LEDS));
+    }
+    snprintf(name, sizeof(name), "Face loop runtime (%d faces)", numFaces);
+    printResult(name, micros() - start, BENCH_ITERATIONS);
+}
+
+// 再生状態のスナップショット: 保存と復元の時間・サイズと、復元した状態が元と同じ描画になるか
+void benchmarkSnapshot(const char* patternName) {
+    int index = LedPatternRegistry::findByName(patternName);
+    LedPattern* pattern = LedPatternRegistry::create(index);
+    if (pattern == nullptr) return;
+
+    LedPatternInstance original;
+    original.setSeed(BENCH_SEED);
+    original.attach(pattern);
+    for (int i = 0; i < 100; i++) {
+        original.runFrame(benchLeds, BENCH_LEDS, LED_ADDRESS_OFFSET, BENCH_FACES);
+        delay(1);
+    }
+
+    std::vector<uint8_t> snapshot;
+    unsigned long start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        snapshot.clear();
+        LedSnapshotWriter out(snapshot);
+        original.save(out, millis());
+    }
+    unsigned long saveUs = micros() - start;
+
+    LedPatternInstance restored;
+    restored.attach(pattern);
+    bool ok = true;
+    start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        LedSnapshotReader in(snapshot.data(), snapshot.size());
+        ok = restored.restore(in, millis(), BENCH_FACES) && ok;
+    }
+    unsigned long restoreUs = micros() - start;
+
+    // 同じ時刻で1フレームずつ描いて比べる（炎など時刻で進むパターンは多少ずれうる）
+    CRGB a[BENCH_LEDS];
+    CRGB b[BENCH_LEDS];
+    fill_solid(a, BENCH_LEDS, CRGB::Black);
+    fill_solid(b, BENCH_LEDS, CRGB::Black);
+    original.runFrame(a, BENCH_LEDS, LED_ADDRESS_OFFSET, BENCH_FACES);
+    restored.runFrame(b, BENCH_LEDS, LED_ADDRESS_OFFSET, BENCH_FACES);
+    bool same = memcmp(a, b, sizeof(a)) == 0;
+
+    Serial.printf("Snapshot %-16s %4u bytes, save %.2f us, restore %.2f us, %s\n",
+                  patternName, (unsigned)snapshot.size(),
+                  (float)saveUs / BENCH_ITERATIONS, (float)restoreUs / BENCH_ITERATIONS,
+                  !ok ? "restore failed" : (same ? "identical frame" : "frame differs"));
+
+    original.attach(nullptr);
+    restored.attach(nullptr);
+    delete pattern;
+}
+
+// JSONパターンの従来の解釈実行（IRへの変換前の描画処理をそのまま残したもの。比較用）
+void interpretStep(CRGB* leds, int numLeds, int ledOffset, int numFaces, const PatternStep& step,
+                   const GlobalParameters& params, LedRandom& random) {
+    std::vector<int> selectedFaces;
+    if (step.hasFaces) {
+        selectedFaces = step.faces;
+    } else {
+        selectedFaces = step.faceSelection.selectFaces(numFaces, random);
+    }
+
+    CRGB color;
+    if (step.colorHSV.h.getMin() != 0 || step.colorHSV.s.getMin() != 0 || step.colorHSV.v.getMin() != 0) {
+        color = step.colorHSV.getColor(random);
+    } else {
+        color = params.defaultColor.getColor(random);
+    }
+
+    for (int i = 0; i < numFaces; i++) {
+        int idx1 = ledOffset + (i * 2);
+        int idx2 = ledOffset + (i * 2) + 1;
+        bool isSelected = false;
+        for (int face : selectedFaces) {
+            if (face == i) {
+                isSelected = true;
+                break;
+            }
+        }
+        leds[idx1] = isSelected ? color : CRGB(CRGB::Black);
+        leds[idx2] = isSelected ? color : CRGB(CRGB::Black);
+    }
+}
+
+// JSONパターンのステップ描画: 従来の解釈実行とロード時に変換したIRを比べる
+void benchmarkJsonStep(const char* label, const char* stepJson) {
+    DynamicJsonDocument doc(1024);
+    deserializeJson(doc, stepJson);
+    PatternStep step;
+    step.fromJson(doc.as<JsonObject>());
+    GlobalParameters params;
+    std::vector<LedExpression> expressions;
+    JsonCompiledStep compiled = JsonCompiledStep::compile(step, params, expressions);
+    std::vector<JsonCompiledPalette> palettes;
+    char name[48];
+
+    LedRandom random = LedRandom::withSeed(BENCH_SEED);
+    unsigned long start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        interpretStep(benchLeds, BENCH_LEDS, LED_ADDRESS_OFFSET, BENCH_FACES, step, params, random);
+    }
+    snprintf(name, sizeof(name), "JSON step interpreted (%s)", label);
+    printResult(name, micros() - start, BENCH_ITERATIONS);
+
+    random.seed(BENCH_SEED);
+    start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        compiled.render(benchLeds, BENCH_LEDS, LED_ADDRESS_OFFSET, BENCH_FACES, palettes, expressions, 0, 0, 0, random);
+    }
+    snprintf(name, sizeof(name), "JSON step compiled (%s)", label);
+    printResult(name, micros() - start, BENCH_ITERATIONS);
+}
+
+// 色を補間するステップの1フレームの描画（進み具合を毎回変えて、曲線ごとの処理時間を見る）
+void benchmarkJsonTween(const char* easing) {
+    char stepJson[192];
+    snprintf(stepJson, sizeof(stepJson),
+             "{\"faceSelection\": {\"mode\": \"all\"}, \"colorHSV\": {\"h\": 0, \"s\": 255, \"v\": 0}, "
+             "\"tween\": {\"to\": {\"h\": 0, \"s\": 255, \"v\": 255}, \"easing\": \"%s\"}}", easing);
+    DynamicJsonDocument doc(1024);
+    deserializeJson(doc, stepJson);
+    PatternStep step;
+    step.fromJson(doc.as<JsonObject>());
+    std::vector<LedExpression> expressions;
+    JsonCompiledStep compiled = JsonCompiledStep::compile(step, GlobalParameters(), expressions);
+    std::vector<JsonCompiledPalette> palettes;
+    char name[48];
+
+    LedRandom random = LedRandom::withSeed(BENCH_SEED);
+    unsigned long start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        compiled.render(benchLeds, BENCH_LEDS, LED_ADDRESS_OFFSET, BENCH_FACES, palettes, expressions, 0, 0,
+                        (uint16_t)(i * 97), random);
+    }
+    snprintf(name, sizeof(name), "JSON step tween (%s)", easing);
+    printResult(name, micros() - start, BENCH_ITERATIONS);
+}
+
+// 色の式: 1回の評価の時間（ns）と、全面の色を式で決めるステップの1フレームの描画
+void benchmarkJsonExpression(const char* source) {
+    LedExpression expression;
+    String error;
+    if (!expression.compile(source, error)) {
+        Serial.println("Expression benchmark: " + error);
+        return;
+    }
+    float vars[LedExpression::VAR_COUNT];
+    LedExpression::loadFrameInputs(vars, 0, 0);
+    const int evaluations = BENCH_ITERATIONS * BENCH_FACES * 2;
+    volatile float sink = 0;
+    unsigned long start = micros();
+    for (int i = 0; i < evaluations; i++) {
+        vars[LedExpression::VAR_T] = i;
+        vars[LedExpression::VAR_LED] = i % (BENCH_FACES * 2);
+        sink = sink + expression.evaluate(vars);
+    }
+    unsigned long elapsed = micros() - start;
+    Serial.printf("%-32s %8.1f ns/eval (%u ops)\n", source, elapsed * 1000.0f / evaluations,
+                  (unsigned)expression.getInstructionCount());
+
+    String stepJson = String("{\"faceSelection\": {\"mode\": \"all\"}, \"colorHSV\": {\"h\": \"") + source +
+                      "\", \"s\": 255, \"v\": 255}}";
+    DynamicJsonDocument doc(1024);
+    deserializeJson(doc, stepJson);
+    PatternStep step;
+    step.fromJson(doc.as<JsonObject>());
+    std::vector<LedExpression> expressions;
+    JsonCompiledStep compiled = JsonCompiledStep::compile(step, GlobalParameters(), expressions);
+    std::vector<JsonCompiledPalette> palettes;
+    LedRandom random = LedRandom::withSeed(BENCH_SEED);
+    start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        compiled.render(benchLeds, BENCH_LEDS, LED_ADDRESS_OFFSET, BENCH_FACES, palettes, expressions, 0, i * 33, 0, random);
+    }
+    printResult("JSON step expression hue", micros() - start, BENCH_ITERATIONS);
+}
+
+// 位置の移動: stepCountステップの固定長パターンで、ランダムな位置に移動して1フレーム描く時間
+// （ステップは終了時刻の表の二分探索で求めるので、ステップ数が増えても時間はほぼ変わらないはず）
+void benchmarkJsonSeek(int stepCount) {
+    String json = "{\"name\": \"Seek\", \"type\": \"custom\", \"parameters\": {\"loop\": true}, \"steps\": [";
+    for (int i = 0; i < stepCount; i++) {
+        json += String(i > 0 ? "," : "") + "{\"faces\": [" + String(i % BENCH_FACES) + "], \"duration\": " + String(20 + i % 7) + "}";
+    }
+    json += "]}";
+    DynamicJsonDocument doc(JSON_PATTERN_DOC_CAPACITY * 4);
+    deserializeJson(doc, json);
+    JsonPatternManager manager;
+    JsonLedPattern* pattern = manager.compilePattern(doc.as<JsonObject>());
+    if (pattern == nullptr || pattern->getTimelineLength() == 0) {
+        Serial.println("Seek benchmark: pattern is not seekable");
+        delete pattern;
+        return;
+    }
+
+    LedPatternState state;
+    state.reset(BENCH_SEED);
+    LedRandom random = LedRandom::withSeed(BENCH_SEED);
+    char name[48];
+    unsigned long start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        pattern->seek(state, random.below(pattern->getTimelineLength() * 4));
+        pattern->runSingleFrame(state, benchLeds, BENCH_LEDS, LED_ADDRESS_OFFSET, BENCH_FACES);
+    }
+    snprintf(name, sizeof(name), "JSON seek + frame (%d steps)", stepCount);
+    printResult(name, micros() - start, BENCH_ITERATIONS);
+    delete pattern;
+}
+
+// 同梱のパターン（SPIFFSの/leds/*.json）の読み込み: JSONの解析とパックの読み込みの時間とヒープの使用量
+// （dataフォルダをアップロードしてから実行する）
+void benchmarkPatternLoad() {
+    if (!SPIFFS.begin(true)) {
+        Serial.println("SPIFFS mount failed");
+        return;
+    }
+
+    // ファイルの読み込み時間を含めないよう、先にメモリに読んでおく
+    std::vector<String> sources;
+    size_t jsonBytes = 0;
+    File root = SPIFFS.open("/leds");
+    for (File file = root.openNextFile(); file; file = root.openNextFile()) {
+        if (String(file.name()).endsWith(".json")) {
+            sources.push_back(file.readString());
+            jsonBytes += sources.back().length();
+        }
+    }
+
+    // JSONを解析してIRに変換（起動時の従来の処理）
+    JsonPatternManager* parsed = new JsonPatternManager();
+    uint32_t heapBefore = ESP.getFreeHeap();
+    unsigned long start = micros();
+    for (const String& source : sources) {
+        DynamicJsonDocument doc(JSON_PATTERN_DOC_CAPACITY);
+        deserializeJson(doc, source);
+        JsonLedPattern* pattern = parsed->compilePattern(doc.as<JsonObject>());
+        if (pattern) parsed->putPattern(pattern);
+    }
+    unsigned long parseUs = micros() - start;
+    uint32_t parsedHeap = heapBefore - ESP.getFreeHeap();
+
+    std::vector<uint8_t> pack;
+    JsonPatternPack::write(*parsed, pack);
+
+    // パックから読み込み
+    JsonPatternManager* loaded = new JsonPatternManager();
+    heapBefore = ESP.getFreeHeap();
+    start = micros();
+    JsonPatternPack::read(pack.data(), pack.size(), *loaded);
+    unsigned long packUs = micros() - start;
+    uint32_t loadedHeap = heapBefore - ESP.getFreeHeap();
+
+    Serial.printf("Pattern library: %d patterns, JSON %u bytes, pack %u bytes\n",
+                  parsed->getPatternCount(), (unsigned)jsonBytes, (unsigned)pack.size());
+    Serial.printf("Load time: JSON %lu us, pack %lu us\n", parseUs, packUs);
+    Serial.printf("Library heap: JSON %u bytes, pack %u bytes\n", (unsigned)parsedHeap, (unsigned)loadedHeap);
+
+    delete parsed;
+    delete loaded;
+}
+
+// 段差の比較: 残像のように毎フレーム20/255ずつ減衰させたとき黒になるまでに通る段数
+// （多いほど尾が滑らかに消える）と、赤→青のクロスフェードの中間点の光量（端の光量に対する割合）
+// 実機での数値の表示用。合否はホストのtools/lumilightで確かめる
+void compareBanding() {
+    CRGB gamma(255, 255, 255);
+    CRGB linear(255, 255, 255);
+    int gammaSteps = 0;
+    int linearSteps = 0;
+    while (gamma.r > 0) {
+        gamma.fadeToBlackBy(20);
+        gammaSteps++;
+    }
+    while (linear.r > 0) {
+        LinearLight::scale(linear, 255 - 20);
+        linearSteps++;
+    }
+    Serial.printf("Fade steps to black: gamma %d, linear %d\n", gammaSteps, linearSteps);
+
+    CRGB red(255, 0, 0);
+    CRGB blue(0, 0, 255);
+    CRGB midGamma = blend(red, blue, 128);
+    CRGB midLinear = LinearLight::blend(red, blue, 128);
+    uint32_t ends = LinearLight::toLinear(255);
+    uint32_t gammaLight = (uint32_t)LinearLight::toLinear(midGamma.r) + LinearLight::toLinear(midGamma.b);
+    uint32_t linearLight = (uint32_t)LinearLight::toLinear(midLinear.r) + LinearLight::toLinear(midLinear.b);
+    Serial.printf("Crossfade midpoint light: gamma %u%%, linear %u%%\n",
+                  (unsigned)(gammaLight * 100 / ends), (unsigned)(linearLight * 100 / ends));
+}
+
+void setup() {
+    // M5Stackの初期化
+    auto cfg = M5.config();
+    M5.begin(cfg);
+
+    // シリアル通信の初期化
+    Serial.begin(115200);
+    Serial.println("LED Engine Benchmark");
+    Serial.printf("Frame budget at 120fps: %d us\n", 1000000 / 120);
+
+    benchmarkParticles(16);
+    benchmarkParticles(128);
+    benchmarkParticles(512);
+
+    benchmarkFire(8);
+    benchmarkFire(20);
+
+    benchmarkRandom();
+
+    benchmarkLinearLight();
+    compareBanding();
+
+    benchmarkColorCorrection();
+
+    benchmarkFaceLayout(8);
+    benchmarkFaceLayout(20);
+
+    benchmarkSnapshot("Twinkle");
+    benchmarkSnapshot("FireFlicker");
+
+    benchmarkJsonStep("fixed faces", "{\"faces\": [0, 2, 4, 6, 8, 10], \"colorHSV\": {\"h\": 160, \"s\": 255, \"v\": 255}}");
+    benchmarkJsonStep("all faces", "{\"faceSelection\": {\"mode\": \"all\"}, \"colorHSV\": {\"h\": 32, \"s\": 200, \"v\": 255}}");
+    benchmarkJsonStep("random 5", "{\"faceSelection\": {\"mode\": \"random\", \"range\": {\"min\": 0, \"max\": 19}, \"count\": 5}, "
+                      "\"colorHSV\": {\"h\": {\"min\": 0, \"max\": 255}, \"s\": 255, \"v\": 255}}");
+    benchmarkJsonTween("linear");
+    benchmarkJsonTween("cubic");
+    benchmarkJsonExpression("t*0.1 + face*32");
+    benchmarkJsonExpression("128 + sin(t*0.002 + led*0.5)*band0/2");
+    benchmarkJsonExpression("-(face*3 + face*5 + face*7 + t)");
+    benchmarkJsonExpression("face*7 - t*t");
+    benchmarkJsonSeek(8);
+    benchmarkJsonSeek(256);
+
+    benchmarkPatternLoad();
+}
+
+void loop() {
+    delay(1000);
+}
+#endif
@@ -26,6 +26,7 @@ LumiHomeActivity::LumiHomeActivity()
       m_currentMode(MODE_TAP),
       m_selectedPatternIndex(0),
       m_isPatternPlaying(false),
+      m_snapshotGeneration(0),
       m_currentHue(0),
       m_currentSaturation(255),
       m_currentValueBrightness(255),
@@ -324,6 +325,7 @@ void LumiHomeActivity::initialize(LEDManager* ledManager, FaceDetector* faceDete
             
             // マイク停止
             m_micManager->stopTask();
+            m_ledManager->clearAudioInput();
             
             // 全てのLEDを消灯
             m_ledManager->resetAllLeds();
@@ -541,6 +543,15 @@ bool LumiHomeActivity::onResume() {
     if (!Activity::onResume()) {
         return false;
     }
+    
+    // 離れている間に再生が暗黙に止められていたら（パターンの読み込み直しなど）、離れる前の続きから再開する
+    // （止められていなければそのまま再生を続ける。明示的に止めたり別のパターンを選んだりした場合は戻さない）
+    if (!m_patternSnapshot.empty()) {
+        if (!m_ledManager->isPatternRunning() && m_ledManager->getPlaybackGeneration() == m_snapshotGeneration) {
+            m_ledManager->resumePattern(m_patternSnapshot);
+        }
+        m_patternSnapshot.clear();
+    }
 
     draw();
     
@@ -548,6 +559,12 @@ bool LumiHomeActivity::onResume() {
 }
 
 void LumiHomeActivity::onPause() {
+    // 設定画面・スクリーンセーバーの間もパターンは再生を続ける。
+    // 移った先で止められた場合に戻って再開できるよう、再生状態だけを残しておく
+    if (m_ledManager != nullptr && m_ledManager->isPatternRunning()) {
+        m_ledManager->snapshotPattern(m_patternSnapshot);
+        m_snapshotGeneration = m_ledManager->getPlaybackGeneration();
+    }
     Activity::onPause();
 }
 
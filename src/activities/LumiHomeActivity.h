@@ -95,6 +95,9 @@ private:
     OperationMode m_currentMode;
     int m_selectedPatternIndex;
     bool m_isPatternPlaying;
+    // 画面を離れたときのパターンの再生状態（戻ったときに再生が止められていればここから再開する）
+    std::vector<uint8_t> m_patternSnapshot;
+    uint32_t m_snapshotGeneration;  // スナップショットを取ったときの再生の世代
     CRGB m_currentLedColor;
     uint8_t m_currentHue;
     uint8_t m_currentSaturation;
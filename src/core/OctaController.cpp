@@ -58,6 +58,15 @@ OctaController::OctaController() {
                 dominantBand = i;
             }
         }
+        
+        // JSONパターンのパレット（"index": "audio"）に音量を反映
+        ledManager->setAudioLevel(constrain(map(maxLevel, 0, 20000, 0, 255), 0, 255));
+        // JSONパターンの式（band0〜band7、beat）に帯域ごとの音量とBPMを反映
+        uint8_t bandBytes[8];
+        for (int i = 0; i < 8; i++) {
+            bandBytes[i] = constrain(map(bandLevels[i], 0, 20000, 0, 255), 0, 255);
+        }
+        ledManager->setAudioBands(bandBytes, bpm > 0 ? bpm : 0);
         // int centerFace = NUM_FACES / 2;
         // CHSV dominantColor = CHSV(0, 0, constrain(map(maxLevel, 0, 100, 0, 255), 0, 255));
         // ledManager->lightFace(mapViewFaceToLedFace(centerFace), dominantColor);
@@ -168,6 +177,7 @@ void OctaController::setup() {
             Serial.println("Stopping Listen mode before transition");
             lumiHomeActivity->setOperationMode(LumiHomeActivity::MODE_TAP);
             micManager->stopTask();
+            ledManager->clearAudioInput();
         }
         
         activityManager->startActivity("networksettings");
@@ -186,6 +196,7 @@ void OctaController::setup() {
             Serial.println("Stopping Listen mode before transition");
             lumiHomeActivity->setOperationMode(LumiHomeActivity::MODE_TAP);
             micManager->stopTask();
+            ledManager->clearAudioInput();
         }
         
         activityManager->startActivity("settings");
@@ -235,8 +246,8 @@ void OctaController::setup() {
     // 設定の読み込み
     faceDetector->loadFaces();
     
-    // JSONパターンの読み込み
-    if (ledManager->loadJsonPatternsFromDirectory("/leds")) {
+    // JSONパターンの読み込み（コンパイル済みのパックがあればそれを使い、なければJSONを解析する）
+    if (ledManager->loadJsonPatternPack("/leds.lpk") || ledManager->loadJsonPatternsFromDirectory("/leds")) {
         Serial.println("JSON patterns loaded successfully");
         Serial.print("Pattern count: ");
         Serial.println(ledManager->getJsonPatternCount());
@@ -265,6 +276,10 @@ void OctaController::loop() {
     // ネットワーク接続を維持
     networkManager->update();
     
+    // IMUを読み、向きに追従するLEDパターン向けに重力方向を公開
+    imuSensor->update();
+    WorldOrientation::getInstance().publishGravity(imuSensor->getAccX(), imuSensor->getAccY(), imuSensor->getAccZ());
+    
     // 現在のActivityがLumiHomeActivityの場合
     if (activityManager->getCurrentActivity() == lumiHomeActivity) {
         processLumiHomeState();
@@ -343,9 +358,6 @@ void OctaController::loop() {
     // 状態の処理
     stateManager->processCurrentState();
     
-    // IMUセンサーの更新
-    imuSensor->update();
-    
     // 状態に合わせた処理
     switch (stateManager->getCurrentStateInfo().mainState) {
         case STATE_DETECTION:
@@ -0,0 +1,58 @@
+#ifndef EASING_H
+#define EASING_H
+
+#include <stdint.h>
+
+// 補間の進み具合を曲げるイージング曲線（固定小数点。整数演算のみ）
+// 進み具合は0-65535（0.16の固定小数点）で受け取り、同じ範囲で返す。
+struct Easing {
+    enum Curve : uint8_t {
+        LINEAR,
+        EASE_IN,        // 2次: ゆっくり始まる
+        EASE_OUT,       // 2次: ゆっくり終わる
+        EASE_IN_OUT,    // 2次: ゆっくり始まってゆっくり終わる
+        CUBIC           // 3次のease-in-out（EASE_IN_OUTより両端が緩やか）
+    };
+
+    // 経過時間と長さから進み具合（0-65535）を求める（長さ0は終わったものとする）
+    static uint16_t progress(uint32_t elapsed, uint32_t length) {
+        if (length == 0 || elapsed >= length) {
+            return 0xFFFF;
+        }
+        return (uint16_t)(((uint64_t)elapsed << 16) / length);
+    }
+
+    static uint16_t apply(Curve curve, uint16_t t) {
+        switch (curve) {
+            case EASE_IN:
+                return square(t);
+            case EASE_OUT:
+                return 0xFFFF - square(0xFFFF - t);
+            case EASE_IN_OUT:
+                // 前半は2t²、後半は1-2(1-t)²
+                return t < 0x8000 ? (uint16_t)min16((uint32_t)square(t) * 2)
+                                  : (uint16_t)(0xFFFF - min16((uint32_t)square(0xFFFF - t) * 2));
+            case CUBIC:
+                // 前半は4t³、後半は1-4(1-t)³
+                return t < 0x8000 ? (uint16_t)min16((uint32_t)cube(t) * 4)
+                                  : (uint16_t)(0xFFFF - min16((uint32_t)cube(0xFFFF - t) * 4));
+            case LINEAR:
+            default:
+                return t;
+        }
+    }
+
+private:
+    // 切り上げて、0と65535がそのまま端点に写るようにする
+    static uint16_t square(uint16_t t) {
+        return (uint16_t)(((uint32_t)t * t + 0xFFFF) >> 16);
+    }
+    static uint16_t cube(uint16_t t) {
+        return (uint16_t)(((uint32_t)square(t) * t + 0xFFFF) >> 16);
+    }
+    static uint32_t min16(uint32_t value) {
+        return value > 0xFFFF ? 0xFFFF : value;
+    }
+};
+
+#endif // EASING_H
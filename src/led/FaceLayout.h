@@ -0,0 +1,98 @@
+#ifndef FACE_LAYOUT_H
+#define FACE_LAYOUT_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+// 面とLEDの対応（面iのLEDは offset + i * ledsPerFace から ledsPerFace 個）
+// 描画ループはこの型をテンプレート引数に取って書く。
+// StaticFaceLayoutは面数・面ごとのLED数・オフセットがコンパイル時に決まるので、
+// 面ごとのLEDのループは展開され、添字の計算は定数に畳み込まれる。
+// DynamicFaceLayoutは同じインターフェースの実行時版（任意の形状用）。
+
+// コンパイル時に決まる面配置
+template <int FACES, int LEDS_PER_FACE, int OFFSET>
+struct StaticFaceLayout {
+    static const int kFaces = FACES;
+    static const int kLedsPerFace = LEDS_PER_FACE;
+    static const int kOffset = OFFSET;
+    // 必要なLEDバッファの長さ
+    static const int kRequiredLeds = OFFSET + FACES * LEDS_PER_FACE;
+
+    int faceCount() const { return FACES; }
+    int ledsPerFace() const { return LEDS_PER_FACE; }
+    int offset() const { return OFFSET; }
+    int firstLed(int face) const { return OFFSET + face * LEDS_PER_FACE; }
+
+    // 面のLEDをすべて同じ色にする
+    void setFace(CRGB* leds, int face, const CRGB& color) const {
+        CRGB* first = leds + OFFSET + face * LEDS_PER_FACE;
+        for (int k = 0; k < LEDS_PER_FACE; k++) {
+            first[k] = color;
+        }
+    }
+
+    // 面のLEDをsrcからdstへコピーする
+    void copyFace(CRGB* dst, const CRGB* src, int face) const {
+        int first = OFFSET + face * LEDS_PER_FACE;
+        for (int k = 0; k < LEDS_PER_FACE; k++) {
+            dst[first + k] = src[first + k];
+        }
+    }
+};
+
+// 実行時に決まる面配置（LEDバッファに収まる面数に切り詰める）
+struct DynamicFaceLayout {
+    DynamicFaceLayout(int numFaces, int ledsPerFace, int ledOffset, int numLeds)
+        : m_faces(numFaces), m_ledsPerFace(ledsPerFace > 0 ? ledsPerFace : 1), m_offset(ledOffset) {
+        int fit = (numLeds - ledOffset) / m_ledsPerFace;
+        if (fit < 0) fit = 0;
+        if (m_faces > fit) m_faces = fit;
+    }
+
+    int faceCount() const { return m_faces; }
+    int ledsPerFace() const { return m_ledsPerFace; }
+    int offset() const { return m_offset; }
+    int firstLed(int face) const { return m_offset + face * m_ledsPerFace; }
+
+    void setFace(CRGB* leds, int face, const CRGB& color) const {
+        CRGB* first = leds + m_offset + face * m_ledsPerFace;
+        for (int k = 0; k < m_ledsPerFace; k++) {
+            first[k] = color;
+        }
+    }
+
+    void copyFace(CRGB* dst, const CRGB* src, int face) const {
+        int first = m_offset + face * m_ledsPerFace;
+        for (int k = 0; k < m_ledsPerFace; k++) {
+            dst[first + k] = src[first + k];
+        }
+    }
+
+private:
+    int m_faces;
+    int m_ledsPerFace;
+    int m_offset;
+};
+
+// よく使う形状（どちらも面ごとに2LED、先頭1LEDは本体のLED）
+typedef StaticFaceLayout<8, 2, 1> OctagonFaceLayout;       // 八角形のリング（CoreS3の標準構成）
+typedef StaticFaceLayout<20, 2, 1> IcosahedronFaceLayout;  // 正二十面体
+
+// runFrameの引数に合う配置を選んでop(layout)を呼ぶ
+// opはテンプレートのoperator()を持つ関数オブジェクト（C++11なので汎用ラムダの代わり）。
+// 標準の形状に一致すれば専用の展開済みループ、それ以外は実行時版になる。
+template <typename Op>
+void dispatchFaceLayout(int numLeds, int ledOffset, int numFaces, Op& op) {
+    if (numFaces == OctagonFaceLayout::kFaces && ledOffset == OctagonFaceLayout::kOffset &&
+        numLeds >= OctagonFaceLayout::kRequiredLeds) {
+        op(OctagonFaceLayout());
+    } else if (numFaces == IcosahedronFaceLayout::kFaces && ledOffset == IcosahedronFaceLayout::kOffset &&
+               numLeds >= IcosahedronFaceLayout::kRequiredLeds) {
+        op(IcosahedronFaceLayout());
+    } else {
+        op(DynamicFaceLayout(numFaces, 2, ledOffset, numLeds));
+    }
+}
+
+#endif // FACE_LAYOUT_H
@@ -0,0 +1,109 @@
+#include "FaceTopology.h"
+
+namespace {
+
+// 八角形のリング: 面iの隣は i-1 と i+1
+const uint8_t kOctagonOffsets[] = {0, 2, 4, 6, 8, 10, 12, 14, 16};
+const uint8_t kOctagonNeighbors[] = {
+    1, 7,   0, 2,   1, 3,   2, 4,   3, 5,   4, 6,   5, 7,   0, 6
+};
+
+// 正二十面体: IcosahedronView::faces で頂点を2つ共有する面
+const uint8_t kIcosahedronOffsets[] = {
+    0, 3, 6, 9, 12, 15, 18, 21, 24, 27, 30, 33, 36, 39, 42, 45, 48, 51, 54, 57, 60
+};
+const uint8_t kIcosahedronNeighbors[] = {
+     1,  4,  6,    0,  2,  5,    1,  3,  9,    2,  4,  8,    0,  3,  7,
+     1, 15, 19,    0, 15, 16,    4, 16, 17,    3, 17, 18,    2, 18, 19,
+    11, 14, 15,   10, 12, 16,   11, 13, 17,   12, 14, 18,   10, 13, 19,
+     5,  6, 10,    6,  7, 11,    7,  8, 12,    8,  9, 13,    5,  9, 14
+};
+
+} // namespace
+
+const FaceTopology& FaceTopology::octagon() {
+    static const FaceTopology topology("octagon", 8, kOctagonOffsets, kOctagonNeighbors);
+    return topology;
+}
+
+const FaceTopology& FaceTopology::icosahedron() {
+    static const FaceTopology topology("icosahedron", 20, kIcosahedronOffsets, kIcosahedronNeighbors);
+    return topology;
+}
+
+const FaceTopology& FaceTopology::forFaceCount(int numFaces) {
+    if (numFaces == 20) {
+        return icosahedron();
+    }
+    return octagon();
+}
+
+bool FaceTopology::isAdjacent(int a, int b) const {
+    for (const uint8_t* n = neighborsBegin(a); n != neighborsEnd(a); ++n) {
+        if (*n == b) return true;
+    }
+    return false;
+}
+
+int FaceTopology::computeDistances(int source, uint8_t* distances) const {
+    for (int i = 0; i < m_faceCount; i++) {
+        distances[i] = FACE_DISTANCE_UNREACHABLE;
+    }
+    if (source < 0 || source >= m_faceCount) {
+        return 0;
+    }
+
+    // 幅優先探索（キューは面数分の固定長配列）
+    uint8_t queue[FACE_TOPOLOGY_MAX_FACES];
+    int head = 0;
+    int tail = 0;
+    int maxDistance = 0;
+    distances[source] = 0;
+    queue[tail++] = source;
+
+    while (head < tail) {
+        uint8_t face = queue[head++];
+        uint8_t next = distances[face] + 1;
+        for (const uint8_t* n = neighborsBegin(face); n != neighborsEnd(face); ++n) {
+            if (distances[*n] != FACE_DISTANCE_UNREACHABLE) continue;
+            distances[*n] = next;
+            if (next > maxDistance) maxDistance = next;
+            queue[tail++] = *n;
+        }
+    }
+    return maxDistance;
+}
+
+bool FaceTopology::extendTour(uint8_t* path, int length, uint32_t visited) const {
+    int last = path[length - 1];
+    if (length == m_faceCount) {
+        return isAdjacent(last, path[0]);
+    }
+
+    for (const uint8_t* n = neighborsBegin(last); n != neighborsEnd(last); ++n) {
+        uint32_t bit = 1UL << *n;
+        if (visited & bit) continue;
+        path[length] = *n;
+        if (extendTour(path, length + 1, visited | bit)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int FaceTopology::buildTour(uint8_t* path, int maxLength) const {
+    if (maxLength < m_faceCount) {
+        return 0;
+    }
+
+    // 面数が少ないのでバックトラックで十分（正二十面体でも一瞬で見つかる）
+    path[0] = 0;
+    if (m_faceCount > 0 && extendTour(path, 1, 1UL)) {
+        return m_faceCount;
+    }
+
+    for (int i = 0; i < m_faceCount; i++) {
+        path[i] = i;
+    }
+    return m_faceCount;
+}
@@ -0,0 +1,54 @@
+#ifndef FACE_TOPOLOGY_H
+#define FACE_TOPOLOGY_H
+
+#include <stdint.h>
+
+// 扱える最大面数（訪問済みの面を32ビットのマスクで管理するため）
+#define FACE_TOPOLOGY_MAX_FACES 32
+// 到達できない面の距離
+#define FACE_DISTANCE_UNREACHABLE 0xFF
+
+// 面の隣接関係（辺を共有する面）を表すグラフ
+// 形状ごとに事前計算した表をCSR形式（面ごとの開始位置 + 隣接面の連続配列）で
+// フラッシュに置き、実行中のメモリ確保なしで隣接面を順に走査できる。
+// 面番号はLEDの面番号（LED0の面が0）。
+class FaceTopology {
+public:
+    FaceTopology(const char* name, uint8_t faceCount, const uint8_t* offsets, const uint8_t* neighbors)
+        : m_name(name), m_faceCount(faceCount), m_offsets(offsets), m_neighbors(neighbors) {}
+
+    // 八角形のリング（8面、各面の隣は両隣の2面）
+    static const FaceTopology& octagon();
+    // 正二十面体（20面、各面の隣は3面。IcosahedronViewの面番号と同じ）
+    static const FaceTopology& icosahedron();
+    // 面数に合う形状を返す（20面なら正二十面体、それ以外は八角形のリング）
+    static const FaceTopology& forFaceCount(int numFaces);
+
+    const char* getName() const { return m_name; }
+    int getFaceCount() const { return m_faceCount; }
+
+    // 隣接面の数と走査範囲
+    int getDegree(int face) const { return m_offsets[face + 1] - m_offsets[face]; }
+    const uint8_t* neighborsBegin(int face) const { return m_neighbors + m_offsets[face]; }
+    const uint8_t* neighborsEnd(int face) const { return m_neighbors + m_offsets[face + 1]; }
+
+    bool isAdjacent(int a, int b) const;
+
+    // 面sourceからの隣接面づたいの距離（辺を渡る回数）を幅優先探索で求める
+    // distancesには面数分の領域が必要。戻り値は最大距離
+    int computeDistances(int source, uint8_t* distances) const;
+
+    // 隣接面づたいに全面を1回ずつ巡って面0に戻る順路（ハミルトン閉路）を求める
+    // 見つからない場合は面番号順を返す。戻り値は順路の長さ
+    int buildTour(uint8_t* path, int maxLength) const;
+
+private:
+    bool extendTour(uint8_t* path, int length, uint32_t visited) const;
+
+    const char* m_name;
+    uint8_t m_faceCount;
+    const uint8_t* m_offsets;    // 面ごとの隣接面の開始位置（面数 + 1 個）
+    const uint8_t* m_neighbors;  // 隣接面（面ごとに昇順）
+};
+
+#endif // FACE_TOPOLOGY_H
@@ -0,0 +1,148 @@
+#include "FireSimulation.h"
+
+FireSimulation::FireSimulation()
+    : m_heat(nullptr), m_parent(nullptr), m_order(nullptr),
+      m_cellCount(0), m_capacity(0),
+      m_cooling(55), m_sparking(120), m_sparkCells(1),
+      m_palette(HeatColors_p) {
+}
+
+FireSimulation::~FireSimulation() {
+    delete[] m_heat;
+    delete[] m_parent;
+    delete[] m_order;
+}
+
+void FireSimulation::allocate(int cellCount) {
+    if (cellCount <= m_capacity) {
+        m_cellCount = cellCount;
+        return;
+    }
+
+    delete[] m_heat;
+    delete[] m_parent;
+    delete[] m_order;
+    m_heat = new uint8_t[cellCount];
+    m_parent = new uint8_t[cellCount];
+    m_order = new uint8_t[cellCount];
+    m_capacity = cellCount;
+    m_cellCount = cellCount;
+}
+
+void FireSimulation::begin(const FaceTopology& topology, int ledsPerFace, int baseFace) {
+    int numFaces = topology.getFaceCount();
+    int cellCount = numFaces * ledsPerFace;
+    if (cellCount <= 0 || cellCount > 255) {
+        m_cellCount = 0;
+        return;
+    }
+
+    allocate(cellCount);
+    memset(m_heat, 0, m_cellCount);
+    baseFace = constrain(baseFace, 0, numFaces - 1);
+
+    // 隣接面づたいに火元からの距離を求め、各セルの上流を決める
+    // 面の中ではLED0が下、LED1以降が上。面のLED0は火元に1つ近い隣接面の最上段につながる
+    uint8_t distances[FACE_TOPOLOGY_MAX_FACES];
+    int maxDistance = topology.computeDistances(baseFace, distances);
+    int orderIndex = 0;
+    for (int distance = maxDistance; distance >= 0; distance--) {
+        for (int face = 0; face < numFaces; face++) {
+            if (distances[face] != distance) continue;
+
+            // 火元に1つ近い面（複数あれば番号の小さい面）
+            int towardBase = face;
+            for (const uint8_t* n = topology.neighborsBegin(face); n != topology.neighborsEnd(face); ++n) {
+                if (distances[*n] + 1 == distance) {
+                    towardBase = *n;
+                    break;
+                }
+            }
+
+            // 上段から順に登録（拡散は上から処理して上流の古い値を参照する）
+            for (int led = ledsPerFace - 1; led >= 0; led--) {
+                int cell = face * ledsPerFace + led;
+                if (led > 0) {
+                    m_parent[cell] = cell - 1;
+                } else if (towardBase != face) {
+                    m_parent[cell] = towardBase * ledsPerFace + (ledsPerFace - 1);
+                } else {
+                    m_parent[cell] = cell;
+                }
+                m_order[orderIndex++] = cell;
+            }
+        }
+    }
+
+    // 火元の面のLEDで火花を発生させる（処理順の末尾が火元の面）
+    m_sparkCells = ledsPerFace;
+}
+
+void FireSimulation::update(LedRandom& random) {
+    if (m_cellCount == 0) return;
+
+    // 1. 冷却（セル数が少ないほど1セルあたりの冷却を大きくする）
+    uint8_t maxCooling = ((m_cooling * 10) / m_cellCount) + 2;
+    for (int i = 0; i < m_cellCount; i++) {
+        m_heat[i] = qsub8(m_heat[i], random.next8(0, maxCooling));
+    }
+
+    // 2. 上方向への拡散（火元から遠いセルから、上流と上流の上流の加重平均）
+    for (int i = 0; i < m_cellCount; i++) {
+        uint8_t cell = m_order[i];
+        uint8_t parent = m_parent[cell];
+        if (parent == cell) continue;
+        uint8_t grandParent = m_parent[parent];
+        m_heat[cell] = (m_heat[parent] + m_heat[grandParent] + m_heat[grandParent]) / 3;
+    }
+
+    // 3. 火元付近でランダムに火花を発生
+    if (random.next8() < m_sparking) {
+        uint8_t spark = m_order[m_cellCount - 1 - random.next8(m_sparkCells)];
+        m_heat[spark] = qadd8(m_heat[spark], random.next8(160, 255));
+    }
+}
+
+void FireSimulation::render(CRGB* leds, int ledOffset) const {
+    for (int i = 0; i < m_cellCount; i++) {
+        // 最も熱い部分が白くなりすぎないよう240に抑える
+        leds[ledOffset + i] = ColorFromPalette(m_palette, scale8(m_heat[i], 240));
+    }
+}
+
+void FireSimulation::save(LedSnapshotWriter& out) const {
+    out.put8(m_cellCount);
+    out.put8(m_sparkCells);
+    out.put8(m_cooling);
+    out.put8(m_sparking);
+    out.putBytes(m_heat, m_cellCount);
+    out.putBytes(m_parent, m_cellCount);
+    out.putBytes(m_order, m_cellCount);
+}
+
+bool FireSimulation::load(LedSnapshotReader& in) {
+    int cellCount = in.get8();
+    uint8_t sparkCells = in.get8();
+    uint8_t cooling = in.get8();
+    uint8_t sparking = in.get8();
+    if (!in.ok() || (int)in.remaining() < cellCount * 3 || sparkCells > cellCount) {
+        return false;
+    }
+
+    allocate(cellCount);
+    in.getBytes(m_heat, cellCount);
+    in.getBytes(m_parent, cellCount);
+    in.getBytes(m_order, cellCount);
+
+    // 壊れたデータで範囲外を参照しないよう、セル番号を確かめる
+    for (int i = 0; i < cellCount; i++) {
+        if (m_parent[i] >= cellCount || m_order[i] >= cellCount) {
+            m_cellCount = 0;
+            return false;
+        }
+    }
+    m_sparkCells = sparkCells;
+    m_cooling = cooling;
+    m_sparking = sparking;
+    return true;
+}
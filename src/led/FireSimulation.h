@@ -0,0 +1,54 @@
+#ifndef FIRE_SIMULATION_H
+#define FIRE_SIMULATION_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include "FaceTopology.h"
+#include "LedRandom.h"
+#include "LedSnapshot.h"
+
+// 熱拡散による炎シミュレーション（Fire2012方式を面の配置に拡張）
+// LEDごとに熱量を持ち、冷却・上方向への拡散・火花の発生を繰り返して
+// ヒートパレットで色に変換する。整数演算のみで、フレーム中のメモリ確保は行わない。
+// 状態はLED1個あたり3バイト（熱量・上流セル・処理順）。
+class FireSimulation {
+public:
+    FireSimulation();
+    ~FireSimulation();
+
+    // セル（LED）の配置を構築する。LED数が変わらない限り再確保しない
+    // baseFace: 火元となる面（ここから隣接する面へ炎が登っていく）
+    void begin(const FaceTopology& topology, int ledsPerFace, int baseFace = 0);
+
+    // シミュレーションを1ステップ進める（冷却量と火花はrandomから引く）
+    void update(LedRandom& random);
+
+    // 熱量をパレットで色に変換してLEDバッファに書き込む
+    void render(CRGB* leds, int ledOffset) const;
+
+    // 冷却量（大きいほど炎が短い）と火花の発生確率（0-255）
+    void setCooling(uint8_t cooling) { m_cooling = cooling; }
+    void setSparking(uint8_t sparking) { m_sparking = sparking; }
+    void setPalette(const CRGBPalette16& palette) { m_palette = palette; }
+
+    int getCellCount() const { return m_cellCount; }
+
+    // セルの配置と熱量をスナップショットに書く／読む（パレットは書かない）
+    void save(LedSnapshotWriter& out) const;
+    bool load(LedSnapshotReader& in);
+
+private:
+    void allocate(int cellCount);
+
+    uint8_t* m_heat;     // セルごとの熱量
+    uint8_t* m_parent;   // 1つ下流（火元側）のセル。火元は自分自身
+    uint8_t* m_order;    // 拡散の処理順（火元から遠いセルから順に）
+    int m_cellCount;
+    int m_capacity;
+    uint8_t m_cooling;
+    uint8_t m_sparking;
+    uint8_t m_sparkCells; // 火花が発生する火元付近のセル数
+    CRGBPalette16 m_palette;
+};
+
+#endif // FIRE_SIMULATION_H
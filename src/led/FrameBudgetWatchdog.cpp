@@ -0,0 +1,61 @@
+#include "FrameBudgetWatchdog.h"
+
+namespace {
+
+// 段階を上げる条件: 超過が3フレーム以上続き、超過時間の累積が500msを超えたとき
+// （一瞬のスパイクでは上げない）
+const uint16_t kMinOverrunStreak = 3;
+const uint32_t kOverrunDebtLimitUs = 500000;
+
+} // namespace
+
+FrameBudgetWatchdog::FrameBudgetWatchdog() {
+    reset(33333);
+}
+
+void FrameBudgetWatchdog::reset(uint32_t budgetUs) {
+    m_budgetUs = budgetUs > 0 ? budgetUs : 1;
+    m_overrunDebtUs = 0;
+    m_overrunStreak = 0;
+    m_lastOverrunUs = 0;
+    m_stage = NORMAL;
+}
+
+bool FrameBudgetWatchdog::reportFrame(uint32_t frameUs) {
+    if (frameUs <= m_budgetUs) {
+        // 予算内のフレームでは余裕の分だけ累積を返済する
+        uint32_t slack = m_budgetUs - frameUs;
+        m_overrunDebtUs = m_overrunDebtUs > slack ? m_overrunDebtUs - slack : 0;
+        m_overrunStreak = 0;
+        return false;
+    }
+
+    m_lastOverrunUs = frameUs;
+    m_overrunDebtUs += frameUs - m_budgetUs;
+    if (m_overrunStreak < 0xFFFF) {
+        m_overrunStreak++;
+    }
+
+    if (m_stage >= BAKED) {
+        return false;
+    }
+    if (m_overrunStreak < kMinOverrunStreak || m_overrunDebtUs < kOverrunDebtLimitUs) {
+        return false;
+    }
+
+    // 次の段階へ（新しい段階の効果を見るため統計はやり直す）
+    m_stage = (Stage)(m_stage + 1);
+    m_overrunDebtUs = 0;
+    m_overrunStreak = 0;
+    return true;
+}
+
+const char* FrameBudgetWatchdog::getStageName(Stage stage) {
+    switch (stage) {
+        case NORMAL:          return "normal";
+        case NO_POST_FILTERS: return "no-post-filters";
+        case REDUCED_RATE:    return "reduced-rate";
+        case BAKED:           return "baked";
+        default:              return "unknown";
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef FRAME_BUDGET_WATCHDOG_H
+#define FRAME_BUDGET_WATCHDOG_H
+
+#include <Arduino.h>
+
+// フレーム予算の監視と段階的な品質低下
+// 描画タスクは毎フレームの処理時間を報告し、予算（目標フレーム時間）の超過が続いたら
+// 段階を1つずつ上げる。段階は同じ再生の間は戻さない（戻すとすぐに超過して振動するため）。
+class FrameBudgetWatchdog {
+public:
+    enum Stage : uint8_t {
+        NORMAL = 0,        // 通常
+        NO_POST_FILTERS,   // フェード・ブラーなどの後処理を止める
+        REDUCED_RATE,      // パターンの計算を2フレームに1回にする
+        BAKED              // 焼き込み済みのタイムラインを再生する
+    };
+
+    FrameBudgetWatchdog();
+
+    // 再生開始時に呼ぶ（段階と統計を初期化）
+    void reset(uint32_t budgetUs);
+
+    // 1フレームの処理時間（待機を除く）を報告する。段階が上がったらtrue
+    // パターンを計算したフレームだけを報告する（shouldRunLogic()がfalseの表示だけのフレームは含めない）
+    bool reportFrame(uint32_t frameUs);
+
+    Stage getStage() const { return m_stage; }
+    uint32_t getBudgetUs() const { return m_budgetUs; }
+    // 直近の予算超過フレームの処理時間
+    uint32_t getLastOverrunUs() const { return m_lastOverrunUs; }
+    // このフレームでパターンを計算するか（REDUCED_RATE以上では1フレームおき）
+    bool shouldRunLogic(uint32_t frameIndex) const { return m_stage < REDUCED_RATE || (frameIndex & 1) == 0; }
+
+    static const char* getStageName(Stage stage);
+
+private:
+    uint32_t m_budgetUs;
+    uint32_t m_overrunDebtUs;   // 超過時間の累積（予算内のフレームで減っていく）
+    uint16_t m_overrunStreak;   // 連続した超過フレーム数
+    uint32_t m_lastOverrunUs;
+    Stage m_stage;
+};
+
+#endif // FRAME_BUDGET_WATCHDOG_H
@@ -11,10 +11,11 @@ class JsonLedPatternAdapter : public LedPattern {
 public:
     JsonLedPatternAdapter(const String& name) : m_name(name) {}
     
-    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) override {
+    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const override {
         // JSONパターンの実行ロジックをここに実装
         // 例: ランダムな色で点滅するシンプルなパターン
         unsigned long startTime = millis();
+        LedRandom random = LedRandom::withSeed(esp_random());
         
         while (true) {
             // 実行時間チェック
@@ -23,7 +24,7 @@ public:
             }
             
             // ランダムな色を生成
-            CHSV color(random(0, 255), 255, 255);
+            CHSV color(random.next8(255), 255, 255);
             
             // すべての面を同じ色に設定
             for (int i = 0; i < numFaces; i++) {
@@ -35,7 +36,7 @@ public:
             }
             
             // LEDの表示
-            FastLED.show();
+            LedOutputRouter::getInstance().show(leds, numLeds);
             
             // 少し待機
             vTaskDelay(500 / portTICK_PERIOD_MS);
@@ -50,14 +51,14 @@ public:
             }
             
             // LEDの表示
-            FastLED.show();
+            LedOutputRouter::getInstance().show(leds, numLeds);
             
             // 少し待機
             vTaskDelay(500 / portTICK_PERIOD_MS);
         }
     }
     
-    String getName() override {
+    String getName() const override {
         return m_name;
     }
     
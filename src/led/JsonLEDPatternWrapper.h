@@ -13,13 +13,15 @@ public:
         // パターンの解放はJsonPatternManagerが行うため、ここでは何もしない
     }
     
-    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) override {
+    // JSONパターンの1フレームを描く（ステップは時刻で進み、パターンの中では待機しない）
+    void runFrame(LedPatternState& state, LedPatternExtState* ext,
+                  CRGB* leds, int numLeds, int ledOffset, int numFaces) const override {
         if (m_pattern) {
-            m_pattern->run(leds, numLeds, ledOffset, numFaces, duration);
+            m_pattern->runSingleFrame(state, leds, numLeds, ledOffset, numFaces);
         }
     }
     
-    String getName() override {
+    String getName() const override {
         if (m_pattern) {
             return m_pattern->getName();
         }
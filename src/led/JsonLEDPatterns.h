@@ -6,10 +6,90 @@
 #include <ArduinoJson.h>
 #include <vector>
 #include <map>
+#include <algorithm>
+#include <unordered_map>
 #include <functional>
+#include "FaceTopology.h"
+#include "LedOutput.h"
+#include "LedPatternState.h"
+#include "LedSnapshot.h"
+#include "LedRandom.h"
+#include "LinearLight.h"
+#include "Easing.h"
+#include "LedExpression.h"
 // Forward declarations
 class LedPattern;
 
+// ファイルから1つのパターン定義を読み込むときのJSON文書の容量（定義ごとに確保して解放する）
+// ArduinoJson 7では容量の指定は無視され、文書は必要なだけ伸びる。
+// 解析に使うメモリは入力の大きさに比例するので、入力をJSON_PATTERN_MAX_SOURCE_SIZEまでに抑える。
+#define JSON_PATTERN_DOC_CAPACITY 8192
+#define JSON_PATTERN_MAX_SOURCE_SIZE 8192
+
+// 焼き込みできるステップ数の上限
+#define JSON_BAKE_MAX_STEPS 256
+
+// 焼き込み済みのタイムライン（ステップごとの描画結果と長さ）
+// 乱数の値も焼き込み時に固定されるので、再生はフレームのコピーだけで済む。
+// フレーム予算を超え続けるパターンの最終的な代替として使う。
+struct JsonBakedTimeline {
+    std::vector<CRGB> frames;        // ステップ数 × LED数
+    std::vector<uint32_t> durations; // ステップごとの長さ（ms）
+    int numLeds;
+    bool loop;
+    uint32_t totalDuration;
+    
+    JsonBakedTimeline() : numLeds(0), loop(false), totalDuration(0) {}
+    
+    void clear() {
+        frames.clear();
+        durations.clear();
+        numLeds = 0;
+        totalDuration = 0;
+    }
+    
+    bool isEmpty() const { return durations.empty(); }
+    
+    // 開始からelapsedMs時点のフレームをledsにコピーする（ループしないタイムラインが終わったらfalse）
+    bool render(uint32_t elapsedMs, CRGB* leds) const {
+        if (isEmpty()) return false;
+        if (elapsedMs >= totalDuration) {
+            if (!loop) {
+                memcpy(leds, &frames[(durations.size() - 1) * numLeds], sizeof(CRGB) * numLeds);
+                return false;
+            }
+            elapsedMs %= totalDuration;
+        }
+        size_t step = 0;
+        while (step + 1 < durations.size() && elapsedMs >= durations[step]) {
+            elapsedMs -= durations[step];
+            step++;
+        }
+        memcpy(leds, &frames[step * numLeds], sizeof(CRGB) * numLeds);
+        return true;
+    }
+};
+
+// IRから見積もったパターンの1フレームあたりの処理量とステップの速さ（乱数の値によらない最悪の場合）
+// 処理量は「LEDを1つ読み書きする」「色を1つ変換する」回数で数える。
+struct JsonPatternCost {
+    uint32_t stepCount;
+    uint32_t minStepInterval;      // 最も短いステップの長さ（duration + stepDelay、ms）
+    uint32_t minCycleLength;       // 1周の最短の長さ（ms）
+    uint32_t peakStepsPerSecond;   // 1秒間に始まるステップの数の最大（1周が0msならUINT32_MAX）
+    uint32_t peakStepsPerFrame;    // 1フレームの間に始まるステップの数の最大（描かれるのは最後の1つだけ）
+    uint32_t shortSteps;           // 1フレームより短い（表示されないことがある）ステップの数
+    uint32_t maxLitFaces;          // 1フレームで点灯する面の数の最大
+    uint32_t ledWritesPerFrame;    // ステップの描画で書くLEDの数（消灯も含む）
+    uint32_t colorOpsPerFrame;     // HSVの変換とパレットの参照の回数の最大
+    uint32_t effectOpsPerFrame;    // エフェクト（ブラー・フェード）でLEDを読み書きする回数
+    uint32_t exprOpsPerFrame;      // 式の評価で実行する命令の数の最大
+
+    JsonPatternCost()
+        : stepCount(0), minStepInterval(0), minCycleLength(0), peakStepsPerSecond(0), peakStepsPerFrame(0), shortSteps(0),
+          maxLitFaces(0), ledWritesPerFrame(0), colorOpsPerFrame(0), effectOpsPerFrame(0), exprOpsPerFrame(0) {}
+};
+
 // 値の範囲を表現するクラス
 class MinMax {
 public:
@@ -35,12 +115,12 @@ public:
         }
     }
     
-    // ランダム値または固定値を取得
-    int getValue() const {
+    // ランダム値または固定値を取得（乱数は再生ごとの生成器から引く）
+    int getValue(LedRandom& random) const {
         if (fixed) {
             return min;
         } else {
-            return random(min, max + 1);
+            return random.range(min, max + 1);
         }
     }
     
@@ -77,29 +157,336 @@ public:
         v.setValue(255);  // 明度 最大
     }
     
+    // 値は数値か範囲のほか、文字列の式（LedExpression）でも書ける
     void fromJson(const JsonObject& json) {
-        if (json["h"].is<JsonVariant>()) {
+        if (json["h"].is<String>()) {
+            hExpr = json["h"].as<String>();
+        } else if (json["h"].is<JsonVariant>()) {
             h.fromJson(json["h"]);
         }
-        if (json["s"].is<JsonVariant>()) {
+        if (json["s"].is<String>()) {
+            sExpr = json["s"].as<String>();
+        } else if (json["s"].is<JsonVariant>()) {
             s.fromJson(json["s"]);
         }
-        if (json["v"].is<JsonVariant>()) {
+        if (json["v"].is<String>()) {
+            vExpr = json["v"].as<String>();
+        } else if (json["v"].is<JsonVariant>()) {
             v.fromJson(json["v"]);
         }
     }
     
-    CHSV getColor() const {
+    CHSV getColor(LedRandom& random) const {
         return CHSV(
-            h.getValue(),
-            s.getValue(),
-            v.getValue()
+            h.getValue(random),
+            s.getValue(random),
+            v.getValue(random)
         );
     }
     
     MinMax h;
     MinMax s;
     MinMax v;
+    // 式（空なら上の値を使う）
+    String hExpr;
+    String sExpr;
+    String vExpr;
+};
+
+// パレットのグラデーション停止点の最大数（CRGBPalette16に合わせる）
+#define PALETTE_MAX_STOPS 16
+
+// パレットの実体（IRでもそのまま使う）
+// 元データ（プリセットの番号か、FastLEDのグラデーション形式の停止点）と、それから作ったCRGBPalette16を持つ。
+// 元データはバイナリ形式への書き出しと読み込み用（読み込み時はbuild()で作り直すだけで済む）。
+struct JsonCompiledPalette {
+    enum Preset : uint8_t {
+        GRADIENT = 0,   // gradientから作る
+        HEAT,
+        RAINBOW,
+        LAVA,
+        OCEAN,
+        FOREST,
+        PARTY,
+        CLOUD
+    };
+
+    uint8_t preset;
+    uint8_t stopCount;
+    uint8_t gradient[(PALETTE_MAX_STOPS + 2) * 4];   // (index, r, g, b) × stopCount、最後のindexは255
+    CRGBPalette16 palette;
+
+    JsonCompiledPalette() : preset(RAINBOW), stopCount(0), palette(RainbowColors_p) {}
+
+    // 元データからpaletteを作る（元データが不正ならfalse）
+    bool build() {
+        switch (preset) {
+            case GRADIENT:
+                // loadDynamicGradientPaletteは255番の停止点まで読むので、終端がなければ使わない
+                if (stopCount == 0 || stopCount > PALETTE_MAX_STOPS + 2 || gradient[(stopCount - 1) * 4] != 255) {
+                    return false;
+                }
+                palette.loadDynamicGradientPalette(gradient);
+                return true;
+            case HEAT:    palette = HeatColors_p; return true;
+            case RAINBOW: palette = RainbowColors_p; return true;
+            case LAVA:    palette = LavaColors_p; return true;
+            case OCEAN:   palette = OceanColors_p; return true;
+            case FOREST:  palette = ForestColors_p; return true;
+            case PARTY:   palette = PartyColors_p; return true;
+            case CLOUD:   palette = CloudColors_p; return true;
+            default:      return false;
+        }
+    }
+
+    // パレット上の位置（0-255）から色を取得（隣接エントリ間を線形補間）
+    CRGB getColor(uint8_t index, uint8_t brightness = 255) const {
+        return ColorFromPalette(palette, index, brightness, LINEARBLEND);
+    }
+
+    void save(LedSnapshotWriter& out) const {
+        out.put8(preset);
+        if (preset == GRADIENT) {
+            out.put8(stopCount);
+            out.putBytes(gradient, stopCount * 4);
+        }
+    }
+
+    bool load(LedSnapshotReader& in) {
+        preset = in.get8();
+        stopCount = 0;
+        if (preset == GRADIENT) {
+            stopCount = in.get8();
+            if (stopCount > PALETTE_MAX_STOPS + 2 || !in.getBytes(gradient, stopCount * 4)) {
+                return false;
+            }
+        }
+        return in.ok() && build();
+    }
+};
+
+// 名前付きカラーパレット（CRGBPalette16ベース）
+// JSONでは組み込みプリセット名、またはグラデーション停止点の配列で定義する
+//   "sunset": [[0, 255, 0, 0], [128, 255, 128, 0], [255, 0, 0, 64]]
+//   "sakura": [{"pos": 0, "h": 240, "s": 120, "v": 255}, ...]
+//   "fire":   "heat"
+class ColorPalette {
+public:
+    ColorPalette() : name("") {}
+
+    bool fromJson(const String& paletteName, const JsonVariant& json) {
+        name = paletteName;
+
+        if (json.is<const char*>()) {
+            return fromPreset(json.as<String>());
+        }
+
+        if (!json.is<JsonArray>()) {
+            return false;
+        }
+
+        // FastLEDのグラデーションパレット形式（index, r, g, b）に変換
+        uint8_t* gradient = compiled.gradient;
+        int stopCount = 0;
+        int lastPos = -1;
+
+        for (JsonVariant stop : json.as<JsonArray>()) {
+            if (stopCount >= PALETTE_MAX_STOPS) break;
+
+            int pos;
+            CRGB color;
+            if (!parseStop(stop, pos, color)) {
+                continue;
+            }
+
+            // 停止点は昇順である必要がある
+            pos = constrain(pos, 0, 255);
+            if (pos < lastPos) pos = lastPos;
+
+            // 先頭が0でない場合は同じ色で0番を補う
+            if (stopCount == 0 && pos > 0) {
+                writeStop(gradient, stopCount++, 0, color);
+            }
+
+            writeStop(gradient, stopCount++, pos, color);
+            lastPos = pos;
+        }
+
+        if (stopCount == 0) {
+            return false;
+        }
+
+        // 終端が255でない場合は最後の色で255番を補う
+        if (lastPos < 255) {
+            int last = (stopCount - 1) * 4;
+            writeStop(gradient, stopCount++, 255,
+                      CRGB(gradient[last + 1], gradient[last + 2], gradient[last + 3]));
+        }
+
+        compiled.preset = JsonCompiledPalette::GRADIENT;
+        compiled.stopCount = stopCount;
+        return compiled.build();
+    }
+
+    // パレット上の位置（0-255）から色を取得（隣接エントリ間を線形補間）
+    CRGB getColor(uint8_t index, uint8_t brightness = 255) const {
+        return compiled.getColor(index, brightness);
+    }
+
+    String name;
+    JsonCompiledPalette compiled;
+
+private:
+    bool fromPreset(const String& preset) {
+        static const char* const names[] = {"heat", "rainbow", "lava", "ocean", "forest", "party", "cloud"};
+        for (uint8_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+            if (preset == names[i]) {
+                compiled.preset = JsonCompiledPalette::HEAT + i;
+                return compiled.build();
+            }
+        }
+        return false;
+    }
+
+    static bool parseStop(const JsonVariant& stop, int& pos, CRGB& color) {
+        if (stop.is<JsonArray>()) {
+            // [pos, r, g, b]
+            JsonArray values = stop.as<JsonArray>();
+            if (values.size() < 4) return false;
+            pos = values[0].as<int>();
+            color = CRGB(values[1].as<uint8_t>(), values[2].as<uint8_t>(), values[3].as<uint8_t>());
+            return true;
+        }
+
+        if (stop.is<JsonObject>()) {
+            // {"pos": p, "h": h, "s": s, "v": v}
+            JsonObject obj = stop.as<JsonObject>();
+            if (!obj["pos"].is<int>()) return false;
+            pos = obj["pos"].as<int>();
+            uint8_t h = obj["h"].is<int>() ? obj["h"].as<uint8_t>() : 0;
+            uint8_t s = obj["s"].is<int>() ? obj["s"].as<uint8_t>() : 255;
+            uint8_t v = obj["v"].is<int>() ? obj["v"].as<uint8_t>() : 255;
+            color = CHSV(h, s, v);
+            return true;
+        }
+
+        return false;
+    }
+
+    static void writeStop(uint8_t* gradient, int stopIndex, int pos, const CRGB& color) {
+        gradient[stopIndex * 4 + 0] = pos;
+        gradient[stopIndex * 4 + 1] = color.r;
+        gradient[stopIndex * 4 + 2] = color.g;
+        gradient[stopIndex * 4 + 3] = color.b;
+    }
+};
+
+// ステップからパレットを参照して色を決める指定
+//   "palette": {"name": "sunset", "index": "time", "spread": 32, "speed": 4, "offset": 0}
+class PaletteColor {
+public:
+    enum class IndexMode {
+        POSITION,   // 面の位置（face * spread）
+        TIME,       // 経過時間（ms * speed / 16）+ 面の位置
+        AUDIO       // 音量レベル + 面の位置
+    };
+
+    PaletteColor() : enabled(false), paletteIndex(-1), mode(IndexMode::POSITION), spread(32), speed(1) {
+        offset.setValue(0);
+        brightness.setValue(255);
+    }
+
+    void fromJson(const JsonObject& json) {
+        enabled = true;
+
+        if (json["name"].is<String>()) {
+            name = json["name"].as<String>();
+        }
+
+        if (json["index"].is<String>()) {
+            String modeStr = json["index"].as<String>();
+            if (modeStr == "time") {
+                mode = IndexMode::TIME;
+            } else if (modeStr == "audio") {
+                mode = IndexMode::AUDIO;
+            } else {
+                mode = IndexMode::POSITION;
+            }
+        }
+
+        if (json["spread"].is<int>()) {
+            spread = json["spread"];
+        }
+
+        if (json["speed"].is<int>()) {
+            speed = json["speed"];
+        }
+
+        if (json["offset"].is<JsonVariant>()) {
+            offset.fromJson(json["offset"]);
+        }
+
+        if (json["brightness"].is<JsonVariant>()) {
+            brightness.fromJson(json["brightness"]);
+        }
+    }
+
+    // パターンのパレット一覧から名前を解決する（ロード時に一度だけ呼ぶ）
+    void resolve(const std::vector<ColorPalette>& palettes) {
+        paletteIndex = -1;
+        for (size_t i = 0; i < palettes.size(); i++) {
+            if (palettes[i].name == name) {
+                paletteIndex = i;
+                return;
+            }
+        }
+        // 名前が一致しない場合は最初のパレットを使用
+        if (!palettes.empty()) {
+            paletteIndex = 0;
+        }
+    }
+
+    bool isUsable() const { return enabled && paletteIndex >= 0; }
+
+    // ステップ実行時に一度だけ計算する基準インデックス
+    uint8_t getBaseIndex(unsigned long elapsedMs, LedRandom& random) const {
+        uint8_t base = offset.getValue(random);
+        switch (mode) {
+            case IndexMode::TIME:
+                base += (uint8_t)((elapsedMs * speed) >> 4);
+                break;
+            case IndexMode::AUDIO:
+                base += getAudioLevel();
+                break;
+            case IndexMode::POSITION:
+                break;
+        }
+        return base;
+    }
+
+    // 面ごとの色を取得
+    CRGB getFaceColor(const std::vector<ColorPalette>& palettes, uint8_t baseIndex, int face, uint8_t level) const {
+        return palettes[paletteIndex].getColor(baseIndex + face * spread, level);
+    }
+
+    // マイク入力から更新される音量レベル（0-255）
+    static void setAudioLevel(uint8_t level) { audioLevel() = level; }
+    static uint8_t getAudioLevel() { return audioLevel(); }
+
+    bool enabled;
+    String name;
+    int paletteIndex;
+    IndexMode mode;
+    int spread;
+    int speed;
+    MinMax offset;
+    MinMax brightness;
+
+private:
+    static volatile uint8_t& audioLevel() {
+        static volatile uint8_t level = 0;
+        return level;
+    }
 };
 
 // LEDの面選択方法を表現するクラス
@@ -133,7 +520,7 @@ public:
         }
     }
     
-    std::vector<int> selectFaces(int numFaces) const {
+    std::vector<int> selectFaces(int numFaces, LedRandom& random) const {
         std::vector<int> result;
         
         switch (mode) {
@@ -152,7 +539,7 @@ public:
                 int selectCount = std::min(count, static_cast<int>(candidates.size()));
                 for (int i = 0; i < selectCount; i++) {
                     if (candidates.empty()) break;
-                    int idx = random(0, candidates.size());
+                    int idx = random.below(candidates.size());
                     result.push_back(candidates[idx]);
                     candidates.erase(candidates.begin() + idx);
                 }
@@ -261,10 +648,42 @@ public:
     BlurEffect blur;
 };
 
+// ステップの間に色を補間する先（tween）。ステップの色からtoの色へ、ステップの長さをかけて変える
+class ColorTween {
+public:
+    ColorTween() : enabled(false), easing(Easing::LINEAR) {}
+    
+    void fromJson(const JsonObject& json) {
+        if (json["to"].is<JsonObject>()) {
+            to.fromJson(json["to"]);
+            enabled = true;
+        }
+        
+        if (json["easing"].is<String>()) {
+            String easingStr = json["easing"].as<String>();
+            if (easingStr == "easeIn") {
+                easing = Easing::EASE_IN;
+            } else if (easingStr == "easeOut") {
+                easing = Easing::EASE_OUT;
+            } else if (easingStr == "easeInOut") {
+                easing = Easing::EASE_IN_OUT;
+            } else if (easingStr == "cubic") {
+                easing = Easing::CUBIC;
+            } else {
+                easing = Easing::LINEAR;
+            }
+        }
+    }
+    
+    bool enabled;
+    ColorHSV to;
+    Easing::Curve easing;
+};
+
 // パターンステップとグローバルパラメータ
 class PatternStep {
 public:
-    PatternStep() : hasFaces(false) {}
+    PatternStep() : hasFaces(false), hasColor(false) {}
     
     void fromJson(const JsonObject& json) {
         // 面の選択
@@ -285,30 +704,49 @@ public:
         // 色の設定
         if (json["colorHSV"].is<JsonObject>()) {
             colorHSV.fromJson(json["colorHSV"]);
+            hasColor = true;
+        }
+        
+        // パレット参照による色の設定（colorHSVより優先）
+        if (json["palette"].is<JsonObject>()) {
+            palette.fromJson(json["palette"]);
         }
         
         // 持続時間
         if (json["duration"].is<JsonVariant>()) {
             duration.fromJson(json["duration"]);
         }
+        
+        // 色の補間
+        if (json["tween"].is<JsonObject>()) {
+            tween.fromJson(json["tween"]);
+        }
     }
     
     std::vector<int> faces;
     bool hasFaces;
     FaceSelection faceSelection;
     ColorHSV colorHSV;
+    bool hasColor;  // colorHSVがJSONで指定されたか
+    PaletteColor palette;
     MinMax duration;
+    ColorTween tween;
 };
 
 class GlobalParameters {
 public:
-    GlobalParameters() : loop(false) {}
+    GlobalParameters() : loop(false), seed(0) {}
     
     void fromJson(const JsonObject& json) {
         if (json["loop"].is<bool>()) {
             loop = json["loop"];
         }
         
+        // 乱数のシード（指定すると毎回同じ乱数列で再生される。0は毎回異なる）
+        if (json["seed"].is<uint32_t>()) {
+            seed = json["seed"];
+        }
+        
         if (json["stepDelay"].is<JsonVariant>()) {
             stepDelay.fromJson(json["stepDelay"]);
         }
@@ -317,331 +755,1156 @@ public:
             defaultColor.fromJson(json["colorHSV"]);
         }
         
+        // 名前付きパレットの定義
+        if (json["palettes"].is<JsonObject>()) {
+            for (JsonPair entry : json["palettes"].as<JsonObject>()) {
+                ColorPalette palette;
+                if (palette.fromJson(entry.key().c_str(), entry.value())) {
+                    palettes.push_back(palette);
+                } else {
+                    Serial.println("Invalid palette definition: " + String(entry.key().c_str()));
+                }
+            }
+        }
+        
+        // ステップで色が指定されない場合のデフォルトパレット
+        if (json["palette"].is<JsonObject>()) {
+            defaultPalette.fromJson(json["palette"]);
+        }
+        
         if (json["effects"].is<JsonObject>()) {
             effects.fromJson(json["effects"]);
         }
     }
     
     bool loop;
+    uint32_t seed;
     MinMax stepDelay;
     ColorHSV defaultColor;
+    std::vector<ColorPalette> palettes;
+    PaletteColor defaultPalette;
     Effects effects;
 };
 
-// JSONパターンの基底クラス
-class JsonLedPattern {
-public:
-    JsonLedPattern() : m_name("JSON Pattern"), m_isFirstFrame(true), m_currentStep(0), m_patternStartTime(0) {}
-    virtual ~JsonLedPattern() {}
-    
-    // JSONからパターンを解析するメソッド
-    virtual void parseJson(const JsonObject& json) {
-        if (json["name"].is<String>()) {
-            m_name = json["name"].as<String>();
-        }
+// ---- ロード時に変換する中間表現（IR） ----
+// 上のクラスはJSONの構造をそのまま持つ。再生中はそれを解釈せず、ロード時に一度だけ
+// 下の平坦な表現に変換して使う（面の選択はビットマスク、固定色はCRGB、乱数の範囲は幅を事前計算）。
+// ステップの描画ではヒープを確保しない。
+
+// JSON_EFFECT_*: 有効なエフェクトのフラグ
+#define JSON_EFFECT_FADE 0x01
+#define JSON_EFFECT_BLUR 0x02
+
+// 式を使わない色の成分（JsonCompiledStepの式の番号）。1パターンの式は255個まで
+#define JSON_EXPR_NONE 0xFF
+
+// 値の範囲（spanが0なら固定値min、それ以外は[min, min + span)の乱数）
+// MinMax::getValueと同じ値を同じ乱数の消費で返す
+struct JsonRange {
+    int32_t min;
+    uint32_t span;
+
+    static JsonRange compile(const MinMax& value) {
+        JsonRange range;
+        range.min = value.getMin();
+        range.span = (!value.isFixed() && value.getMax() >= value.getMin())
+                         ? (uint32_t)(value.getMax() - value.getMin() + 1) : 0;
+        return range;
     }
-    
-    // パターン名を取得
-    virtual String getName() { return m_name; }
-    
-    // パターンを実行するメソッド（従来の実装）
-    virtual void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) = 0;
-    
-    // フレームベースの実行メソッド（FPS制御用）
-    virtual bool runSingleFrame(CRGB* leds, int numLeds, int ledOffset, int numFaces) {
-        // 初回フレームの場合は初期化
-        if (m_isFirstFrame) {
-            m_patternStartTime = millis();
-            m_currentStep = 0;
-            m_isFirstFrame = false;
-        }
-        
-        // デフォルト実装（派生クラスでオーバーライド）
-        // 単純に全LEDを消灯
-        for (int i = 0; i < numLeds; i++) {
-            leds[i] = CRGB::Black;
-        }
-        FastLED.show();
-        
-        return false; // パターン未完了
+
+    bool isFixed() const { return span == 0; }
+    int32_t get(LedRandom& random) const {
+        return span == 0 ? min : min + (int32_t)random.below(span);
     }
-    
-    // 状態をリセット
-    virtual void resetFrameState() {
-        m_isFirstFrame = true;
-        m_currentStep = 0;
-        m_patternStartTime = 0;
+
+    // 固定値は多くが小さい数なので可変長で書く（固定の255なら3バイト）
+    void save(LedSnapshotWriter& out) const {
+        out.putSignedVarint(min);
+        out.putVarint(span);
     }
-    
-    // パターンがループするかどうかを返す
-    virtual bool isLooping() const {
-        return false; // デフォルトではループしない
+    void load(LedSnapshotReader& in) {
+        min = in.getSignedVarint();
+        span = in.getVarint();
     }
-    
-protected:
-    String m_name;
-    bool m_isFirstFrame;
-    int m_currentStep;
-    unsigned long m_patternStartTime;
 };
 
-// カスタムJSONパターンの実装
-class CustomJsonPattern : public JsonLedPattern {
-public:
-    CustomJsonPattern() : JsonLedPattern() {
-        m_name = "Custom Pattern";
-    }
-    
-    void parseJson(const JsonObject& json) {
-        JsonLedPattern::parseJson(json);
-        
-        // グローバルパラメータの解析
-        if (json["parameters"].is<JsonObject>()) {
-            m_params.fromJson(json["parameters"]);
+// 1ステップ分の描画命令
+struct JsonCompiledStep {
+    enum FaceSource : uint8_t {
+        FACES_MASK,     // 固定の面（faceMask）
+        FACES_ALL,      // 全面
+        FACES_RANDOM    // randomFirst..randomLastからrandomCount面を選ぶ
+    };
+    enum ColorSource : uint8_t {
+        COLOR_FIXED,    // 事前に変換した色（color）
+        COLOR_HSV,      // 再生ごとに乱数で決めるHSV
+        COLOR_PALETTE,  // パレットから面ごとに引く
+        COLOR_EXPR      // HSVの成分の一部を式でLEDごと・フレームごとに求める
+    };
+
+    FaceSource faceSource;
+    ColorSource colorSource;
+    uint32_t faceMask;
+    uint8_t randomFirst;
+    uint8_t randomLast;
+    uint8_t randomCount;
+    CRGB color;
+    JsonRange hue;
+    JsonRange saturation;
+    JsonRange value;
+    // 式（パターンの式の一覧の位置。JSON_EXPR_NONEの成分は上の範囲の値を使う）
+    uint8_t hueExpr;
+    uint8_t saturationExpr;
+    uint8_t valueExpr;
+    // パレット（ステップかグローバルの指定。paletteIndexはパターンのパレット一覧の位置）
+    uint8_t paletteIndex;
+    uint8_t paletteMode;           // PaletteColor::IndexMode
+    int32_t paletteSpread;
+    int32_t paletteSpeed;
+    JsonRange paletteOffset;
+    JsonRange paletteBrightness;
+    JsonRange duration;
+    // 色の補間（hasTweenのとき、面の色をtoColorへeasingの曲線で寄せる）
+    bool hasTween;
+    bool tweenFixed;               // 補間先が固定色（toColor）か、再生ごとに乱数で決めるHSVか
+    Easing::Curve easing;
+    CRGB toColor;
+    JsonRange toHue;
+    JsonRange toSaturation;
+    JsonRange toValue;
+
+    // 色の優先順位: ステップのパレット → ステップのcolorHSV → グローバルのパレット → グローバルのcolorHSV
+    // colorHSVの式は変換してexpressionsに加える
+    static JsonCompiledStep compile(const PatternStep& step, const GlobalParameters& params,
+                                    std::vector<LedExpression>& expressions) {
+        JsonCompiledStep out;
+        out.faceMask = 0;
+        out.randomFirst = out.randomLast = out.randomCount = 0;
+        if (step.hasFaces) {
+            out.faceSource = FACES_MASK;
+            for (int face : step.faces) {
+                if (face >= 0 && face < 32) out.faceMask |= 1UL << face;
+            }
+        } else if (step.faceSelection.mode == FaceSelection::Mode::ALL) {
+            out.faceSource = FACES_ALL;
+        } else if (step.faceSelection.mode == FaceSelection::Mode::RANDOM) {
+            out.faceSource = FACES_RANDOM;
+            out.randomFirst = constrain(step.faceSelection.range.getMin(), 0, 31);
+            out.randomLast = constrain(step.faceSelection.range.getMax(), 0, 31);
+            out.randomCount = constrain(step.faceSelection.count, 0, 32);
+        } else {
+            // SEQUENTIAL / FIXEDで面の指定がない場合は何も点灯しない
+            out.faceSource = FACES_MASK;
         }
-        
-        // ステップの解析
-        if (json["steps"].is<JsonArray>()) {
-            JsonArray stepsArray = json["steps"];
-            for (JsonObject stepObj : stepsArray) {
-                PatternStep step;
-                step.fromJson(stepObj);
-                m_steps.push_back(step);
+
+        const ColorHSV* hsv = nullptr;
+        const PaletteColor* palette = nullptr;
+        if (step.palette.isUsable()) {
+            palette = &step.palette;
+        } else if (step.hasColor) {
+            hsv = &step.colorHSV;
+        } else if (params.defaultPalette.isUsable()) {
+            palette = &params.defaultPalette;
+        } else {
+            hsv = &params.defaultColor;
+        }
+
+        out.color = CRGB::Black;
+        out.hue = out.saturation = out.value = JsonRange::compile(MinMax());
+        out.hueExpr = out.saturationExpr = out.valueExpr = JSON_EXPR_NONE;
+        out.paletteIndex = 0;
+        out.paletteMode = (uint8_t)PaletteColor::IndexMode::POSITION;
+        out.paletteSpread = out.paletteSpeed = 0;
+        out.paletteOffset = out.paletteBrightness = JsonRange::compile(MinMax());
+        if (palette) {
+            out.colorSource = COLOR_PALETTE;
+            out.paletteIndex = palette->paletteIndex;
+            out.paletteMode = (uint8_t)palette->mode;
+            out.paletteSpread = palette->spread;
+            out.paletteSpeed = palette->speed;
+            out.paletteOffset = JsonRange::compile(palette->offset);
+            out.paletteBrightness = JsonRange::compile(palette->brightness);
+        } else {
+            out.hue = JsonRange::compile(hsv->h);
+            out.saturation = JsonRange::compile(hsv->s);
+            out.value = JsonRange::compile(hsv->v);
+            out.hueExpr = compileExpression(hsv->hExpr, expressions);
+            out.saturationExpr = compileExpression(hsv->sExpr, expressions);
+            out.valueExpr = compileExpression(hsv->vExpr, expressions);
+            if (out.hasExpression()) {
+                out.colorSource = COLOR_EXPR;
+            } else if (out.hue.isFixed() && out.saturation.isFixed() && out.value.isFixed()) {
+                out.colorSource = COLOR_FIXED;
+                out.color = CHSV(out.hue.min, out.saturation.min, out.value.min);
+            } else {
+                out.colorSource = COLOR_HSV;
             }
         }
+        out.duration = JsonRange::compile(step.duration);
+        
+        out.hasTween = step.tween.enabled;
+        out.easing = step.tween.easing;
+        out.toHue = JsonRange::compile(step.tween.to.h);
+        out.toSaturation = JsonRange::compile(step.tween.to.s);
+        out.toValue = JsonRange::compile(step.tween.to.v);
+        out.compileTweenColor();
+        return out;
     }
     
-    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) {
-        unsigned long startTime = millis();
-        int stepIndex = 0;
-        
-        // 状態をリセット
-        resetFrameState();
-        
-        do {
-            for (stepIndex = 0; stepIndex < m_steps.size(); stepIndex++) {
-                // 実行時間チェック
-                if (duration > 0 && millis() - startTime >= (unsigned long)duration) {
-                    return;
+    // 式を変換して一覧に加え、その位置を返す（式がないか変換できなければJSON_EXPR_NONE）
+    static uint8_t compileExpression(const String& source, std::vector<LedExpression>& expressions) {
+        if (source.length() == 0) {
+            return JSON_EXPR_NONE;
+        }
+        if (expressions.size() >= JSON_EXPR_NONE) {
+            Serial.println("Too many expressions: " + source);
+            return JSON_EXPR_NONE;
+        }
+        LedExpression expression;
+        String error;
+        if (!expression.compile(source.c_str(), error)) {
+            Serial.println("Invalid expression \"" + source + "\": " + error);
+            return JSON_EXPR_NONE;
+        }
+        expressions.push_back(expression);
+        return expressions.size() - 1;
+    }
+
+    bool hasExpression() const {
+        return hueExpr != JSON_EXPR_NONE || saturationExpr != JSON_EXPR_NONE || valueExpr != JSON_EXPR_NONE;
+    }
+
+    // 補間先が固定なら事前に変換しておく
+    void compileTweenColor() {
+        tweenFixed = toHue.isFixed() && toSaturation.isFixed() && toValue.isFixed();
+        toColor = tweenFixed ? CRGB(CHSV(toHue.min, toSaturation.min, toValue.min)) : CRGB(CRGB::Black);
+    }
+
+    // 点灯する面をビットマスクで返す（32面まで）
+    uint32_t selectFaces(int numFaces, LedRandom& random) const {
+        int faces = min(numFaces, 32);
+        uint32_t all = faces >= 32 ? 0xFFFFFFFFUL : ((1UL << faces) - 1);
+        switch (faceSource) {
+            case FACES_ALL:
+                return all;
+            case FACES_RANDOM: {
+                // 候補を順に並べ、1つ選ぶたびに詰める（選ぶ順序と乱数の消費は従来と同じ）
+                uint8_t candidates[32];
+                int candidateCount = 0;
+                for (int i = randomFirst; i <= randomLast && i < faces; i++) {
+                    candidates[candidateCount++] = i;
                 }
-                
-                // ステップを実行
-                executeStep(leds, numLeds, ledOffset, numFaces, m_steps[stepIndex]);
-                
-                // ステップ間の遅延
-                int stepDelay = m_params.stepDelay.getValue();
-                if (stepDelay > 0) {
-                    vTaskDelay(stepDelay / portTICK_PERIOD_MS);
+                uint32_t mask = 0;
+                int selectCount = min((int)randomCount, candidateCount);
+                for (int n = 0; n < selectCount; n++) {
+                    int idx = random.below(candidateCount);
+                    mask |= 1UL << candidates[idx];
+                    memmove(&candidates[idx], &candidates[idx + 1], candidateCount - idx - 1);
+                    candidateCount--;
                 }
+                return mask;
             }
-        } while (m_params.loop && (duration == 0 || millis() - startTime < (unsigned long)duration));
-    }
-    
-    // フレームベースの実行メソッド
-    bool runSingleFrame(CRGB* leds, int numLeds, int ledOffset, int numFaces) override {
-        // 初回フレームの場合は初期化
-        if (m_isFirstFrame) {
-            m_patternStartTime = millis();
-            m_currentStep = 0;
-            m_isFirstFrame = false;
+            case FACES_MASK:
+            default:
+                return faceMask & all;
         }
-        
-        // 現在のステップを実行
-        if (m_currentStep < m_steps.size()) {
-            executeStep(leds, numLeds, ledOffset, numFaces, m_steps[m_currentStep]);
-            
-            // 次のステップへ
-            m_currentStep++;
-            
-            // 全ステップ完了したかチェック
-            if (m_currentStep >= m_steps.size()) {
-                if (m_params.loop) {
-                    // ループする場合は最初に戻る
-                    m_currentStep = 0;
-                    return false; // パターン継続
-                } else {
-                    return true; // パターン完了
-                }
+    }
+
+    // 点灯する面の数の最大（selectFacesの結果の面数の上限）
+    int maxLitFaces(int numFaces) const {
+        int faces = min(numFaces, 32);
+        switch (faceSource) {
+            case FACES_ALL:
+                return faces;
+            case FACES_RANDOM: {
+                int candidateCount = max(0, min((int)randomLast, faces - 1) - (int)randomFirst + 1);
+                return min((int)randomCount, candidateCount);
+            }
+            case FACES_MASK:
+            default: {
+                uint32_t all = faces >= 32 ? 0xFFFFFFFFUL : ((1UL << faces) - 1);
+                return __builtin_popcount(faceMask & all);
             }
         }
-        
-        return false; // パターン継続
     }
-    
-    bool isLooping() const override {
-        return m_params.loop;
+
+    // 1フレームの描画での色の変換の回数の最大（固定色は事前に変換済みなので0。補間は面ごとに1回）
+    int maxColorOps(int numFaces) const {
+        int ops = 0;
+        switch (colorSource) {
+            case COLOR_HSV:
+                ops = 1;
+                break;
+            case COLOR_PALETTE:
+                ops = maxLitFaces(numFaces);
+                break;
+            case COLOR_EXPR:
+                ops = maxLitFaces(numFaces) * 2;
+                break;
+            case COLOR_FIXED:
+            default:
+                break;
+        }
+        if (hasTween) {
+            ops += maxLitFaces(numFaces) + (tweenFixed ? 0 : 1);
+        }
+        return ops;
     }
-    
-private:
-    void executeStep(CRGB* leds, int numLeds, int ledOffset, int numFaces, const PatternStep& step) {
-        // 面の選択
-        std::vector<int> selectedFaces;
-        
-        if (step.hasFaces) {
-            // 明示的に指定された面を使用
-            selectedFaces = step.faces;
-        } else {
-            // faceSelectionに基づいて面を選択
-            selectedFaces = step.faceSelection.selectFaces(numFaces);
+
+    // 1フレームの描画で式が実行する命令の数の最大（点灯するLEDごとに各成分の式を評価する）
+    int maxExpressionOps(int numFaces, const std::vector<LedExpression>& expressions) const {
+        if (colorSource != COLOR_EXPR) {
+            return 0;
         }
-        
-        // 色の取得（colorHSVが指定されていない場合はグローバルパラメータのデフォルト色を使用）
-        CHSV color;
-        if (step.colorHSV.h.getMin() != 0 || step.colorHSV.s.getMin() != 0 || step.colorHSV.v.getMin() != 0) {
-            // ステップに色が指定されている場合
-            color = step.colorHSV.getColor();
-        } else {
-            // グローバルパラメータのデフォルト色を使用
-            color = m_params.defaultColor.getColor();
+        int ops = 0;
+        const uint8_t channels[] = {hueExpr, saturationExpr, valueExpr};
+        for (uint8_t channel : channels) {
+            if (channel != JSON_EXPR_NONE) {
+                ops += expressions[channel].getInstructionCount();
+            }
+        }
+        return ops * maxLitFaces(numFaces) * 2;
+    }
+
+    // パレットの基準位置（PaletteColor::getBaseIndexと同じ値を同じ乱数の消費で返す）
+    uint8_t getPaletteBase(unsigned long elapsedMs, LedRandom& random) const {
+        uint8_t base = paletteOffset.get(random);
+        switch ((PaletteColor::IndexMode)paletteMode) {
+            case PaletteColor::IndexMode::TIME:
+                base += (uint8_t)((elapsedMs * paletteSpeed) >> 4);
+                break;
+            case PaletteColor::IndexMode::AUDIO:
+                base += PaletteColor::getAudioLevel();
+                break;
+            case PaletteColor::IndexMode::POSITION:
+                break;
+        }
+        return base;
+    }
+
+    // ステップの色をLEDバッファに描く（選ばれなかった面は消灯）
+    // frameMs: 再生開始からこのフレームまでの時間（式の t）
+    // tweenProgress: ステップの進み具合（0-65535）。補間のあるステップだけが使う
+    void render(CRGB* leds, int numLeds, int ledOffset, int numFaces,
+                const std::vector<JsonCompiledPalette>& palettes, const std::vector<LedExpression>& expressions,
+                unsigned long elapsedMs, uint32_t frameMs, uint16_t tweenProgress, LedRandom& random) const {
+        uint32_t mask = selectFaces(numFaces, random);
+
+        CRGB stepColor = color;
+        CHSV stepHsv(0, 0, 0);
+        uint8_t paletteBase = 0;
+        uint8_t paletteLevel = 255;
+        if (colorSource == COLOR_HSV || colorSource == COLOR_EXPR) {
+            // 引数の評価順に依存しないよう、h → s → v の順に引く（式の成分は範囲が固定値なので引かない）
+            uint8_t h = hue.get(random);
+            uint8_t s = saturation.get(random);
+            uint8_t v = value.get(random);
+            stepHsv = CHSV(h, s, v);
+            if (colorSource == COLOR_HSV) {
+                stepColor = stepHsv;
+            }
+        } else if (colorSource == COLOR_PALETTE) {
+            // パレットの基準位置と明るさはステップごとに一度だけ決める
+            paletteBase = getPaletteBase(elapsedMs, random);
+            paletteLevel = paletteBrightness.get(random);
         }
         
-        // 選択された面にLEDを設定
+        // 補間先の色と寄せる量（乱数はステップの色の後に引くので、補間のないステップの乱数列は変わらない）
+        CRGB tweenColor = toColor;
+        uint8_t tweenAmount = 0;
+        if (hasTween) {
+            if (!tweenFixed) {
+                uint8_t h = toHue.get(random);
+                uint8_t s = toSaturation.get(random);
+                uint8_t v = toValue.get(random);
+                tweenColor = CHSV(h, s, v);
+            }
+            tweenAmount = Easing::apply(easing, tweenProgress) >> 8;
+        }
+
+        // 式の変数のうちフレームで共通のもの（faceとledはLEDごとに入れる）
+        float vars[LedExpression::VAR_COUNT];
+        if (colorSource == COLOR_EXPR) {
+            LedExpression::loadFrameInputs(vars, frameMs, PaletteColor::getAudioLevel());
+        }
+
         for (int i = 0; i < numFaces; i++) {
             int idx1 = ledOffset + (i * 2);
             int idx2 = ledOffset + (i * 2) + 1;
-            
-            // 選択された面かどうかをチェック
-            bool isSelected = false;
-            for (int face : selectedFaces) {
-                if (face == i) {
-                    isSelected = true;
-                    break;
+            if (idx2 >= numLeds) break;
+
+            if (i < 32 && (mask & (1UL << i))) {
+                if (colorSource == COLOR_EXPR) {
+                    // LEDごとに式を評価する（ledはパターンの先頭のLEDからの番号）
+                    vars[LedExpression::VAR_FACE] = i;
+                    for (int k = 0; k < 2; k++) {
+                        vars[LedExpression::VAR_LED] = i * 2 + k;
+                        CRGB ledColor = evaluateColor(stepHsv, expressions, vars);
+                        leds[idx1 + k] = hasTween ? LinearLight::blend(ledColor, tweenColor, tweenAmount) : ledColor;
+                    }
+                    continue;
                 }
-            }
-            
-            if (isSelected) {
-                // 選択された面は指定された色に
-                leds[idx1] = color;
-                leds[idx2] = color;
+                CRGB faceColor = colorSource == COLOR_PALETTE
+                                     ? palettes[paletteIndex].getColor(paletteBase + i * paletteSpread, paletteLevel)
+                                     : stepColor;
+                if (hasTween) {
+                    faceColor = LinearLight::blend(faceColor, tweenColor, tweenAmount);
+                }
+                leds[idx1] = faceColor;
+                leds[idx2] = faceColor;
             } else {
-                // 選択されていない面は消灯
                 leds[idx1] = CRGB::Black;
                 leds[idx2] = CRGB::Black;
             }
         }
+    }
+
+    // 式のある成分を式の値に置き換えた色（色相は一周で折り返し、彩度と明度は0-255に収める）
+    CRGB evaluateColor(CHSV base, const std::vector<LedExpression>& expressions, const float* vars) const {
+        if (hueExpr != JSON_EXPR_NONE) {
+            base.h = LedExpression::toHue(expressions[hueExpr].evaluate(vars));
+        }
+        if (saturationExpr != JSON_EXPR_NONE) {
+            base.s = LedExpression::toLevel(expressions[saturationExpr].evaluate(vars));
+        }
+        if (valueExpr != JSON_EXPR_NONE) {
+            base.v = LedExpression::toLevel(expressions[valueExpr].evaluate(vars));
+        }
+        return base;
+    }
+
+    // バイナリ形式（JsonPatternPack）への書き出しと読み込み
+    void save(LedSnapshotWriter& out) const {
+        out.put8(faceSource);
+        out.put8(colorSource);
+        out.putVarint(faceMask);
+        out.put8(randomFirst);
+        out.put8(randomLast);
+        out.put8(randomCount);
+        if (colorSource == COLOR_PALETTE) {
+            out.put8(paletteIndex);
+            out.put8(paletteMode);
+            out.putSignedVarint(paletteSpread);
+            out.putSignedVarint(paletteSpeed);
+            paletteOffset.save(out);
+            paletteBrightness.save(out);
+        } else {
+            hue.save(out);
+            saturation.save(out);
+            value.save(out);
+            if (colorSource == COLOR_EXPR) {
+                out.put8(hueExpr);
+                out.put8(saturationExpr);
+                out.put8(valueExpr);
+            }
+        }
+        duration.save(out);
+        
+        // 補間: 0ならなし、それ以外は曲線+1に続けて補間先のHSV
+        out.put8(hasTween ? easing + 1 : 0);
+        if (hasTween) {
+            toHue.save(out);
+            toSaturation.save(out);
+            toValue.save(out);
+        }
+    }
+
+    // 固定色は読み込み時にHSVから変換する（paletteCountとexpressionCountはパターンのパレットと式の数）
+    bool load(LedSnapshotReader& in, size_t paletteCount, size_t expressionCount) {
+        faceSource = (FaceSource)in.get8();
+        colorSource = (ColorSource)in.get8();
+        faceMask = in.getVarint();
+        randomFirst = in.get8();
+        randomLast = in.get8();
+        randomCount = in.get8();
+        if (faceSource > FACES_RANDOM || colorSource > COLOR_EXPR ||
+            randomFirst > 31 || randomLast > 31 || randomCount > 32) {
+            return false;
+        }
+
+        color = CRGB::Black;
+        hueExpr = saturationExpr = valueExpr = JSON_EXPR_NONE;
+        if (colorSource == COLOR_PALETTE) {
+            paletteIndex = in.get8();
+            paletteMode = in.get8();
+            paletteSpread = in.getSignedVarint();
+            paletteSpeed = in.getSignedVarint();
+            paletteOffset.load(in);
+            paletteBrightness.load(in);
+            if (paletteIndex >= paletteCount || paletteMode > (uint8_t)PaletteColor::IndexMode::AUDIO) {
+                return false;
+            }
+        } else {
+            hue.load(in);
+            saturation.load(in);
+            value.load(in);
+            if (colorSource == COLOR_FIXED) {
+                color = CHSV(hue.min, saturation.min, value.min);
+            } else if (colorSource == COLOR_EXPR) {
+                hueExpr = in.get8();
+                saturationExpr = in.get8();
+                valueExpr = in.get8();
+                if (!hasExpression() || !isExpressionIndex(hueExpr, expressionCount) ||
+                    !isExpressionIndex(saturationExpr, expressionCount) || !isExpressionIndex(valueExpr, expressionCount)) {
+                    return false;
+                }
+            }
+        }
+        duration.load(in);
+        
+        uint8_t tween = in.get8();
+        if (tween > Easing::CUBIC + 1) {
+            return false;
+        }
+        hasTween = tween != 0;
+        easing = hasTween ? (Easing::Curve)(tween - 1) : Easing::LINEAR;
+        toHue = toSaturation = toValue = JsonRange::compile(MinMax());
+        if (hasTween) {
+            toHue.load(in);
+            toSaturation.load(in);
+            toValue.load(in);
+        }
+        compileTweenColor();
+        return in.ok();
+    }
+
+    static bool isExpressionIndex(uint8_t index, size_t expressionCount) {
+        return index == JSON_EXPR_NONE || index < expressionCount;
+    }
+};
+
+// JSONパターンの基底クラス
+class JsonLedPattern {
+public:
+    JsonLedPattern() : m_name("JSON Pattern") {}
+    virtual ~JsonLedPattern() {}
+    
+    // JSONからパターンを解析するメソッド
+    virtual void parseJson(const JsonObject& json) {
+        if (json["name"].is<String>()) {
+            m_name = json["name"].as<String>();
+        }
+    }
+    
+    // パターン名を取得
+    virtual String getName() const { return m_name; }
+    void setName(const String& name) { m_name = name; }
+    
+    // フレームベースの実行メソッド（FPS制御用）
+    // 解析後のパターンは不変で、再生ごとの状態はstateに持つ（stateはreset()してから渡す）
+    // バッファに1フレーム分を描くだけで、表示と次のフレームまでの待機は呼び出し側が行う。
+    // 戻り値: パターンが最後まで再生されたらtrue
+    virtual bool runSingleFrame(LedPatternState& state, CRGB* leds, int numLeds, int ledOffset, int numFaces) const {
+        // 初回フレームの場合は初期化
+        if (state.firstFrame) {
+            state.startTime = millis();
+            state.step = 0;
+            state.firstFrame = false;
+        }
+        
+        // デフォルト実装（派生クラスでオーバーライド）
+        // 単純に全LEDを消灯
+        for (int i = 0; i < numLeds; i++) {
+            leds[i] = CRGB::Black;
+        }
+        
+        return false; // パターン未完了
+    }
+    
+    // 時刻に応じてステップを進め、バッファに描くだけのフレーム処理（表示も待機もしない）
+    // ゾーン再生のように、描いたバッファを他と合成してから表示する場合に使う
+    virtual void renderFrame(LedPatternState& state, CRGB* leds, int numLeds, int ledOffset, int numFaces) const {
+        for (int i = 0; i < numLeds; i++) {
+            leds[i] = CRGB::Black;
+        }
+    }
+    
+    // パターンを1周ぶん焼き込む（対応しないパターンはfalse）
+    virtual bool bake(JsonBakedTimeline& timeline, LedRandom& random, int numLeds, int ledOffset, int numFaces) const {
+        return false;
+    }
+    
+    // パターンがループするかどうかを返す
+    virtual bool isLooping() const {
+        return false; // デフォルトではループしない
+    }
+    
+    // IRをバイナリ形式（JsonPatternPack）で書き出す（対応しないパターンはfalse）
+    // 名前はパックの文字列表に持つので含めない。
+    virtual bool saveCompiled(LedSnapshotWriter& out) const {
+        return false;
+    }
+
+    // 処理量とステップの速さを見積もる（対応しないパターンはfalse）
+    // frameIntervalMs: 想定するフレームの間隔（これより短いステップをshortStepsに数える）
+    virtual bool estimateCost(int numFaces, int ledOffset, uint32_t frameIntervalMs, JsonPatternCost& cost) const {
+        return false;
+    }
+
+    // 再生位置をpositionMs（パターンの時刻で再生開始から数えた時間）に移動する（移動できないパターンはfalse）
+    // 次のフレームからその位置のステップを描く。
+    virtual bool seek(LedPatternState& state, uint32_t positionMs) const {
+        return false;
+    }
+
+    // 1周の長さ（ms）。位置を移動できないパターンは0
+    virtual uint32_t getTimelineLength() const {
+        return 0;
+    }
+
+    // ステップの数（ステップを持たないパターンは0）
+    virtual size_t getStepCount() const {
+        return 0;
+    }
+
+    // スナップショットから戻した再生状態を、このパターンで続けられるか
+    // 同じ名前のパターンが置き換えられた場合などに、範囲外のステップを描かないよう確かめる
+    virtual bool acceptsState(const LedPatternState& state) const {
+        return true;
+    }
+
+protected:
+    String m_name;
+};
+
+// カスタムJSONパターンの実装
+class CustomJsonPattern : public JsonLedPattern {
+public:
+    CustomJsonPattern() : JsonLedPattern(), m_loop(false), m_seed(0), m_effectFlags(0) {
+        m_name = "Custom Pattern";
+        compile(GlobalParameters(), std::vector<PatternStep>());
+    }
+    
+    // JSONの構造を解析してIRに変換する（解析した構造はIRに変換した後は持たない）
+    void parseJson(const JsonObject& json) {
+        JsonLedPattern::parseJson(json);
+        
+        // グローバルパラメータの解析
+        GlobalParameters params;
+        if (json["parameters"].is<JsonObject>()) {
+            params.fromJson(json["parameters"]);
+        }
+        
+        // ステップの解析
+        std::vector<PatternStep> steps;
+        if (json["steps"].is<JsonArray>()) {
+            JsonArray stepsArray = json["steps"];
+            steps.reserve(stepsArray.size());
+            for (JsonObject stepObj : stepsArray) {
+                PatternStep step;
+                step.fromJson(stepObj);
+                step.palette.resolve(params.palettes);
+                steps.push_back(step);
+            }
+        }
         
-        // エフェクトの適用
-        applyEffects(leds, numLeds, ledOffset, numFaces);
+        params.defaultPalette.resolve(params.palettes);
+        compile(params, steps);
+    }
+    
+    // バイナリ形式（JsonPatternPack）のIRを読み込む（JSONは解析しない）
+    bool loadCompiled(LedSnapshotReader& in) {
+        m_loop = in.get8() != 0;
+        m_seed = in.get32();
+        m_effectFlags = in.get8();
+        uint8_t fadeMode = in.get8();
+        if (fadeMode > (uint8_t)FadeEffect::Mode::BOTH) {
+            return false;
+        }
+        m_fadeMode = (FadeEffect::Mode)fadeMode;
+        m_stepDelay.load(in);
+        m_fadeDuration.load(in);
+        m_blurIntensity.load(in);
+        m_blurDuration.load(in);
         
-        // LEDの表示
-        FastLED.show();
+        m_palettes.assign(in.get8(), JsonCompiledPalette());
+        for (size_t i = 0; i < m_palettes.size(); i++) {
+            if (!m_palettes[i].load(in)) {
+                return false;
+            }
+        }
+        
+        m_expressions.assign(in.get8(), LedExpression());
+        for (size_t i = 0; i < m_expressions.size(); i++) {
+            if (!m_expressions[i].load(in)) {
+                return false;
+            }
+        }
         
-        // ステップの持続時間
-        int stepDuration = step.duration.getValue();
-        if (stepDuration > 0) {
-            vTaskDelay(stepDuration / portTICK_PERIOD_MS);
+        // ステップは1バイト以上あるので、残りのバイト数より多い数は壊れている
+        uint32_t stepCount = in.getVarint();
+        if (stepCount > in.remaining()) {
+            return false;
         }
+        m_program.assign(stepCount, JsonCompiledStep());
+        for (size_t i = 0; i < m_program.size(); i++) {
+            if (!m_program[i].load(in, m_palettes.size(), m_expressions.size())) {
+                return false;
+            }
+        }
+        buildTimeline();
+        return in.ok();
     }
     
-    void applyEffects(CRGB* leds, int numLeds, int ledOffset, int numFaces) {
-        // フェードエフェクト
-        if (m_params.effects.fade.enabled) {
-            applyFadeEffect(leds, numLeds, ledOffset, numFaces);
+    bool saveCompiled(LedSnapshotWriter& out) const override {
+        out.put8(m_loop ? 1 : 0);
+        out.put32(m_seed);
+        out.put8(m_effectFlags);
+        out.put8((uint8_t)m_fadeMode);
+        m_stepDelay.save(out);
+        m_fadeDuration.save(out);
+        m_blurIntensity.save(out);
+        m_blurDuration.save(out);
+        
+        out.put8(m_palettes.size());
+        for (const JsonCompiledPalette& palette : m_palettes) {
+            palette.save(out);
         }
         
-        // ブラーエフェクト
-        if (m_params.effects.blur.enabled) {
-            applyBlurEffect(leds, numLeds, ledOffset, numFaces);
+        out.put8(m_expressions.size());
+        for (const LedExpression& expression : m_expressions) {
+            expression.save(out);
         }
+        
+        out.putVarint(m_program.size());
+        for (const JsonCompiledStep& step : m_program) {
+            step.save(out);
+        }
+        return true;
+    }
+    
+    // フレームベースの実行メソッド
+    // 時刻でステップを進め、現在のステップを描く（待機しないので停止要求にもすぐ応じられる）
+    bool runSingleFrame(LedPatternState& state, CRGB* leds, int numLeds, int ledOffset, int numFaces) const override {
+        return renderTimed(state, leds, numLeds, ledOffset, numFaces);
+    }
+    
+    // ゾーン再生用（描き方はrunSingleFrameと同じ）
+    void renderFrame(LedPatternState& state, CRGB* leds, int numLeds, int ledOffset, int numFaces) const override {
+        renderTimed(state, leds, numLeds, ledOffset, numFaces);
     }
     
-    void applyFadeEffect(CRGB* leds, int numLeds, int ledOffset, int numFaces) {
-        int duration = m_params.effects.fade.duration.getValue();
-        FadeEffect::Mode mode = m_params.effects.fade.mode;
+    // 各ステップを（エフェクトなしで）描いて1周ぶん焼き込む
+    bool bake(JsonBakedTimeline& timeline, LedRandom& random, int numLeds, int ledOffset, int numFaces) const override {
+        timeline.clear();
+        if (m_program.empty() || m_program.size() > JSON_BAKE_MAX_STEPS) {
+            return false;
+        }
+        // 色を補間するステップと式で色を決めるステップは1枚のフレームにできない
+        for (const JsonCompiledStep& step : m_program) {
+            if (step.hasTween || step.colorSource == JsonCompiledStep::COLOR_EXPR) {
+                return false;
+            }
+        }
         
-        // フェードインの実装
-        if (mode == FadeEffect::Mode::IN || mode == FadeEffect::Mode::BOTH) {
-            for (uint8_t b = 0; b < 255; b += 5) {
-                for (int i = 0; i < numFaces; i++) {
-                    int idx1 = ledOffset + (i * 2);
-                    int idx2 = ledOffset + (i * 2) + 1;
-                    
-                    // 現在の色を保存
-                    CRGB color1 = leds[idx1];
-                    CRGB color2 = leds[idx2];
-                    
-                    // 明るさを適用
-                    leds[idx1].nscale8_video(b);
-                    leds[idx2].nscale8_video(b);
-                    
-                    // 元の色を復元（次のループのため）
-                    leds[idx1] = color1;
-                    leds[idx2] = color2;
+        timeline.numLeds = numLeds;
+        timeline.loop = m_loop;
+        timeline.frames.assign(m_program.size() * numLeds, CRGB::Black);
+        timeline.durations.reserve(m_program.size());
+        
+        for (size_t i = 0; i < m_program.size(); i++) {
+            // 再生時と同じ順に乱数を引く（長さ → ステップの描画用のシード）
+            uint32_t length = getStepLength(m_program[i], random);
+            LedRandom stepRandom = LedRandom::withSeed(random.next32());
+            renderStep(&timeline.frames[i * numLeds], numLeds, ledOffset, numFaces, m_program[i], timeline.totalDuration,
+                       timeline.totalDuration, 0, stepRandom);
+            timeline.durations.push_back(length);
+            timeline.totalDuration += length;
+        }
+        if (timeline.totalDuration == 0) {
+            // 長さ0のステップだけの場合は1msずつとして扱う
+            for (size_t i = 0; i < timeline.durations.size(); i++) {
+                timeline.durations[i] = 1;
+            }
+            timeline.totalDuration = timeline.durations.size();
+        }
+        return true;
+    }
+    
+    bool isLooping() const override {
+        return m_loop;
+    }
+
+    // renderTimedと同じIRを数える（ステップの長さは範囲の最小値、面と色は最悪の場合）
+    bool estimateCost(int numFaces, int ledOffset, uint32_t frameIntervalMs, JsonPatternCost& cost) const override {
+        cost = JsonPatternCost();
+        cost.stepCount = m_program.size();
+        if (m_program.empty()) {
+            return true;
+        }
+
+        std::vector<uint32_t> lengths;
+        lengths.reserve(m_program.size());
+        cost.minStepInterval = 0xFFFFFFFFUL;
+        for (const JsonCompiledStep& step : m_program) {
+            uint32_t length = (uint32_t)max(step.duration.min, (int32_t)0) + (uint32_t)max(m_stepDelay.min, (int32_t)0);
+            lengths.push_back(length);
+            cost.minStepInterval = min(cost.minStepInterval, length);
+            cost.minCycleLength += length;
+            if (length < frameIntervalMs) {
+                cost.shortSteps++;
+            }
+            cost.maxLitFaces = max(cost.maxLitFaces, (uint32_t)step.maxLitFaces(numFaces));
+            cost.colorOpsPerFrame = max(cost.colorOpsPerFrame, (uint32_t)step.maxColorOps(numFaces));
+            cost.exprOpsPerFrame = max(cost.exprOpsPerFrame, (uint32_t)step.maxExpressionOps(numFaces, m_expressions));
+        }
+        cost.peakStepsPerSecond = peakStepStarts(lengths, cost.minCycleLength, 1000);
+        cost.peakStepsPerFrame = peakStepStarts(lengths, cost.minCycleLength, max(frameIntervalMs, (uint32_t)1));
+        cost.ledWritesPerFrame = numFaces * 2;
+
+        // エフェクトはapplyEffectsと同じ範囲を数える
+        int numLeds = ledOffset + numFaces * 2;
+        if (m_effectFlags & JSON_EFFECT_BLUR) {
+            // 混ぜる前のコピーと、各LEDの自分と隣接面の読み込み・書き込み
+            const FaceTopology& topology = FaceTopology::forFaceCount(numFaces);
+            cost.effectOpsPerFrame += numLeds;
+            for (int i = 0; i < numFaces && i < topology.getFaceCount(); i++) {
+                int neighbors = 0;
+                for (const uint8_t* n = topology.neighborsBegin(i); n != topology.neighborsEnd(i); ++n) {
+                    if (*n < numFaces) neighbors++;
                 }
-                FastLED.show();
-                vTaskDelay((duration / 50) / portTICK_PERIOD_MS);
+                if (neighbors > 0) {
+                    cost.effectOpsPerFrame += 2 * (neighbors + 2);
+                }
+            }
+        }
+        if (m_effectFlags & JSON_EFFECT_FADE) {
+            cost.effectOpsPerFrame += numLeds - ledOffset;
+        }
+        return true;
+    }
+    
+    // 開始時刻をずらすだけで、ステップは次のフレームでlocateStepが二分探索で求める
+    bool seek(LedPatternState& state, uint32_t positionMs) const override {
+        if (m_stepEnds.empty()) {
+            return false;
+        }
+        uint32_t now = state.clock(millis());
+        if (state.firstFrame) {
+            beginPlayback(state, now);
+        }
+        state.startTime = now - positionMs;
+        state.accumulator = 0;
+        return true;
+    }
+    
+    uint32_t getTimelineLength() const override {
+        return m_stepEnds.empty() ? 0 : m_stepEnds.back();
+    }
+
+    size_t getStepCount() const override {
+        return m_program.size();
+    }
+
+    // 最初のフレームからやり直す状態か、ステップがIRの範囲にある状態だけを受け付ける
+    bool acceptsState(const LedPatternState& state) const override {
+        return state.firstFrame || (state.step >= 0 && state.step < (int32_t)m_program.size());
+    }
+
+private:
+    // windowMsの窓に始まるステップの数の最大（lengthsは各ステップの最短の長さ、cycleはその合計）
+    uint32_t peakStepStarts(const std::vector<uint32_t>& lengths, uint32_t cycle, uint32_t windowMs) const {
+        if (m_loop && cycle < windowMs) {
+            // 1周が窓より短いループは、窓の間に何周するかで決まる
+            return cycle == 0 ? 0xFFFFFFFFUL : (uint32_t)(((uint64_t)lengths.size() * windowMs + cycle - 1) / cycle);
+        }
+
+        // ループは2周ぶん並べれば、1周目から始まる窓をすべて含む
+        std::vector<uint32_t> starts;
+        size_t count = m_loop ? lengths.size() * 2 : lengths.size();
+        starts.reserve(count);
+        uint32_t time = 0;
+        for (size_t i = 0; i < count; i++) {
+            starts.push_back(time);
+            time += lengths[i % lengths.size()];
+        }
+        uint32_t peak = 0;
+        size_t end = 0;
+        for (size_t begin = 0; begin < starts.size(); begin++) {
+            while (end < starts.size() && starts[end] - starts[begin] < windowMs) {
+                end++;
+            }
+            peak = max(peak, (uint32_t)(end - begin));
+        }
+        return peak;
+    }
+
+    // 再生開始時の初期化（JSONでシードが指定されていれば乱数を固定する）
+    // now: パターンの時刻（state.clock()）
+    void beginPlayback(LedPatternState& state, uint32_t now) const {
+        state.startTime = now;
+        state.step = 0;
+        state.firstFrame = false;
+        if (m_seed != 0) {
+            state.random.seed(m_seed);
+        }
+    }
+    
+    // ステップの長さ（ms）
+    uint32_t getStepLength(const JsonCompiledStep& step, LedRandom& random) const {
+        int duration = step.duration.get(random);
+        int stepDelay = m_stepDelay.get(random);
+        return (uint32_t)max(duration, 0) + (uint32_t)max(stepDelay, 0);
+    }
+    
+    // ステップを開始する（長さと、そのステップの描画に使う乱数のシードを決める）
+    // 描画は毎フレームこのシードから同じ乱数列で行うので、ステップの間は同じ面・色になる
+    void beginStep(LedPatternState& state, int32_t step) const {
+        state.step = step;
+        state.accumulator = getStepLength(m_program[step], state.random);
+        state.stepSeed = state.random.next32();
+    }
+    
+    // 期限を過ぎたステップを進めて現在のステップを描く
+    // ステップの長さ（duration + stepDelay）はステップの開始時に決めてstate.accumulatorに持ち、
+    // state.lastStepTimeはステップの開始時刻（期限を足していくのでフレームの刻みによる誤差が積もらない）。
+    // 戻り値: ループしないパターンの最後のステップが終わったらtrue
+    bool renderTimed(LedPatternState& state, CRGB* leds, int numLeds, int ledOffset, int numFaces) const {
+        if (m_program.empty()) {
+            JsonLedPattern::renderFrame(state, leds, numLeds, ledOffset, numFaces);
+            return false;
+        }
+        
+        uint32_t now = state.clock(millis());
+        bool finished = false;
+        if (!m_stepEnds.empty()) {
+            // 1周の長さが決まっているパターンは、再生位置からステップを求める
+            if (state.firstFrame) {
+                beginPlayback(state, now);
+                state.accumulator = 0;
             }
+            if (now - state.lastStepTime >= state.accumulator) {
+                finished = locateStep(state, now);
+            }
+        } else {
+            finished = advanceSteps(state, now);
         }
         
-        // フェードアウトの実装
-        if (mode == FadeEffect::Mode::OUT || mode == FadeEffect::Mode::BOTH) {
-            for (int b = 255; b > 0; b -= 5) {
-                for (int i = 0; i < numFaces; i++) {
-                    int idx1 = ledOffset + (i * 2);
-                    int idx2 = ledOffset + (i * 2) + 1;
-                    
-                    // 現在の色を保存
-                    CRGB color1 = leds[idx1];
-                    CRGB color2 = leds[idx2];
-                    
-                    // 明るさを適用
-                    leds[idx1].nscale8_video(b);
-                    leds[idx2].nscale8_video(b);
-                    
-                    // 元の色を復元（次のループのため）
-                    leds[idx1] = color1;
-                    leds[idx2] = color2;
+        LedRandom stepRandom = LedRandom::withSeed(state.stepSeed);
+        renderStep(leds, numLeds, ledOffset, numFaces, m_program[state.step], state.lastStepTime - state.startTime,
+                   now - state.startTime, Easing::progress(now - state.lastStepTime, state.accumulator), stepRandom);
+        
+        // エフェクト（品質を下げているときは省略）
+        if (m_effectFlags != 0 && (state.flags & LED_STATE_NO_POST_FILTERS) == 0) {
+            applyEffects(leds, numLeds, ledOffset, numFaces, now - state.lastStepTime, state.accumulator, stepRandom);
+        }
+        return finished;
+    }
+    
+    // 期限を過ぎたステップを順に進める（1周の長さが決まらないパターン用）
+    // 戻り値: ループしないパターンの最後のステップが終わったらtrue
+    bool advanceSteps(LedPatternState& state, uint32_t now) const {
+        if (state.firstFrame) {
+            beginPlayback(state, now);
+            state.lastStepTime = state.startTime;
+            beginStep(state, 0);
+        }
+        
+        // 期限を過ぎたステップを進める（長さ0のステップが続いても1周で打ち切る）
+        bool finished = false;
+        for (size_t n = 0; n < m_program.size() && now - state.lastStepTime >= state.accumulator; n++) {
+            int32_t next = state.step + 1;
+            if (next >= (int32_t)m_program.size()) {
+                if (!m_loop) {
+                    finished = true; // 最後のステップを表示したまま終わる
+                    break;
                 }
-                FastLED.show();
-                vTaskDelay((duration / 50) / portTICK_PERIOD_MS);
+                next = 0;
             }
+            state.lastStepTime += state.accumulator;
+            beginStep(state, next);
+        }
+        if (!finished && now - state.lastStepTime >= state.accumulator) {
+            // 大きく遅れた場合は現在時刻に合わせ直す
+            state.lastStepTime = now;
         }
+        return finished;
     }
     
-    void applyBlurEffect(CRGB* leds, int numLeds, int ledOffset, int numFaces) {
-        int intensity = m_params.effects.blur.intensity.getValue();
-        int duration = m_params.effects.blur.duration.getValue();
+    // 再生位置（now - state.startTime）のステップをm_stepEndsの二分探索で求める（O(log ステップ数)）
+    // 遅れたフレームや位置の移動の後も、時刻だけで正しいステップになる。
+    // 乱数は再生中に引かず、ステップの描画のシードは再生の乱数の状態と通算のステップ番号から作るので、
+    // どの位置から再生しても同じ描画になる。
+    // 戻り値: ループしないパターンの最後のステップが終わったらtrue
+    bool locateStep(LedPatternState& state, uint32_t now) const {
+        uint32_t cycle = m_stepEnds.back();
+        uint32_t position = now - state.startTime;
+        uint32_t loopCount = position / cycle;
+        uint32_t offset = position % cycle;
+        size_t step;
+        bool finished = false;
+        if (!m_loop && loopCount > 0) {
+            // 最後のステップを表示したまま終わる
+            loopCount = 0;
+            step = m_stepEnds.size() - 1;
+            finished = true;
+        } else {
+            step = std::upper_bound(m_stepEnds.begin(), m_stepEnds.end(), offset) - m_stepEnds.begin();
+        }
+        
+        uint32_t stepStart = step == 0 ? 0 : m_stepEnds[step - 1];
+        state.step = step;
+        state.lastStepTime = state.startTime + loopCount * cycle + stepStart;
+        state.accumulator = m_stepEnds[step] - stepStart;
+        state.stepSeed = state.random.state + (loopCount * m_stepEnds.size() + step) * 0x9E3779B9UL;
+        return finished;
+    }
+    
+    // 解析済みの定義をIRに変換する（パレットの名前解決の後に呼ぶ）
+    void compile(const GlobalParameters& params, const std::vector<PatternStep>& steps) {
+        m_program.clear();
+        m_program.reserve(steps.size());
+        m_expressions.clear();
+        for (const PatternStep& step : steps) {
+            m_program.push_back(JsonCompiledStep::compile(step, params, m_expressions));
+        }
         
-        // 簡易的なブラー効果の実装
-        // 実際の実装ではより洗練されたアルゴリズムが必要かもしれません
-        for (int t = 0; t < duration; t += 50) {
-            // 現在のLED状態をコピー
-            CRGB tempLeds[numLeds];
-            for (int i = 0; i < numLeds; i++) {
-                tempLeds[i] = leds[i];
+        // パレットは名前を解決済みなので、実体だけを順番どおりに持つ（255個まで）
+        m_palettes.clear();
+        for (size_t i = 0; i < params.palettes.size() && i < 255; i++) {
+            m_palettes.push_back(params.palettes[i].compiled);
+        }
+        
+        m_loop = params.loop;
+        m_seed = params.seed;
+        const Effects& effects = params.effects;
+        m_effectFlags = (effects.fade.enabled ? JSON_EFFECT_FADE : 0) | (effects.blur.enabled ? JSON_EFFECT_BLUR : 0);
+        m_stepDelay = JsonRange::compile(params.stepDelay);
+        m_fadeDuration = JsonRange::compile(effects.fade.duration);
+        m_blurIntensity = JsonRange::compile(effects.blur.intensity);
+        m_blurDuration = JsonRange::compile(effects.blur.duration);
+        m_fadeMode = effects.fade.mode;
+        buildTimeline();
+    }
+    
+    // 位置の移動に使う、1周の各ステップの終了時刻（長さの累積和）の表を作る
+    // ステップの長さが固定か、乱数の範囲でもシードが指定されていれば、1周の長さが再生によらず決まる
+    // （シードからステップの順に長さを引き、各周で同じ長さを使う）。決まらないパターンでは表は空。
+    void buildTimeline() {
+        m_stepEnds.clear();
+        bool fixed = m_stepDelay.isFixed();
+        for (const JsonCompiledStep& step : m_program) {
+            fixed = fixed && step.duration.isFixed();
+        }
+        if (!fixed && m_seed == 0) {
+            return;
+        }
+        
+        LedRandom random = LedRandom::withSeed(m_seed);
+        uint32_t end = 0;
+        m_stepEnds.reserve(m_program.size());
+        for (const JsonCompiledStep& step : m_program) {
+            end += getStepLength(step, random);
+            m_stepEnds.push_back(end);
+        }
+        if (end == 0) {
+            m_stepEnds.clear();
+        }
+    }
+
+    // ステップの色をLEDバッファに描く（表示・待機・エフェクトはしない）
+    // elapsedMs: 再生開始からステップの開始までの時間（パレットのtimeモードの位置）
+    // frameMs: 再生開始からこのフレームまでの時間（式の t）
+    // tweenProgress: ステップの進み具合（0-65535、色の補間用）
+    void renderStep(CRGB* leds, int numLeds, int ledOffset, int numFaces, const JsonCompiledStep& step,
+                    unsigned long elapsedMs, uint32_t frameMs, uint16_t tweenProgress, LedRandom& random) const {
+        step.render(leds, numLeds, ledOffset, numFaces, m_palettes, m_expressions, elapsedMs, frameMs, tweenProgress, random);
+    }
+    
+    // エフェクトを1フレーム分適用する（ステップの経過時間で決まるエンベロープ。待機せず、処理量はLED数に比例）
+    // 乱数はステップの描画に続けてstepRandomから引くので、ステップの間は同じ値になる
+    void applyEffects(CRGB* leds, int numLeds, int ledOffset, int numFaces,
+                      uint32_t stepElapsed, uint32_t stepLength, LedRandom& stepRandom) const {
+        // ブラー: ステップの始めからdurationをかけて、隣接面との混ぜ具合を0からintensity（0-10）まで上げる
+        if (m_effectFlags & JSON_EFFECT_BLUR) {
+            int intensity = constrain(m_blurIntensity.get(stepRandom), 0, 10);
+            uint32_t duration = max(m_blurDuration.get(stepRandom), 0);
+            uint32_t amount = (uint32_t)intensity * 256 / 10;
+            if (duration > 0 && stepElapsed < duration) {
+                amount = amount * stepElapsed / duration;
             }
-            
-            // 各LEDに対して周囲のLEDの平均値を計算
-            for (int i = 0; i < numFaces; i++) {
-                int idx1 = ledOffset + (i * 2);
-                int idx2 = ledOffset + (i * 2) + 1;
-                
-                // 隣接する面のインデックス（簡易的な実装）
-                int prev = (i > 0) ? i - 1 : numFaces - 1;
-                int next = (i < numFaces - 1) ? i + 1 : 0;
-                
-                int prevIdx1 = ledOffset + (prev * 2);
-                int prevIdx2 = ledOffset + (prev * 2) + 1;
-                int nextIdx1 = ledOffset + (next * 2);
-                int nextIdx2 = ledOffset + (next * 2) + 1;
+            if (amount > 0) {
+                applyBlur(leds, numLeds, ledOffset, numFaces, amount);
+            }
+        }
+        
+        // フェード: ステップの始めのduration msで明るくなり（in）、終わりのduration msで暗くなる（out）
+        if (m_effectFlags & JSON_EFFECT_FADE) {
+            uint32_t duration = max(m_fadeDuration.get(stepRandom), 0);
+            uint8_t level = fadeLevel(stepElapsed, stepLength, duration);
+            if (level < 255) {
+                // 線形光で減光する（暗部で段差が出ないように）
+                for (int i = ledOffset; i < numLeds; i++) {
+                    LinearLight::scale(leds[i], level);
+                }
+            }
+        }
+    }
+    
+    // フェードのエンベロープ（0-255）
+    uint8_t fadeLevel(uint32_t stepElapsed, uint32_t stepLength, uint32_t duration) const {
+        if (duration == 0) {
+            return 255;
+        }
+        uint32_t level = 255;
+        if ((m_fadeMode == FadeEffect::Mode::IN || m_fadeMode == FadeEffect::Mode::BOTH) && stepElapsed < duration) {
+            level = min(level, stepElapsed * 255 / duration);
+        }
+        if (m_fadeMode == FadeEffect::Mode::OUT || m_fadeMode == FadeEffect::Mode::BOTH) {
+            uint32_t remaining = stepElapsed < stepLength ? stepLength - stepElapsed : 0;
+            if (remaining < duration) {
+                level = min(level, remaining * 255 / duration);
+            }
+        }
+        return (uint8_t)level;
+    }
+    
+    // 隣接面（形状の隣接グラフ）の同じ段のLEDの平均へamount/256だけ寄せる
+    void applyBlur(CRGB* leds, int numLeds, int ledOffset, int numFaces, uint32_t amount) const {
+        // 混ぜる前の色（隣接面は変更前の値を参照する）
+        CRGB source[numLeds];
+        memcpy(source, leds, sizeof(CRGB) * numLeds);
+        
+        const FaceTopology& topology = FaceTopology::forFaceCount(numFaces);
+        for (int i = 0; i < numFaces && i < topology.getFaceCount(); i++) {
+            for (int led = 0; led < 2; led++) {
+                int idx = ledOffset + (i * 2) + led;
+                if (idx >= numLeds) break;
                 
-                // 平均値の計算（簡易的）
-                leds[idx1].r = (tempLeds[idx1].r * (10 - intensity) + (tempLeds[prevIdx1].r + tempLeds[nextIdx1].r) * intensity / 2) / 10;
-                leds[idx1].g = (tempLeds[idx1].g * (10 - intensity) + (tempLeds[prevIdx1].g + tempLeds[nextIdx1].g) * intensity / 2) / 10;
-                leds[idx1].b = (tempLeds[idx1].b * (10 - intensity) + (tempLeds[prevIdx1].b + tempLeds[nextIdx1].b) * intensity / 2) / 10;
+                // 隣接面の合計
+                int sumR = 0, sumG = 0, sumB = 0, count = 0;
+                for (const uint8_t* n = topology.neighborsBegin(i); n != topology.neighborsEnd(i); ++n) {
+                    int neighborIdx = ledOffset + (*n * 2) + led;
+                    if (*n >= numFaces || neighborIdx >= numLeds) continue;
+                    const CRGB& neighbor = source[neighborIdx];
+                    sumR += neighbor.r;
+                    sumG += neighbor.g;
+                    sumB += neighbor.b;
+                    count++;
+                }
+                if (count == 0) continue;
                 
-                leds[idx2].r = (tempLeds[idx2].r * (10 - intensity) + (tempLeds[prevIdx2].r + tempLeds[nextIdx2].r) * intensity / 2) / 10;
-                leds[idx2].g = (tempLeds[idx2].g * (10 - intensity) + (tempLeds[prevIdx2].g + tempLeds[nextIdx2].g) * intensity / 2) / 10;
-                leds[idx2].b = (tempLeds[idx2].b * (10 - intensity) + (tempLeds[prevIdx2].b + tempLeds[nextIdx2].b) * intensity / 2) / 10;
+                const CRGB& self = source[idx];
+                leds[idx].r = self.r + ((sumR / count - self.r) * (int)amount) / 256;
+                leds[idx].g = self.g + ((sumG / count - self.g) * (int)amount) / 256;
+                leds[idx].b = self.b + ((sumB / count - self.b) * (int)amount) / 256;
             }
-            
-            FastLED.show();
-            vTaskDelay(50 / portTICK_PERIOD_MS);
         }
     }
     
-    GlobalParameters m_params;
-    std::vector<PatternStep> m_steps;
+    // 再生に使うIR（JSONの構造は持たない）
+    std::vector<JsonCompiledStep> m_program;
+    std::vector<JsonCompiledPalette> m_palettes;
+    std::vector<LedExpression> m_expressions;  // ステップの色の式（JsonCompiledStepが番号で参照する）
+    bool m_loop;
+    uint32_t m_seed;
+    uint8_t m_effectFlags;
+    JsonRange m_stepDelay;
+    JsonRange m_fadeDuration;
+    JsonRange m_blurIntensity;
+    JsonRange m_blurDuration;
+    FadeEffect::Mode m_fadeMode;
+    std::vector<uint32_t> m_stepEnds;  // 1周の各ステップの終了時刻（位置を移動できないパターンでは空）
 };
 
 // パターンファクトリークラス
@@ -685,17 +1948,24 @@ private:
     std::map<String, std::function<JsonLedPattern*(const JsonObject&)>> m_creators;
 };
 
+// パターン名のハッシュ（FNV-1a。ArduinoのStringにはstd::hashがないため）
+struct JsonPatternNameHash {
+    size_t operator()(const String& name) const {
+        uint32_t hash = 2166136261UL;
+        for (const char* p = name.c_str(); *p; ++p) {
+            hash = (hash ^ (uint8_t)*p) * 16777619UL;
+        }
+        return hash;
+    }
+};
+
 // JSONパターンマネージャークラス
 class JsonPatternManager {
 public:
     JsonPatternManager() {}
     ~JsonPatternManager() {
         // パターンの解放
-        for (auto pattern : m_patterns) {
-            delete pattern;
-        }
-        m_patterns.clear();
-        m_patternNameMap.clear();
+        clearPatterns();
     }
     
     bool loadPatternsFromFile(const String& filename) {
@@ -711,11 +1981,7 @@ public:
         Serial.println("JSON data (first 100 chars): " + jsonString.substring(0, 100) + "...");
         
         // 既存のパターンをクリア
-        for (auto pattern : m_patterns) {
-            delete pattern;
-        }
-        m_patterns.clear();
-        m_patternNameMap.clear();
+        clearPatterns();
         
         // JSONの解析
         DynamicJsonDocument doc(16384);  // サイズは適宜調整
@@ -727,73 +1993,7 @@ public:
             return false;
         }
         
-        // パターン配列の処理
-        if (doc["patterns"].is<JsonArray>()) {
-            JsonArray patternsArray = doc["patterns"];
-            int index = 0;
-            int patternCount = patternsArray.size();
-            
-            Serial.println("Found " + String(patternCount) + " patterns in JSON");
-            
-            for (JsonObject patternObj : patternsArray) {
-                // パターンの基本情報をログに出力
-                if (patternObj["name"].is<String>()) {
-                    Serial.println("Processing pattern: " + patternObj["name"].as<String>());
-                } else {
-                    Serial.println("Processing unnamed pattern #" + String(index + 1));
-                }
-                
-                // パターンの必須フィールドを検証
-                if (!patternObj["type"].is<String>()) {
-                    Serial.println("Pattern is missing required field: type");
-                    continue;
-                }
-                
-                if (!patternObj["parameters"].is<JsonObject>()) {
-                    Serial.println("Pattern is missing required field: parameters");
-                    continue;
-                }
-                
-                if (!patternObj["steps"].is<JsonArray>()) {
-                    Serial.println("Pattern is missing or has invalid field: steps");
-                    continue;
-                }
-                
-                // パターンを作成
-                try {
-                    JsonLedPattern* pattern = PatternFactory::getInstance().createPattern(patternObj);
-                    if (pattern) {
-                        m_patterns.push_back(pattern);
-                        m_patternNameMap[pattern->getName()] = index++;
-                        Serial.println("Pattern added successfully: " + pattern->getName());
-                    } else {
-                        Serial.println("Failed to create pattern");
-                    }
-                } catch (const std::exception& e) {
-                    Serial.println("Exception while creating pattern: " + String(e.what()));
-                } catch (...) {
-                    Serial.println("Unknown exception while creating pattern");
-                }
-            }
-        } else if (doc["name"].is<String>() && doc["type"].is<String>()) {
-            // 単一のパターンとして処理（配列でない場合）
-            Serial.println("Processing single pattern JSON");
-            
-            try {
-                JsonLedPattern* pattern = PatternFactory::getInstance().createPattern(doc.as<JsonObject>());
-                if (pattern) {
-                    m_patterns.push_back(pattern);
-                    m_patternNameMap[pattern->getName()] = 0;
-                    Serial.println("Single pattern added successfully: " + pattern->getName());
-                } else {
-                    Serial.println("Failed to create single pattern");
-                }
-            } catch (const std::exception& e) {
-                Serial.println("Exception while creating single pattern: " + String(e.what()));
-            } catch (...) {
-                Serial.println("Unknown exception while creating single pattern");
-            }
-        } else {
+        if (addPatternsFromDocument(doc) < 0) {
             Serial.println("JSON does not contain valid pattern data");
             return false;
         }
@@ -802,6 +2002,87 @@ public:
         return !m_patterns.empty();
     }
     
+    // ストリーム（SPIFFSのファイルなど）から直接解析してパターンを追加する（既存のパターンは残す）
+    // ファイル全体を文字列に読み込まず、ファイルごとに文書を作って解析してすぐに解放するので、
+    // ピークメモリはライブラリ全体の大きさによらない。1つのファイルの大きさは
+    // JSON_PATTERN_MAX_SOURCE_SIZEまで（それを超える入力は解析しない）。
+    // 追加した数を返し、解析できなければ-1とerrorを返す。
+    int loadPatternsFromStream(Stream& input, String& error) {
+        if (input.available() > JSON_PATTERN_MAX_SOURCE_SIZE) {
+            error = "file too large";
+            return -1;
+        }
+        DynamicJsonDocument doc(JSON_PATTERN_DOC_CAPACITY);
+        DeserializationError result = deserializeJson(doc, input);
+        if (result) {
+            error = result.c_str();
+            return -1;
+        }
+        
+        int added = addPatternsFromDocument(doc);
+        if (added < 0) {
+            error = "no pattern data";
+            return -1;
+        }
+        return added;
+    }
+    
+    // パターン定義を検証してIRにコンパイルする（ライブラリには追加しない。失敗したらnullptr）
+    // 差し替えの前に、再生中のパターンを止めるかどうかを呼び出し側が判断できるように分けてある。
+    JsonLedPattern* compilePattern(const JsonObject& patternObj) const {
+        if (!patternObj["name"].is<String>()) {
+            Serial.println("Pattern is missing required field: name");
+            return nullptr;
+        }
+        return createValidatedPattern(patternObj);
+    }
+    
+    // 同じ名前のパターンがあれば同じ位置で差し替え、なければ末尾に追加する（所有権を受け取る）
+    // 他のパターンは解析し直さない。差し替えたらtrue（古いパターンは解放される）。
+    bool putPattern(JsonLedPattern* pattern) {
+        auto it = m_patternNameMap.find(pattern->getName());
+        if (it != m_patternNameMap.end()) {
+            delete m_patterns[it->second];
+            m_patterns[it->second] = pattern;
+            return true;
+        }
+        m_patternNameMap[pattern->getName()] = m_patterns.size();
+        m_patterns.push_back(pattern);
+        return false;
+    }
+    
+    // 名前でパターンを削除する（削除した位置、なければ-1）
+    // 後ろのパターンの番号は1つずつ詰める。
+    int removePattern(const String& name) {
+        auto it = m_patternNameMap.find(name);
+        if (it == m_patternNameMap.end()) {
+            return -1;
+        }
+        int index = it->second;
+        m_patternNameMap.erase(it);
+        delete m_patterns[index];
+        m_patterns.erase(m_patterns.begin() + index);
+        for (size_t i = index; i < m_patterns.size(); i++) {
+            m_patternNameMap[m_patterns[i]->getName()] = i;
+        }
+        return index;
+    }
+    
+    // 名前からパターンの番号を引く（なければ-1）
+    int getPatternIndex(const String& name) const {
+        auto it = m_patternNameMap.find(name);
+        return it != m_patternNameMap.end() ? it->second : -1;
+    }
+    
+    // すべてのパターンを解放する
+    void clearPatterns() {
+        for (auto pattern : m_patterns) {
+            delete pattern;
+        }
+        m_patterns.clear();
+        m_patternNameMap.clear();
+    }
+    
     int getPatternCount() const {
         return m_patterns.size();
     }
@@ -822,8 +2103,80 @@ public:
     }
     
 private:
+    // {"patterns":[...]} または単一のパターン定義から追加する（追加した数、パターンのデータがなければ-1）
+    int addPatternsFromDocument(JsonDocument& doc) {
+        if (doc["patterns"].is<JsonArray>()) {
+            JsonArray patternsArray = doc["patterns"];
+            Serial.println("Found " + String(patternsArray.size()) + " patterns in JSON");
+            
+            int added = 0;
+            for (JsonObject patternObj : patternsArray) {
+                if (addPattern(patternObj)) {
+                    added++;
+                }
+            }
+            return added;
+        }
+        
+        if (doc["name"].is<String>() && doc["type"].is<String>()) {
+            // 単一のパターンとして処理（配列でない場合）
+            return addPattern(doc.as<JsonObject>()) ? 1 : 0;
+        }
+        return -1;
+    }
+    
+    // パターン定義を検証してIRにコンパイルし、追加する（同じ名前があれば差し替える）
+    bool addPattern(const JsonObject& patternObj) {
+        // パターンの基本情報をログに出力
+        if (patternObj["name"].is<String>()) {
+            Serial.println("Processing pattern: " + patternObj["name"].as<String>());
+        } else {
+            Serial.println("Processing unnamed pattern #" + String(m_patterns.size() + 1));
+        }
+        
+        JsonLedPattern* pattern = createValidatedPattern(patternObj);
+        if (pattern == nullptr) {
+            return false;
+        }
+        putPattern(pattern);
+        Serial.println("Pattern added successfully: " + pattern->getName());
+        return true;
+    }
+    
+    JsonLedPattern* createValidatedPattern(const JsonObject& patternObj) const {
+        // パターンの必須フィールドを検証
+        if (!patternObj["type"].is<String>()) {
+            Serial.println("Pattern is missing required field: type");
+            return nullptr;
+        }
+        
+        if (!patternObj["parameters"].is<JsonObject>()) {
+            Serial.println("Pattern is missing required field: parameters");
+            return nullptr;
+        }
+        
+        if (!patternObj["steps"].is<JsonArray>()) {
+            Serial.println("Pattern is missing or has invalid field: steps");
+            return nullptr;
+        }
+        
+        // パターンを作成
+        try {
+            JsonLedPattern* pattern = PatternFactory::getInstance().createPattern(patternObj);
+            if (pattern == nullptr) {
+                Serial.println("Failed to create pattern");
+            }
+            return pattern;
+        } catch (const std::exception& e) {
+            Serial.println("Exception while creating pattern: " + String(e.what()));
+        } catch (...) {
+            Serial.println("Unknown exception while creating pattern");
+        }
+        return nullptr;
+    }
+    
     std::vector<JsonLedPattern*> m_patterns;
-    std::map<String, int> m_patternNameMap;
+    std::unordered_map<String, int, JsonPatternNameHash> m_patternNameMap;  // 名前 → m_patternsの位置
 };
 
 #endif // JSON_LED_PATTERNS_H
@@ -0,0 +1,149 @@
+#ifndef JSON_PATTERN_PACK_H
+#define JSON_PATTERN_PACK_H
+
+#include <Arduino.h>
+#include <vector>
+#include <map>
+#include "JsonLEDPatterns.h"
+#include "LedSnapshot.h"
+
+// コンパイル済みJSONパターンのバイナリ形式（パック）
+// ホストのツール（tools/lumipack）がdata/leds/*.jsonをまとめて変換し、本体は起動時にJSONを解析せずに読み込む。
+// 中身はCustomJsonPatternのIRをそのまま詰めたもので、本体でJSONから変換した場合と同じ表現になる。
+//
+//   "LPAK" | バージョン(1) | 予約(1) | 文字列の数(2) | 文字列… | パターンの数(2)
+//   パターンごと: 種類(1) | 名前の文字列番号(2) | CRC32(4) | 長さ付きの区間（IR）
+//   全体のCRC32(4)（ここまでのバイト列）
+//
+// 文字列（パターン名）は文字列表に1回だけ持つ。値はLedSnapshotと同じくリトルエンディアン。
+// 壊れたパターンはCRCで検出して飛ばす（他のパターンは読み込む）。
+
+// パックの形式のバージョン（IRの構造を変えたら上げる。違うバージョンは読まない）
+#define JSON_PACK_VERSION 3
+
+// パターンの種類（今はCustomJsonPatternのみ）
+#define JSON_PACK_KIND_CUSTOM 0
+
+class JsonPatternPack {
+public:
+    // CRC-32（IEEE 802.3）。表を持たないビットごとの計算（起動時に数KBを1回なぞるだけなので十分速い）
+    static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0) {
+        crc = ~crc;
+        for (size_t i = 0; i < length; i++) {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+            }
+        }
+        return ~crc;
+    }
+
+    // マネージャーのパターンをすべてパックに書き出す（書き出せないパターンは飛ばす。書き出した数を返す）
+    static int write(JsonPatternManager& manager, std::vector<uint8_t>& out) {
+        // 書き出せるパターンのIRを先に作り、名前を文字列表に登録する
+        std::vector<String> strings;
+        std::map<String, uint16_t> stringIndex;
+        std::vector<uint16_t> nameIndex;
+        std::vector<std::vector<uint8_t> > bodies;
+        for (int i = 0; i < manager.getPatternCount(); i++) {
+            JsonLedPattern* pattern = manager.getPatternByIndex(i);
+            std::vector<uint8_t> body;
+            LedSnapshotWriter bodyWriter(body);
+            if (!pattern->saveCompiled(bodyWriter) || body.size() > 0xFFFF) {
+                Serial.println("JsonPatternPack: Skipped pattern: " + pattern->getName());
+                continue;
+            }
+            nameIndex.push_back(intern(pattern->getName(), strings, stringIndex));
+            bodies.push_back(body);
+        }
+
+        out.clear();
+        LedSnapshotWriter writer(out);
+        writer.putBytes("LPAK", 4);
+        writer.put8(JSON_PACK_VERSION);
+        writer.put8(0);
+        writer.put16(strings.size());
+        for (const String& value : strings) {
+            writer.putString(value);
+        }
+        writer.put16(bodies.size());
+        for (size_t i = 0; i < bodies.size(); i++) {
+            writer.put8(JSON_PACK_KIND_CUSTOM);
+            writer.put16(nameIndex[i]);
+            writer.put32(crc32(bodies[i].data(), bodies[i].size()));
+            writer.put16(bodies[i].size());
+            writer.putBytes(bodies[i].data(), bodies[i].size());
+        }
+        writer.put32(crc32(out.data(), out.size()));
+        return bodies.size();
+    }
+
+    // パックからパターンを読み込んでマネージャーに追加する（同じ名前は差し替え）
+    // 追加した数を返す。ヘッダー・バージョン・全体のCRCが合わなければ何も追加せず-1
+    static int read(const uint8_t* data, size_t length, JsonPatternManager& manager) {
+        if (length < 4 + 2 + 2 + 2 + 4 || memcmp(data, "LPAK", 4) != 0) {
+            Serial.println("JsonPatternPack: Not a pattern pack");
+            return -1;
+        }
+        uint32_t storedCrc = data[length - 4] | ((uint32_t)data[length - 3] << 8) |
+                             ((uint32_t)data[length - 2] << 16) | ((uint32_t)data[length - 1] << 24);
+        if (crc32(data, length - 4) != storedCrc) {
+            Serial.println("JsonPatternPack: Checksum mismatch");
+            return -1;
+        }
+
+        LedSnapshotReader reader(data + 4, length - 4 - 4);
+        uint8_t version = reader.get8();
+        reader.get8();
+        if (version != JSON_PACK_VERSION) {
+            Serial.printf("JsonPatternPack: Unsupported version %u\n", version);
+            return -1;
+        }
+
+        std::vector<String> strings(reader.get16());
+        for (size_t i = 0; i < strings.size(); i++) {
+            strings[i] = reader.getString();
+        }
+
+        int patternCount = reader.get16();
+        int added = 0;
+        for (int i = 0; i < patternCount && reader.ok(); i++) {
+            uint8_t kind = reader.get8();
+            uint16_t name = reader.get16();
+            uint32_t crc = reader.get32();
+            LedSnapshotReader body = reader.section();
+            if (!reader.ok()) {
+                break;
+            }
+            if (kind != JSON_PACK_KIND_CUSTOM || name >= strings.size() || crc32(body.data(), body.length()) != crc) {
+                Serial.printf("JsonPatternPack: Skipped invalid pattern #%d\n", i);
+                continue;
+            }
+
+            CustomJsonPattern* pattern = new CustomJsonPattern();
+            pattern->setName(strings[name]);
+            if (!pattern->loadCompiled(body)) {
+                Serial.println("JsonPatternPack: Failed to load pattern: " + strings[name]);
+                delete pattern;
+                continue;
+            }
+            manager.putPattern(pattern);
+            added++;
+        }
+        return added;
+    }
+
+private:
+    static uint16_t intern(const String& value, std::vector<String>& strings, std::map<String, uint16_t>& index) {
+        std::map<String, uint16_t>::const_iterator it = index.find(value);
+        if (it != index.end()) {
+            return it->second;
+        }
+        uint16_t position = strings.size();
+        strings.push_back(value);
+        index[value] = position;
+        return position;
+    }
+};
+
+#endif // JSON_PATTERN_PACK_H
@@ -1,6 +1,7 @@
 #include "LEDManager.h"
 #include "Constants.h"
 #include <SPIFFS.h>
+#include "JsonPatternPack.h"
 
 LEDManager::LEDManager() {
     leds = nullptr;
@@ -9,6 +10,8 @@ LEDManager::LEDManager() {
     numFaces = 0;
     ledTaskHandle = nullptr;
     isTaskRunning = false;
+    m_taskIdle = xSemaphoreCreateBinary();
+    xSemaphoreGive(m_taskIdle);
     
     // FPS制御関連の初期化
     m_targetFps = 30; // デフォルト30fps
@@ -19,42 +22,31 @@ LEDManager::LEDManager() {
     m_isJsonPattern = false;
     m_currentJsonPatternIndex = 0;
     
-    // パターンの初期化
-    patternCount = 14; // 全パターン数（FpsTestPatternを追加）
-    patterns = new LedPattern*[patternCount];
-    patterns[0] = new SequentialPattern();
-    patterns[1] = new OnOffPattern();
-    patterns[2] = new OddEvenPattern();
-    patterns[3] = new RandomPattern();
-    patterns[4] = new WavePattern();
-    patterns[5] = new RainbowPattern();
-    patterns[6] = new StrobePattern();
-    patterns[7] = new ChasePattern();
-    patterns[8] = new PulsePattern();
-    patterns[9] = new TwinklePattern();
-    patterns[10] = new FireFlickerPattern();
-    patterns[11] = new CometPattern();
-    patterns[12] = new IndividualRandomPattern();
-    patterns[13] = new FpsTestPattern(); // FPS管理テスト用パターンを追加
+    // パターンは再生するときにレジストリから生成する
+    m_activePattern = nullptr;
+    m_activePatternIndex = -1;
+    
+    // ゾーン再生関連の初期化
+    m_isZoneMode = false;
+    memset(m_pendingZones, 0, sizeof(m_pendingZones));
+    m_resumePlayback = false;
+    m_pendingSeekMs = -1;
+    m_pendingSpeed = 0;
+    m_playingBaked = false;
+    m_playbackGeneration = 0;
     
     currentPatternIndex = 0;
 }
 
 LEDManager::~LEDManager() {
+    // タスクを止めてからパターンとバッファを解放
+    stopTask();
+    m_playback.attach(nullptr);
+    delete m_activePattern;
+    
     if (leds != nullptr) {
         delete[] leds;
-    }
-    
-    // パターンオブジェクトの解放
-    for (int i = 0; i < patternCount; i++) {
-        delete patterns[i];
-    }
-    delete[] patterns;
-    
-    // タスクの削除
-    if (ledTaskHandle != nullptr) {
-        vTaskDelete(ledTaskHandle);
-    }
+    }    vSemaphoreDelete(m_taskIdle);
 }
 
 void LEDManager::begin(int pin, int numLeds, int ledOffset) {
@@ -62,10 +54,21 @@ void LEDManager::begin(int pin, int numLeds, int ledOffset) {
     this->ledOffset = ledOffset;
     this->numFaces = MAX_FACES;
     
-    // LEDストリップの初期化
+    // LEDバッファの初期化と出力先（LEDテープ）の登録
     leds = new CRGB[numLeds];
-    FastLED.addLeds<WS2812B, LED_PIN, GRB>(leds, numLeds);
-    FastLED.setBrightness(255);
+    LedOutputRouter::getInstance().setBrightness(255);
+    LedOutputRouter::getInstance().addSink(&m_fastLedSink, numLeds);
+    
+#ifdef LUMI_LED_TERMINAL_OUTPUT
+    // シリアル端末にもLEDの状態を表示する（デバッグ用）
+    static TerminalSink terminalSink(Serial);
+    LedOutputRouter::getInstance().addSink(&terminalSink, numLeds);
+#endif
+    
+    // ゾーンのキャンバスを確保
+    for (int i = 0; i < LED_MAX_ZONES; i++) {
+        m_zones[i].begin(numLeds);
+    }
     
     // すべてのLEDを消灯
     resetAllLeds();
@@ -83,12 +86,24 @@ void LEDManager::ledTaskWrapper(void* parameter) {
     unsigned long lastFpsLogTime = millis(); // FPSログ用タイマー
     int frameCount = 0; // フレームカウンター
     
-    // パターンをリセット
-    manager->patterns[manager->currentPatternIndex]->reset();
+    // 再生状態をリセット（パターンの定義そのものは変更しない。スナップショットから再開した場合はそのまま）
+    LedPatternInstance& playback = manager->m_playback;
+    {
+        std::lock_guard<std::mutex> lock(manager->m_stateMutex);
+        if (!manager->m_resumePlayback) {
+            playback.reset();
+        }
+        manager->m_resumePlayback = false;
+    }
+    const LedPattern* pattern = playback.getPattern();
+    
+    // フレーム予算の監視を開始
+    manager->m_watchdog.reset(1000000 / max<uint16_t>(manager->m_targetFps, 1));
+    uint32_t frameIndex = 0;
     
     // パターン開始時のログ
     Serial.printf("LEDManager: Starting pattern '%s' with %s FPS control (target: %d fps)\n",
-                 manager->patterns[manager->currentPatternIndex]->getName().c_str(),
+                 pattern->getName().c_str(),
                  manager->m_fpsControlEnabled ? "enabled" : "disabled",
                  manager->m_targetFps);
     
@@ -100,13 +115,19 @@ void LEDManager::ledTaskWrapper(void* parameter) {
             manager->m_fpsController.beginFrame();
         }
         
-        // パターン処理の1フレーム分を実行
-        manager->patterns[manager->currentPatternIndex]->runFrame(
-            manager->leds,
-            manager->numLeds,
-            manager->ledOffset,
-            manager->numFaces
-        );
+        // パターン処理の1フレーム分を描いて確定（品質を下げているときは1フレームおきに計算）
+        bool runLogic = manager->m_watchdog.shouldRunLogic(frameIndex);
+        if (runLogic) {
+            std::lock_guard<std::mutex> lock(manager->m_stateMutex);
+            playback.runFrame(
+                manager->leds,
+                manager->numLeds,
+                manager->ledOffset,
+                manager->numFaces
+            );
+        }
+        manager->show();
+        frameIndex++;
         
         // フレームカウンターを更新
         frameCount++;
@@ -122,8 +143,20 @@ void LEDManager::ledTaskWrapper(void* parameter) {
             frameCount = 0;
         }
         
-        // フレーム処理時間を計測
+        // フレーム処理時間を計測し、予算超過が続いていれば品質を下げる
+        // （表示だけのフレームは報告しない。予算内に収まって超過の連続が途切れてしまうため）
         unsigned long frameProcessingTime = micros() - frameStartTime;
+        if (runLogic && manager->updateFrameBudget(pattern->getName(), frameProcessingTime)) {
+            FrameBudgetWatchdog::Stage stage = manager->m_watchdog.getStage();
+            if (stage >= FrameBudgetWatchdog::NO_POST_FILTERS) {
+                playback.getState().flags |= LED_STATE_NO_POST_FILTERS;
+            }
+            if (stage == FrameBudgetWatchdog::BAKED) {
+                // 組み込みパターンは焼き込みに対応しないので、計算の間引きまでで止める
+                LedDiagnostics::getInstance().record(LedDiagnosticEvent::BAKE_UNAVAILABLE, pattern->getName(),
+                                                     stage, frameProcessingTime, manager->m_watchdog.getBudgetUs());
+            }
+        }
         
         // FPS制御が有効な場合はフレーム終了（自動的に適切な遅延が適用される）
         if (manager->m_fpsControlEnabled) {
@@ -139,51 +172,87 @@ void LEDManager::ledTaskWrapper(void* parameter) {
     
     // タスク終了時にフラグをリセット
     manager->isTaskRunning = false;
-    manager->ledTaskHandle = nullptr;
-    
-    vTaskDelete(NULL);
+    exitTask(manager);
 }
 
 void LEDManager::runPattern(int patternIndex) {
-    if (patternIndex >= 0 && patternIndex < patternCount) {
+    startPattern(patternIndex, nullptr);
+}
+
+// 組み込みパターンの再生を開始する（resumeがあれば再生状態をそこから戻す）
+bool LEDManager::startPattern(int patternIndex, LedSnapshotReader* resume) {
+    if (patternIndex >= 0 && patternIndex < getPatternCount()) {
         currentPatternIndex = patternIndex;
         
-        // 既存のタスクがあれば削除
-        if (ledTaskHandle != nullptr) {
-            vTaskDelete(ledTaskHandle);
-            ledTaskHandle = nullptr;
+        // 既存のタスクがあれば停止
+        stopTask();
+        m_isZoneMode = false;
+        m_playbackGeneration++;
+        
+        // 再生するパターンだけを生成（同じパターンなら再利用）
+        if (m_activePatternIndex != patternIndex) {
+            m_playback.attach(nullptr);
+            delete m_activePattern;
+            m_activePattern = LedPatternRegistry::create(patternIndex);
+            m_activePatternIndex = patternIndex;
+            m_playback.attach(m_activePattern);
         }
+        bool resumed = resume != nullptr && m_playback.restore(*resume, millis(), numFaces);
+        m_resumePlayback = resumed;
         
         // 新しいタスクを作成
-        xTaskCreatePinnedToCore(
-            ledTaskWrapper,
-            "LEDTask",
-            4096,
-            this,
-            1,
-            &ledTaskHandle,
-            1
-        );
-        
-        isTaskRunning = true;
+        createTask(ledTaskWrapper, "LEDTask");
+        return resumed;
     }
+    return false;
 }
 
 void LEDManager::stopPattern() {
+    m_playbackGeneration++;
     if (ledTaskHandle != nullptr) {
-        // タスクを削除（一時停止ではなく完全停止）
-        vTaskDelete(ledTaskHandle);
-        ledTaskHandle = nullptr;
-        isTaskRunning = false;
+        // タスクを停止（一時停止ではなく完全停止）
+        stopTask();
         
-        // JSONパターンフラグをリセット
+        // JSONパターン・ゾーン再生のフラグをリセット
         m_isJsonPattern = false;
+        m_isZoneMode = false;
     }
     
     // パターン停止時にすべてのLEDを消灯
     resetAllLeds();
 }
 
+// 描画タスクを作成する（前のタスクが終了しきるまで待ってから作る）
+void LEDManager::createTask(TaskFunction_t task, const char* name) {
+    xSemaphoreTake(m_taskIdle, portMAX_DELAY);
+    
+    // タスクは開始直後から停止フラグを見るので先に立てる
+    isTaskRunning = true;
+    if (xTaskCreatePinnedToCore(task, name, 4096, this, 1, &ledTaskHandle, 1) != pdPASS) {
+        Serial.printf("LEDManager: Failed to create %s\n", name);
+        isTaskRunning = false;
+        ledTaskHandle = nullptr;
+        xSemaphoreGive(m_taskIdle);
+    }
+}
+
+// 描画タスクの最後に呼ぶ（フラグを戻した後でセマフォを返し、タスクを削除する）
+void LEDManager::exitTask(LEDManager* manager) {
+    manager->ledTaskHandle = nullptr;
+    xSemaphoreGive(manager->m_taskIdle);
+    vTaskDelete(NULL);
+}
+
+// 実行中のタスクを停止する
+// 停止フラグを立て、タスクがフレームの区切りで自発的に終了するのを待つ。
+// どの再生もフレーム単位で停止フラグを見るので、強制的には削除しない
+// （状態のミューテックスを持ったまま削除すると、次のスナップショットや再生開始が止まってしまう）。
+void LEDManager::stopTask() {
+    isTaskRunning = false;
+    xSemaphoreTake(m_taskIdle, portMAX_DELAY);
+    xSemaphoreGive(m_taskIdle);
+}
+
 void LEDManager::lightFace(int faceId, CRGB color) {
     if (faceId >= 0 && faceId < numFaces) {
         int idx1 = ledOffset + (faceId * 2);
@@ -191,7 +260,7 @@ void LEDManager::lightFace(int faceId, CRGB color) {
         
         leds[idx1] = color;
         leds[idx2] = color;
-        FastLED.show();
+        show();
     }
 }
 
@@ -207,20 +276,33 @@ void LEDManager::resetAllLeds() {
     for (int i = 0; i < numLeds; i++) {
         leds[i] = CRGB::Black;
     }
-    FastLED.show();
+    show();
+}
+
+void LEDManager::show() {
+    LedOutputRouter::getInstance().show(leds, numLeds);
+}
+
+bool LEDManager::addOutputSink(LedOutputSink* sink) {
+    return LedOutputRouter::getInstance().addSink(sink, numLeds);
+}
+
+bool LEDManager::removeOutputSink(LedOutputSink* sink) {
+    return LedOutputRouter::getInstance().removeSink(sink);
 }
 
 void LEDManager::nextPattern() {
-    currentPatternIndex = (currentPatternIndex + 1) % patternCount;
+    currentPatternIndex = (currentPatternIndex + 1) % getPatternCount();
 }
 
 void LEDManager::prevPattern() {
-    currentPatternIndex = (currentPatternIndex - 1 + patternCount) % patternCount;
+    currentPatternIndex = (currentPatternIndex - 1 + getPatternCount()) % getPatternCount();
 }
 
 String LEDManager::getPatternName(int index) {
-    if (index >= 0 && index < patternCount) {
-        return patterns[index]->getName();
+    const LedPatternEntry* entry = LedPatternRegistry::getEntry(index);
+    if (entry != nullptr) {
+        return entry->name;
     }
     return "Unknown";
 }
@@ -235,8 +317,8 @@ int LEDManager::getCurrentPatternIndex() {
 
 void LEDManager::setBrightness(uint8_t brightness) {
     this->brightness = brightness;
-    FastLED.setBrightness(brightness);
-    FastLED.show();
+    LedOutputRouter::getInstance().setBrightness(brightness);
+    show();
 }
 
 bool LEDManager::isPatternRunning() {
@@ -268,6 +350,16 @@ bool LEDManager::isFpsControlEnabled() const {
     return m_fpsControlEnabled;
 }
 
+// フレームの処理時間を監視に報告する。段階が上がったら診断イベントを記録してtrueを返す
+bool LEDManager::updateFrameBudget(const String& patternName, uint32_t frameUs) {
+    if (!m_watchdog.reportFrame(frameUs)) {
+        return false;
+    }
+    LedDiagnostics::getInstance().record(LedDiagnosticEvent::DEGRADED, patternName, m_watchdog.getStage(),
+                                         m_watchdog.getLastOverrunUs(), m_watchdog.getBudgetUs());
+    return true;
+}
+
 // JSONパターンタスクラッパー
 void LEDManager::jsonPatternTaskWrapper(void* parameter) {
     LEDManager* manager = static_cast<LEDManager*>(parameter);
@@ -275,8 +367,15 @@ void LEDManager::jsonPatternTaskWrapper(void* parameter) {
     // JSONパターンを取得
     JsonLedPattern* pattern = manager->m_jsonPatternManager.getPatternByIndex(manager->m_currentJsonPatternIndex);
     if (pattern) {
-        // パターン状態をリセット
-        pattern->resetFrameState();
+        // 再生状態をリセット（スナップショットから再開した場合はそのまま）
+        LedPatternState& state = manager->m_jsonState;
+        {
+            std::lock_guard<std::mutex> lock(manager->m_stateMutex);
+            if (!manager->m_resumePlayback) {
+                state.reset();
+            }
+            manager->m_resumePlayback = false;
+        }
         
         // パターン開始時のログ
         Serial.printf("LEDManager: Starting JSON pattern '%s' with %s FPS control (target: %d fps)\n",
@@ -288,60 +387,99 @@ void LEDManager::jsonPatternTaskWrapper(void* parameter) {
         unsigned long lastFpsLogTime = millis();
         int frameCount = 0;
         
-        if (manager->m_fpsControlEnabled) {
-            // FPS制御が有効な場合はフレームベースで実行
-            bool patternComplete = false;
+        // フレーム予算の監視を開始
+        FrameBudgetWatchdog& watchdog = manager->m_watchdog;
+        watchdog.reset(1000000 / max<uint16_t>(manager->m_targetFps, 1));
+        JsonBakedTimeline& baked = manager->m_bakedTimeline;
+        baked.clear();
+        bool playBaked = false;
+        unsigned long bakedStartTime = 0;
+        uint32_t frameIndex = 0;
+        
+        // FPS制御の有無にかかわらずフレームベースで実行し、フレームの区切りごとに停止要求を確認する
+        bool patternComplete = false;
+        
+        while (manager->isTaskRunning && !patternComplete) {
+            unsigned long frameStartTime = micros(); // フレーム開始時間
             
-            while (manager->isTaskRunning && !patternComplete) {
-                unsigned long frameStartTime = micros(); // フレーム開始時間
-                
+            if (manager->m_fpsControlEnabled) {
                 manager->m_fpsController.beginFrame();
-                
-                // JSONパターンの1フレーム分を実行
+            }
+            std::unique_lock<std::mutex> stateLock(manager->m_stateMutex);
+            manager->applyPendingPlayback(pattern, state);
+            
+            bool runLogic = !playBaked && watchdog.shouldRunLogic(frameIndex);
+            if (playBaked) {
+                // 最終段階: 焼き込み済みのフレームをコピーするだけ
+                patternComplete = !baked.render(millis() - bakedStartTime, manager->leds);
+            } else if (runLogic) {
+                // JSONパターンの1フレーム分を描く（品質を下げているときは1フレームおき）
+                // ステップは時刻で進むので、パターンの中では待機しない
                 patternComplete = pattern->runSingleFrame(
+                    state,
                     manager->leds,
                     manager->numLeds,
                     manager->ledOffset,
                     manager->numFaces
                 );
-                
-                // フレームカウンターを更新
-                frameCount++;
-                
-                // 1秒ごとにFPS情報をログ出力
-                unsigned long currentTime = millis();
-                if (currentTime - lastFpsLogTime >= 1000) {
-                    float actualFps = frameCount * 1000.0f / (currentTime - lastFpsLogTime);
-                    Serial.printf("LEDManager: JSON Pattern FPS = %.2f (target: %d, control: %s)\n",
-                                 actualFps, manager->m_targetFps,
-                                 manager->m_fpsControlEnabled ? "enabled" : "disabled");
-                    lastFpsLogTime = currentTime;
-                    frameCount = 0;
+            }
+            stateLock.unlock();
+            manager->show();
+            frameIndex++;
+            
+            // フレームカウンターを更新
+            frameCount++;
+            
+            // 1秒ごとにFPS情報をログ出力
+            unsigned long currentTime = millis();
+            if (currentTime - lastFpsLogTime >= 1000) {
+                float actualFps = frameCount * 1000.0f / (currentTime - lastFpsLogTime);
+                Serial.printf("LEDManager: JSON Pattern FPS = %.2f (target: %d, control: %s)\n",
+                             actualFps, manager->m_targetFps,
+                             manager->m_fpsControlEnabled ? "enabled" : "disabled");
+                lastFpsLogTime = currentTime;
+                frameCount = 0;
+            }
+            
+            // パターンが完了し、ループしない場合は終了
+            if (patternComplete && !pattern->isLooping()) {
+                break;
+            } else if (patternComplete) {
+                // ループする場合は状態をリセット（品質の設定は引き継ぐ）
+                std::lock_guard<std::mutex> lock(manager->m_stateMutex);
+                uint8_t flags = state.flags;
+                state.reset();
+                state.flags = flags;
+                patternComplete = false;
+            }
+            
+            // フレーム処理時間を計測し、予算超過が続いていれば品質を下げる
+            // （パターンを計算したフレームだけを報告する。焼き込みの再生と表示だけのフレームは含めない）
+            unsigned long frameProcessingTime = micros() - frameStartTime;
+            if (runLogic && manager->updateFrameBudget(pattern->getName(), frameProcessingTime)) {
+                std::lock_guard<std::mutex> lock(manager->m_stateMutex);  // 焼き込みは再生の乱数を進める
+                FrameBudgetWatchdog::Stage stage = watchdog.getStage();
+                if (stage >= FrameBudgetWatchdog::NO_POST_FILTERS) {
+                    state.flags |= LED_STATE_NO_POST_FILTERS;
                 }
-                
-                // パターンが完了し、ループしない場合は終了
-                if (patternComplete && !pattern->isLooping()) {
-                    break;
-                } else if (patternComplete) {
-                    // ループする場合は状態をリセット
-                    pattern->resetFrameState();
-                    patternComplete = false;
+                if (stage == FrameBudgetWatchdog::BAKED) {
+                    if (pattern->bake(baked, state.random, manager->numLeds, manager->ledOffset, manager->numFaces)) {
+                        playBaked = true;
+                        manager->m_playingBaked = true;
+                        bakedStartTime = millis();
+                    } else {
+                        LedDiagnostics::getInstance().record(LedDiagnosticEvent::BAKE_UNAVAILABLE, pattern->getName(),
+                                                             stage, frameProcessingTime, watchdog.getBudgetUs());
+                    }
                 }
-                
-                // フレーム処理時間を計測
-                unsigned long frameProcessingTime = micros() - frameStartTime;
-                
+            }
+            
+            if (manager->m_fpsControlEnabled) {
                 manager->m_fpsController.endFrame();
+            } else {
+                // FPS制御が無効な場合は一定間隔（パターンの中では待機しない）
+                vTaskDelay(LED_JSON_FRAME_INTERVAL_MS / portTICK_PERIOD_MS);
             }
-        } else {
-            // FPS制御が無効な場合は従来通り実行
-            pattern->run(
-                manager->leds,
-                manager->numLeds,
-                manager->ledOffset,
-                manager->numFaces,
-                0  // 無限実行（停止要求があるまで）
-            );
         }
     }
     
@@ -351,9 +489,8 @@ void LEDManager::jsonPatternTaskWrapper(void* parameter) {
     // タスク終了時にフラグをリセット
     manager->isTaskRunning = false;
     manager->m_isJsonPattern = false;
-    manager->ledTaskHandle = nullptr;
-    
-    vTaskDelete(NULL);
+    manager->m_playingBaked = false;
+    exitTask(manager);
 }
 
 // JSONパターン関連のメソッド
@@ -369,11 +506,9 @@ bool LEDManager::loadJsonPatternsFromFile(const String& filename) {
         return false;
     }
     
-    String jsonString = file.readString();
-    file.close();
-    
     DynamicJsonDocument doc(4096);
-    DeserializationError error = deserializeJson(doc, jsonString);
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
     
     if (error) {
         Serial.print("JSON parsing failed: ");
@@ -386,26 +521,21 @@ bool LEDManager::loadJsonPatternsFromFile(const String& filename) {
         return false;
     }
     
+    releaseJsonPattern();
+    m_jsonPatternManager.clearPatterns();
+    
     JsonArray patterns = doc["patterns"].as<JsonArray>();
     int count = 0;
     
     for (JsonObject pattern : patterns) {
         if (pattern.containsKey("name") && pattern.containsKey("file")) {
-            String name = pattern["name"].as<String>();
             String filePath = pattern["file"].as<String>();
             
             // Load the pattern file
             File patternFile = SPIFFS.open(filePath, "r");
             if (patternFile) {
-                String patternJson = patternFile.readString();
+                count += max(loadJsonPatternStream(patternFile, filePath), 0);
                 patternFile.close();
-                
-                if (loadJsonPatternsFromString(patternJson)) {
-                    count++;
-                    Serial.printf("Loaded pattern: %s from %s\n", name.c_str(), filePath.c_str());
-                } else {
-                    Serial.printf("Failed to parse pattern: %s\n", name.c_str());
-                }
             } else {
                 Serial.printf("Failed to open pattern file: %s\n", filePath.c_str());
             }
@@ -417,6 +547,7 @@ bool LEDManager::loadJsonPatternsFromFile(const String& filename) {
 }
 
 bool LEDManager::loadJsonPatternsFromString(const String& jsonString) {
+    releaseJsonPattern();
     return m_jsonPatternManager.loadPatternsFromJson(jsonString);
 }
 
@@ -437,49 +568,85 @@ bool LEDManager::loadJsonPatternsFromDirectory(const String& dirPath) {
         return false;
     }
     
-    // Create a JSON array to hold all patterns
-    String combinedJson = "{\"patterns\":[";
-    bool firstPattern = true;
+    releaseJsonPattern();
+    m_jsonPatternManager.clearPatterns();
+    
+    // ファイルごとに直接解析する（壊れたファイルがあっても他のファイルは読み込む）
     int count = 0;
+    int failed = 0;
+    unsigned long startTime = millis();
     
     File file = root.openNextFile();
     while (file) {
         if (!file.isDirectory()) {
             String path = file.name();
             if (path.endsWith(".json")) {
-                String jsonString = file.readString();
-                
-                // Add comma if not the first pattern
-                if (!firstPattern) {
-                    combinedJson += ",";
+                int added = loadJsonPatternStream(file, path);
+                if (added > 0) {
+                    count += added;
                 } else {
-                    firstPattern = false;
+                    failed++;
                 }
-                
-                // Add the pattern JSON to the array
-                combinedJson += jsonString;
-                count++;
             }
         }
+        file.close();
         file = root.openNextFile();
     }
     
-    combinedJson += "]}";
+    Serial.printf("Loaded %d JSON patterns from directory in %lu ms (%d files failed)\n",
+                  count, millis() - startTime, failed);
+    return count > 0;
+}
+
+bool LEDManager::loadJsonPatternPack(const String& filename) {
+    if (!SPIFFS.begin(true)) {
+        Serial.println("An error occurred while mounting SPIFFS");
+        return false;
+    }
     
-    Serial.printf("Loaded %d JSON patterns from directory\n", count);
+    if (!SPIFFS.exists(filename)) {
+        return false;
+    }
     
-    if (count > 0) {
-        // Load all patterns at once
-        bool success = loadJsonPatternsFromString(combinedJson);
-        if (success) {
-            Serial.println("JSON patterns loaded successfully");
-        } else {
-            Serial.println("Failed to load JSON patterns");
-        }
-        return success;
+    File file = SPIFFS.open(filename, "r");
+    if (!file) {
+        Serial.println("Failed to open pattern pack: " + filename);
+        return false;
     }
     
-    return false;
+    unsigned long startUs = micros();
+    std::vector<uint8_t> data(file.size());
+    size_t bytesRead = data.empty() ? 0 : file.read(data.data(), data.size());
+    file.close();
+    if (bytesRead != data.size()) {
+        Serial.println("Failed to read pattern pack: " + filename);
+        return false;
+    }
+    
+    releaseJsonPattern();
+    m_jsonPatternManager.clearPatterns();
+    int count = JsonPatternPack::read(data.data(), data.size(), m_jsonPatternManager);
+    
+    Serial.printf("Loaded %d JSON patterns from pack %s (%u bytes) in %lu us\n",
+                  max(count, 0), filename.c_str(), (unsigned)data.size(), micros() - startUs);
+    return count > 0;
+}
+
+// 1つのファイルからパターンを読み込み、読み込みにかかった時間を出力する（追加した数、失敗したら-1）
+int LEDManager::loadJsonPatternStream(Stream& input, const String& source) {
+    unsigned long startUs = micros();
+    String error;
+    int added = m_jsonPatternManager.loadPatternsFromStream(input, error);
+    unsigned long elapsedUs = micros() - startUs;
+    
+    if (added < 0) {
+        Serial.printf("Failed to parse pattern file %s: %s\n", source.c_str(), error.c_str());
+    } else if (added == 0) {
+        Serial.printf("No valid pattern in %s\n", source.c_str());
+    } else {
+        Serial.printf("Loaded %d pattern(s) from %s in %lu us\n", added, source.c_str(), elapsedUs);
+    }
+    return added;
 }
 
 int LEDManager::getJsonPatternCount() {
@@ -495,58 +662,142 @@ String LEDManager::getJsonPatternName(int index) {
 }
 
 void LEDManager::runJsonPattern(const String& patternName) {
-    JsonLedPattern* pattern = m_jsonPatternManager.getPatternByName(patternName);
-    if (pattern) {
-        // 既存のタスクがあれば削除
-        if (ledTaskHandle != nullptr) {
-            vTaskDelete(ledTaskHandle);
-            ledTaskHandle = nullptr;
-        }
-        
-        // JSONパターンフラグを設定
-        m_isJsonPattern = true;
-        
-        // 新しいタスクを作成
-        xTaskCreatePinnedToCore(
-            jsonPatternTaskWrapper,
-            "JSONPatternTask",
-            4096,
-            this,
-            1,
-            &ledTaskHandle,
-            1
-        );
-        
-        isTaskRunning = true;
-    }
+    startJsonPattern(m_jsonPatternManager.getPatternIndex(patternName), nullptr);
 }
 
 void LEDManager::runJsonPatternByIndex(int index) {
+    startJsonPattern(index, nullptr);
+}
+
+// JSONパターンの再生を開始する（resumeがあれば再生状態をそこから戻す）
+bool LEDManager::startJsonPattern(int index, LedSnapshotReader* resume) {
     if (index >= 0 && index < m_jsonPatternManager.getPatternCount()) {
         m_currentJsonPatternIndex = index;
         
-        // 既存のタスクがあれば削除
-        if (ledTaskHandle != nullptr) {
-            vTaskDelete(ledTaskHandle);
-            ledTaskHandle = nullptr;
-        }
+        // 既存のタスクがあれば停止（前の再生への位置と速度の要求は捨てる）
+        stopTask();
+        m_pendingSeekMs = -1;
+        m_pendingSpeed = 0;
+        m_playingBaked = false;
+        m_playbackGeneration++;
         
         // JSONパターンフラグを設定
         m_isJsonPattern = true;
+        m_isZoneMode = false;
+        bool resumed = resume != nullptr && m_jsonState.load(*resume, millis());
+        // 読み込んだ状態がパターンに合わなければ（別の定義の状態など）最初から再生する
+        if (resumed && !m_jsonPatternManager.getPatternByIndex(index)->acceptsState(m_jsonState)) {
+            Serial.println("LEDManager: Snapshot state does not fit the JSON pattern");
+            resumed = false;
+        }
+        m_resumePlayback = resumed;
         
         // 新しいタスクを作成
-        xTaskCreatePinnedToCore(
-            jsonPatternTaskWrapper,
-            "JSONPatternTask",
-            4096,
-            this,
-            1,
-            &ledTaskHandle,
-            1
-        );
-        
-        isTaskRunning = true;
+        createTask(jsonPatternTaskWrapper, "JSONPatternTask");
+        return resumed;
+    }
+    return false;
+}
+
+// スナップショットの先頭: 'L' 'P' バージョン 種類（0=組み込み、1=JSON）
+#define LED_SNAPSHOT_KIND_BUILTIN 0
+#define LED_SNAPSHOT_KIND_JSON 1
+
+bool LEDManager::suspendPattern(std::vector<uint8_t>& snapshot) {
+    snapshot.clear();
+    if (!isPatternRunning() || m_isZoneMode) {
+        return false;
     }
+    
+    // タスクを止めてから状態を読む（描画中の状態を書き出さないように）
+    stopTask();
+    writeSnapshot(snapshot);
+    
+    // 停止後の後始末はstopPatternと同じ
+    m_isJsonPattern = false;
+    resetAllLeds();
+    
+    Serial.printf("LEDManager: Suspended pattern (%u bytes)\n", (unsigned)snapshot.size());
+    return !snapshot.empty();
+}
+
+bool LEDManager::snapshotPattern(std::vector<uint8_t>& snapshot) {
+    snapshot.clear();
+    if (!isPatternRunning() || m_isZoneMode) {
+        return false;
+    }
+    
+    // 描画タスクがフレームの間で状態を更新し終えるのを待ってから読む
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    writeSnapshot(snapshot);
+    return !snapshot.empty();
+}
+
+// 再生中のパターンの状態を書き出す（状態を更新するタスクが止まっているか、m_stateMutexを持って呼ぶ）
+void LEDManager::writeSnapshot(std::vector<uint8_t>& snapshot) {
+    uint32_t now = millis();
+    LedSnapshotWriter out(snapshot);
+    out.put8('L');
+    out.put8('P');
+    out.put8(LED_SNAPSHOT_VERSION);
+    
+    JsonLedPattern* jsonPattern = m_isJsonPattern ? m_jsonPatternManager.getPatternByIndex(m_currentJsonPatternIndex) : nullptr;
+    if (jsonPattern != nullptr) {
+        // JSONパターンは読み込み直すと番号が変わりうるので名前で記録する
+        // （同じ名前で定義が変わったことを見分けられるよう、ステップの数も書く）
+        out.put8(LED_SNAPSHOT_KIND_JSON);
+        out.putString(jsonPattern->getName());
+        out.putVarint(jsonPattern->getStepCount());
+        m_jsonState.save(out, now);
+    } else if (!m_isJsonPattern && m_playback.getPattern() != nullptr) {
+        out.put8(LED_SNAPSHOT_KIND_BUILTIN);
+        out.put8(m_activePatternIndex);
+        m_playback.save(out, now);
+    } else {
+        snapshot.clear();
+    }
+}
+
+bool LEDManager::resumePattern(const std::vector<uint8_t>& snapshot) {
+    LedSnapshotReader in(snapshot.data(), snapshot.size());
+    if (in.get8() != 'L' || in.get8() != 'P' || in.get8() != LED_SNAPSHOT_VERSION) {
+        Serial.println("LEDManager: Unsupported pattern snapshot");
+        return false;
+    }
+    
+    bool resumed = false;
+    uint8_t kind = in.get8();
+    if (kind == LED_SNAPSHOT_KIND_BUILTIN) {
+        int patternIndex = in.get8();
+        if (!in.ok() || patternIndex >= getPatternCount()) {
+            return false;
+        }
+        currentPatternIndex = patternIndex;
+        resumed = startPattern(patternIndex, &in);
+    } else if (kind == LED_SNAPSHOT_KIND_JSON) {
+        // 名前で探す（見つからなければ再開しない）
+        String name = in.getString();
+        int index = m_jsonPatternManager.getPatternIndex(name);
+        JsonLedPattern* pattern = m_jsonPatternManager.getPatternByIndex(index);
+        uint32_t stepCount = in.getVarint();
+        if (!in.ok() || index < 0) {
+            Serial.println("LEDManager: JSON pattern in snapshot not found: " + name);
+            return false;
+        }
+        // 同じ名前でもステップの数が違えば別の定義なので、状態は使わず最初から再生する
+        if (stepCount != pattern->getStepCount()) {
+            Serial.println("LEDManager: JSON pattern in snapshot has changed: " + name);
+            resumed = startJsonPattern(index, nullptr);
+        } else {
+            resumed = startJsonPattern(index, &in);
+        }
+    } else {
+        return false;
+    }
+    
+    // 状態が読めなかった場合も、パターンは最初から再生している
+    Serial.printf("LEDManager: Resumed pattern %s\n", resumed ? "from snapshot" : "from the beginning");
+    return true;
 }
 
 // 受信したJSONパターンをファイルから読み込んで実行する
@@ -571,6 +822,13 @@ bool LEDManager::runJsonPatternFromFile(const String& filename) {
         return false;
     }
     
+    // 解析に使うメモリを抑えるため、大きすぎるファイルは読み込まない
+    if (file.size() > JSON_PATTERN_MAX_SOURCE_SIZE) {
+        Serial.println("LEDManager: JSON pattern file is too large: " + filename);
+        file.close();
+        return false;
+    }
+    
     // ファイルの内容を読み込む
     String jsonString = file.readString();
     file.close();
@@ -610,19 +868,18 @@ bool LEDManager::runJsonPatternFromFile(const String& filename) {
     }
     
     // パターン名を取得（あれば）
+    // （名前のないパターンはライブラリの中で"Custom Pattern"として扱う）
     String patternName = "Custom Pattern";
     if (docCheck.containsKey("name")) {
         patternName = docCheck["name"].as<String>();
+    } else {
+        docCheck["name"] = patternName;
     }
     
-    // JSONパターンを読み込む
-    Serial.println("LEDManager: Loading pattern into JsonPatternManager...");
+    // ライブラリに追加（同じ名前があれば差し替え）して再生する（他のパターンはそのまま）
+    Serial.println("LEDManager: Adding pattern to JsonPatternManager...");
     
-    // 単一のパターンをラップして配列形式にする
-    String wrappedJson = "{\"patterns\":[" + jsonString + "]}";
-    
-    bool success = m_jsonPatternManager.loadPatternsFromJson(wrappedJson);
-    if (!success) {
+    if (!putJsonPattern(docCheck.as<JsonObject>())) {
         Serial.println("LEDManager: Failed to load JSON pattern");
         return false;
     }
@@ -630,35 +887,287 @@ bool LEDManager::runJsonPatternFromFile(const String& filename) {
     Serial.println("LEDManager: JSON pattern loaded successfully");
     
     // パターンを実行
-    if (m_jsonPatternManager.getPatternCount() > 0) {
-        m_currentJsonPatternIndex = 0; // 最初のパターンを使用
-        
-        // 既存のタスクがあれば削除
-        if (ledTaskHandle != nullptr) {
-            vTaskDelete(ledTaskHandle);
-            ledTaskHandle = nullptr;
+    startJsonPattern(m_jsonPatternManager.getPatternIndex(patternName), nullptr);
+    Serial.println("LEDManager: Running JSON pattern: " + patternName);
+    return true;
+}
+
+// パターンを1つ追加または差し替える（他のパターンは解析し直さない）
+bool LEDManager::putJsonPattern(const JsonObject& patternObj) {
+    // 先にコンパイルしておき、失敗したら再生中のパターンには触れない
+    JsonLedPattern* pattern = m_jsonPatternManager.compilePattern(patternObj);
+    if (pattern == nullptr) {
+        return false;
+    }
+    
+    // 差し替えるパターンを再生・参照しているタスクとゾーンを止めてから解放する
+    JsonLedPattern* existing = m_jsonPatternManager.getPatternByName(pattern->getName());
+    if (existing != nullptr) {
+        releaseJsonPattern(existing);
+    }
+    
+    bool replaced = m_jsonPatternManager.putPattern(pattern);
+    Serial.println("LEDManager: " + String(replaced ? "Replaced" : "Added") + " JSON pattern: " + pattern->getName());
+    return true;
+}
+
+bool LEDManager::putJsonPattern(const String& jsonString) {
+    // 解析に使うメモリを抑えるため、大きすぎる定義は解析しない
+    if (jsonString.length() > JSON_PATTERN_MAX_SOURCE_SIZE) {
+        Serial.println("LEDManager: JSON pattern is too large: " + String(jsonString.length()) + " bytes");
+        return false;
+    }
+    DynamicJsonDocument doc(JSON_PATTERN_DOC_CAPACITY);
+    DeserializationError error = deserializeJson(doc, jsonString);
+    if (error) {
+        Serial.println("LEDManager: JSON parsing failed: " + String(error.c_str()));
+        return false;
+    }
+    return putJsonPattern(doc.as<JsonObject>());
+}
+
+bool LEDManager::removeJsonPattern(const String& patternName) {
+    JsonLedPattern* pattern = m_jsonPatternManager.getPatternByName(patternName);
+    if (pattern == nullptr) {
+        return false;
+    }
+    releaseJsonPattern(pattern);
+    
+    int index = m_jsonPatternManager.removePattern(patternName);
+    // 後ろのパターンは番号が詰まるので、再生中の番号も合わせる
+    if (m_currentJsonPatternIndex > index) {
+        m_currentJsonPatternIndex--;
+    }
+    Serial.println("LEDManager: Removed JSON pattern: " + patternName);
+    return true;
+}
+
+// 位置の移動は描画タスクが反映する（再生中の状態は描画タスクだけが書き換える）
+bool LEDManager::seekJsonPattern(uint32_t positionMs) {
+    // 焼き込んだタイムラインは再生状態の時刻を使わないので、位置の移動は効かない
+    if (!isJsonPatternRunning() || m_playingBaked || getJsonTimelineLength() == 0) {
+        return false;
+    }
+    m_pendingSeekMs = (int32_t)min(positionMs, (uint32_t)INT32_MAX);
+    return true;
+}
+
+bool LEDManager::setJsonPlaybackSpeed(float speed) {
+    if (!isJsonPatternRunning() || m_playingBaked || !isValidPlaybackSpeed(speed)) {
+        return false;
+    }
+    m_pendingSpeed = (uint16_t)(speed * LED_SPEED_ONE + 0.5f);
+    return true;
+}
+
+float LEDManager::getJsonPlaybackSpeed() {
+    uint16_t speed = m_pendingSpeed != 0 ? m_pendingSpeed : m_jsonState.speed;
+    return isJsonPatternRunning() ? (float)speed / LED_SPEED_ONE : 1.0f;
+}
+
+uint32_t LEDManager::getJsonPlaybackPosition() {
+    if (!isJsonPatternRunning() || m_playingBaked || m_jsonState.firstFrame) {
+        return 0;
+    }
+    return m_jsonState.clock(millis()) - m_jsonState.startTime;
+}
+
+uint32_t LEDManager::getJsonTimelineLength() {
+    JsonLedPattern* pattern = m_jsonPatternManager.getPatternByIndex(m_currentJsonPatternIndex);
+    return isJsonPatternRunning() && !m_playingBaked && pattern ? pattern->getTimelineLength() : 0;
+}
+
+// 描画タスクから呼ぶ: 位置と速度の変更要求を再生状態に反映する（速度を先に変えてから位置を合わせる）
+void LEDManager::applyPendingPlayback(const JsonLedPattern* pattern, LedPatternState& state) {
+    uint16_t speed = m_pendingSpeed;
+    if (speed != 0) {
+        m_pendingSpeed = 0;
+        state.setSpeed(speed, millis());
+    }
+    int32_t seek = m_pendingSeekMs;
+    if (seek >= 0) {
+        m_pendingSeekMs = -1;
+        pattern->seek(state, (uint32_t)seek);
+    }
+}
+
+// パターンを解放する前に、それを再生しているタスクと参照しているゾーンを止める
+// patternを省略するとすべてのJSONパターンが対象（パターンをまとめて読み込み直すとき）
+void LEDManager::releaseJsonPattern(const JsonLedPattern* pattern) {
+    if (m_isJsonPattern && isTaskRunning &&
+        (pattern == nullptr || m_jsonPatternManager.getPatternByIndex(m_currentJsonPatternIndex) == pattern)) {
+        stopTask();
+        m_isJsonPattern = false;
+    }
+    releaseJsonZones(pattern);
+}
+
+// ---- ゾーン再生 ----
+
+bool LEDManager::setZonePattern(int zone, uint32_t faceMask, int patternIndex) {
+    if (patternIndex < 0 || patternIndex >= getPatternCount()) {
+        return false;
+    }
+    
+    LedZoneRequest request = {};
+    request.faceMask = faceMask;
+    request.patternIndex = patternIndex;
+    return requestZoneChange(zone, request);
+}
+
+bool LEDManager::setZoneJsonPattern(int zone, uint32_t faceMask, const String& patternName) {
+    JsonLedPattern* pattern = m_jsonPatternManager.getPatternByName(patternName);
+    if (pattern == nullptr) {
+        Serial.println("LEDManager: Unknown JSON pattern for zone: " + patternName);
+        return false;
+    }
+    
+    LedZoneRequest request = {};
+    request.faceMask = faceMask;
+    request.patternIndex = -1;
+    request.jsonPattern = pattern;
+    return requestZoneChange(zone, request);
+}
+
+bool LEDManager::clearZone(int zone) {
+    LedZoneRequest request = {};
+    request.clear = true;
+    request.patternIndex = -1;
+    return requestZoneChange(zone, request);
+}
+
+String LEDManager::getZonePatternName(int zone) {
+    if (zone < 0 || zone >= LED_MAX_ZONES) {
+        return "Unknown";
+    }
+    return m_zones[zone].getPatternName();
+}
+
+// 変更要求を登録する（同じゾーンへの未反映の要求は上書きする）
+bool LEDManager::requestZoneChange(int zone, const LedZoneRequest& request) {
+    if (zone < 0 || zone >= LED_MAX_ZONES) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_zoneMutex);
+    m_pendingZones[zone] = request;
+    m_pendingZones[zone].pending = true;
+    return true;
+}
+
+// 未反映の変更要求をゾーンに反映する（描画タスクのフレームの区切り、またはタスク停止中に呼ぶ）
+void LEDManager::applyPendingZoneChanges() {
+    LedZoneRequest requests[LED_MAX_ZONES];
+    {
+        std::lock_guard<std::mutex> lock(m_zoneMutex);
+        memcpy(requests, m_pendingZones, sizeof(requests));
+        for (int i = 0; i < LED_MAX_ZONES; i++) {
+            m_pendingZones[i].pending = false;
         }
+    }
+    
+    // パターンの生成はロックの外で行う
+    for (int i = 0; i < LED_MAX_ZONES; i++) {
+        const LedZoneRequest& request = requests[i];
+        if (!request.pending) continue;
         
-        // JSONパターンフラグを設定
-        m_isJsonPattern = true;
+        if (request.clear) {
+            m_zones[i].clear();
+        } else if (request.jsonPattern != nullptr) {
+            m_zones[i].setJsonPattern(request.jsonPattern);
+            m_zones[i].setFaceMask(request.faceMask);
+        } else {
+            m_zones[i].setBuiltinPattern(request.patternIndex);
+            m_zones[i].setFaceMask(request.faceMask);
+        }
+    }
+}
+
+// JSONパターンを読み込み直す前に、それを参照しているゾーンを外す
+// （読み込みで既存のJSONパターンは解放されるため）。patternを指定するとそのパターンだけ
+void LEDManager::releaseJsonZones(const JsonLedPattern* pattern) {
+    bool usesJson = false;
+    {
+        std::lock_guard<std::mutex> lock(m_zoneMutex);
+        for (int i = 0; i < LED_MAX_ZONES; i++) {
+            if (m_pendingZones[i].pending && m_pendingZones[i].jsonPattern != nullptr &&
+                (pattern == nullptr || m_pendingZones[i].jsonPattern == pattern)) {
+                m_pendingZones[i].pending = false;
+            }
+        }
+    }
+    for (int i = 0; i < LED_MAX_ZONES; i++) {
+        if (pattern == nullptr ? m_zones[i].usesJsonPattern() : m_zones[i].usesJsonPattern(pattern)) {
+            usesJson = true;
+        }
+    }
+    if (!usesJson) return;
+    
+    if (m_isZoneMode) {
+        stopTask();
+        m_isZoneMode = false;
+    }
+    for (int i = 0; i < LED_MAX_ZONES; i++) {
+        if (pattern == nullptr ? m_zones[i].usesJsonPattern() : m_zones[i].usesJsonPattern(pattern)) {
+            m_zones[i].clear();
+        }
+    }
+    Serial.println("LEDManager: Cleared zones using JSON patterns before reloading");
+}
+
+void LEDManager::runZones() {
+    // 既存のタスクがあれば停止
+    stopTask();
+    
+    m_isJsonPattern = false;
+    m_isZoneMode = true;
+    m_playbackGeneration++;
+    
+    // 新しいタスクを作成
+    createTask(zoneTaskWrapper, "ZoneTask");
+}
+
+// ゾーン再生タスク
+// 全ゾーンを1つのフレームに描いてから1回だけ確定する
+void LEDManager::zoneTaskWrapper(void* parameter) {
+    LEDManager* manager = static_cast<LEDManager*>(parameter);
+    
+    Serial.printf("LEDManager: Starting zone playback with %s FPS control (target: %d fps)\n",
+                 manager->m_fpsControlEnabled ? "enabled" : "disabled",
+                 manager->m_targetFps);
+    
+    while (manager->isTaskRunning) {
+        if (manager->m_fpsControlEnabled) {
+            manager->m_fpsController.beginFrame();
+        }
         
-        // 新しいタスクを作成
-        xTaskCreatePinnedToCore(
-            jsonPatternTaskWrapper,
-            "JSONPatternTask",
-            4096,
-            this,
-            1,
-            &ledTaskHandle,
-            1
-        );
+        // ゾーンの変更はフレームの区切りでだけ反映する
+        manager->applyPendingZoneChanges();
         
-        isTaskRunning = true;
+        // どのゾーンにも属さない面は消灯
+        fill_solid(manager->leds, manager->numLeds, CRGB::Black);
+        for (int i = 0; i < LED_MAX_ZONES; i++) {
+            manager->m_zones[i].render(
+                manager->leds,
+                manager->numLeds,
+                manager->ledOffset,
+                manager->numFaces
+            );
+        }
+        manager->show();
         
-        Serial.println("LEDManager: Running JSON pattern: " + patternName);
-        return true;
-    } else {
-        Serial.println("LEDManager: No patterns were loaded");
-        return false;
+        if (manager->m_fpsControlEnabled) {
+            manager->m_fpsController.endFrame();
+        } else {
+            vTaskDelay(50 / portTICK_PERIOD_MS);
+        }
     }
+    
+    // タスク終了時のログ
+    Serial.println("LEDManager: Zone playback task completed");
+    
+    // タスク終了時にフラグをリセット
+    manager->isTaskRunning = false;
+    manager->m_isZoneMode = false;
+    exitTask(manager);
 }
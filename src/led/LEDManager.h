@@ -6,6 +6,20 @@
 #include <ArduinoJson.h>
 #include "Constants.h"
 #include "JsonLEDPatterns.h"
+#include "FireSimulation.h"
+#include "ParticleSystem.h"
+#include "WorldOrientation.h"
+#include "LedOutput.h"
+#include "LedPatternRegistry.h"
+#include "LedZone.h"
+#include "LinearLight.h"
+#include "FrameBudgetWatchdog.h"
+#include "LedDiagnostics.h"
+#include <mutex>
+#include "LedPatternState.h"
+
+// FPS制御が無効なときのJSONパターンのフレームの間隔（ms）
+#define LED_JSON_FRAME_INTERVAL_MS 20
 
 // FPS制御クラス
 class FpsController {
@@ -82,35 +96,23 @@ public:
 };
 
 // LEDパターンの抽象基底クラス
+// パターンは不変の定義で、再生ごとの状態はLedPatternState（と必要なら拡張状態）に持つ。
+// そのため1つのパターンを複数の再生で同時に使える。
 class LedPattern {
-protected:
-    // パターン状態の保持用変数
-    unsigned long m_patternStartTime;
-    int m_currentStep;
-    bool m_isFirstFrame;
-    
 public:
-    LedPattern() : m_currentStep(0), m_isFirstFrame(true) {}
+    virtual ~LedPattern() {}
     
     // 従来のrun()メソッド（下位互換性のため維持）
-    virtual void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) {
-        m_patternStartTime = millis();
-        m_currentStep = 0;
-        m_isFirstFrame = true;
-        
-        while (millis() - m_patternStartTime < (unsigned long)duration || duration == 0) {
-            runFrame(leds, numLeds, ledOffset, numFaces);
-            // 従来の実装では各パターンが独自に遅延を管理
-            vTaskDelay(50 / portTICK_PERIOD_MS); // デフォルト遅延
-        }
-    }
+    virtual void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const;
     
     // 新しいフレームベースのメソッド（FPS制御用）
-    virtual void runFrame(CRGB* leds, int numLeds, int ledOffset, int numFaces) {
+    // バッファに1フレーム分を描くだけで、出力（LedOutputRouter::show）は呼び出し側が行う
+    virtual void runFrame(LedPatternState& state, LedPatternExtState* ext,
+                          CRGB* leds, int numLeds, int ledOffset, int numFaces) const {
         // 初回フレームの場合は初期化
-        if (m_isFirstFrame) {
-            m_patternStartTime = millis();
-            m_isFirstFrame = false;
+        if (state.firstFrame) {
+            state.startTime = millis();
+            state.firstFrame = false;
         }
         
         // デフォルト実装（派生クラスでオーバーライド）
@@ -118,131 +120,210 @@ public:
         for (int i = 0; i < numLeds; i++) {
             leds[i] = CRGB::Black;
         }
-        FastLED.show();
     }
     
-    virtual void reset() {
-        m_currentStep = 0;
-        m_isFirstFrame = true;
+    // 再生ごとの拡張状態を生成する（不要なパターンはnullptr）
+    virtual LedPatternExtState* createExtState() const { return nullptr; }
+    
+    virtual String getName() const = 0;
+};
+
+// パターン1回分の再生（定義への参照 + 再生状態）
+class LedPatternInstance {
+public:
+    LedPatternInstance() : m_pattern(nullptr), m_ext(nullptr), m_seed(0) { m_state.reset(); }
+    ~LedPatternInstance() { delete m_ext; }
+    
+    // 再生するパターンを設定し、状態を初期化する
+    void attach(const LedPattern* pattern) {
+        delete m_ext;
+        m_pattern = pattern;
+        m_ext = pattern ? pattern->createExtState() : nullptr;
+        m_state.reset(m_seed);
     }
     
-    virtual String getName() = 0;
-    virtual ~LedPattern() {}
+    void reset() { m_state.reset(m_seed); }
+    
+    // 再生状態（状態 + 拡張状態の区間）をスナップショットに書く
+    void save(LedSnapshotWriter& out, uint32_t now) const {
+        m_state.save(out, now);
+        size_t section = out.beginSection();
+        if (m_ext) {
+            m_ext->saveSnapshot(out);
+        }
+        out.endSection(section);
+    }
+    
+    // スナップショットから再生状態を戻す。失敗したら最初から再生する状態にしてfalse
+    bool restore(LedSnapshotReader& in, uint32_t now, int numFaces) {
+        if (!m_pattern) return false;
+        delete m_ext;
+        m_ext = m_pattern->createExtState();
+        
+        LedPatternState state = m_state;
+        LedSnapshotReader extIn = state.load(in, now) ? in.section() : in;
+        if (in.ok() && extIn.ok() && (m_ext == nullptr || m_ext->loadSnapshot(extIn, numFaces))) {
+            m_state = state;
+            return true;
+        }
+        
+        // 読みかけの拡張状態は捨てる
+        attach(m_pattern);
+        return false;
+    }
+    
+    // 乱数のシード（0以外なら再生のたびに同じ乱数列になる。反映は次のreset()から）
+    void setSeed(uint32_t seed) { m_seed = seed; }
+    
+    void runFrame(CRGB* leds, int numLeds, int ledOffset, int numFaces) {
+        if (m_pattern) {
+            m_pattern->runFrame(m_state, m_ext, leds, numLeds, ledOffset, numFaces);
+        }
+    }
+    
+    const LedPattern* getPattern() const { return m_pattern; }
+    LedPatternState& getState() { return m_state; }
+    
+private:
+    LedPatternInstance(const LedPatternInstance&);
+    LedPatternInstance& operator=(const LedPatternInstance&);
+    
+    const LedPattern* m_pattern;
+    LedPatternState m_state;
+    LedPatternExtState* m_ext;
+    uint32_t m_seed;
 };
 
 // 各パターンクラスはLedPatternを継承して実装
 class SequentialPattern : public LedPattern {
-private:
-    unsigned long m_lastStepTime;
-    
 public:
-    SequentialPattern() : m_lastStepTime(0) {}
-    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) override;
-    void runFrame(CRGB* leds, int numLeds, int ledOffset, int numFaces) override;
-    String getName() override { return "Sequential"; }
+    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const override;
+    void runFrame(LedPatternState& state, LedPatternExtState* ext,
+                  CRGB* leds, int numLeds, int ledOffset, int numFaces) const override;
+    String getName() const override { return "Sequential"; }
 };
 
 class OnOffPattern : public LedPattern {
-private:
-    unsigned long m_lastStepTime;
-    
 public:
-    OnOffPattern() : m_lastStepTime(0) {}
-    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) override;
-    void runFrame(CRGB* leds, int numLeds, int ledOffset, int numFaces) override;
-    String getName() override { return "On/Off"; }
+    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const override;
+    void runFrame(LedPatternState& state, LedPatternExtState* ext,
+                  CRGB* leds, int numLeds, int ledOffset, int numFaces) const override;
+    String getName() const override { return "On/Off"; }
 };
 
 class OddEvenPattern : public LedPattern {
 public:
-    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) override;
-    String getName() override { return "Odd/Even"; }
+    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const override;
+    String getName() const override { return "Odd/Even"; }
 };
 
 class RandomPattern : public LedPattern {
 public:
-    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) override;
-    String getName() override { return "Random"; }
+    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const override;
+    String getName() const override { return "Random"; }
 };
 
 class WavePattern : public LedPattern {
 public:
-    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) override;
-    String getName() override { return "Wave"; }
+    void runFrame(LedPatternState& state, LedPatternExtState* ext,
+                  CRGB* leds, int numLeds, int ledOffset, int numFaces) const override;
+    String getName() const override { return "Wave"; }
 };
 
 class RainbowPattern : public LedPattern {
 public:
-    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) override;
-    void runFrame(CRGB* leds, int numLeds, int ledOffset, int numFaces) override;
-    String getName() override { return "Rainbow"; }
+    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const override;
+    void runFrame(LedPatternState& state, LedPatternExtState* ext,
+                  CRGB* leds, int numLeds, int ledOffset, int numFaces) const override;
+    String getName() const override { return "Rainbow"; }
 };
 
 class StrobePattern : public LedPattern {
-private:
-    unsigned long m_lastStepTime;
-    
 public:
-    StrobePattern() : m_lastStepTime(0) {}
-    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) override;
-    void runFrame(CRGB* leds, int numLeds, int ledOffset, int numFaces) override;
-    String getName() override { return "Strobe"; }
+    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const override;
+    void runFrame(LedPatternState& state, LedPatternExtState* ext,
+                  CRGB* leds, int numLeds, int ledOffset, int numFaces) const override;
+    String getName() const override { return "Strobe"; }
 };
 
+// 1個のパーティクルが面を順に移動するチェイス
 class ChasePattern : public LedPattern {
 public:
-    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) override;
-    String getName() override { return "Chase"; }
+    void runFrame(LedPatternState& state, LedPatternExtState* ext,
+                  CRGB* leds, int numLeds, int ledOffset, int numFaces) const override;
+    LedPatternExtState* createExtState() const override;
+    String getName() const override { return "Chase"; }
 };
 
 class PulsePattern : public LedPattern {
-private:
-    int m_pulseDirection;
-    
 public:
-    PulsePattern() : m_pulseDirection(1) {}
-    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) override;
-    void runFrame(CRGB* leds, int numLeds, int ledOffset, int numFaces) override;
-    String getName() override { return "Pulse"; }
+    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const override;
+    void runFrame(LedPatternState& state, LedPatternExtState* ext,
+                  CRGB* leds, int numLeds, int ledOffset, int numFaces) const override;
+    String getName() const override { return "Pulse"; }
 };
 
+// 面上で明滅する静止パーティクルによるツインクル
 class TwinklePattern : public LedPattern {
 public:
-    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) override;
-    String getName() override { return "Twinkle"; }
+    void runFrame(LedPatternState& state, LedPatternExtState* ext,
+                  CRGB* leds, int numLeds, int ledOffset, int numFaces) const override;
+    LedPatternExtState* createExtState() const override;
+    String getName() const override { return "Twinkle"; }
 };
 
+// 熱拡散シミュレーションによる炎パターン
 class FireFlickerPattern : public LedPattern {
 public:
-    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) override;
-    void runFrame(CRGB* leds, int numLeds, int ledOffset, int numFaces) override;
-    String getName() override { return "FireFlicker"; }
+    void runFrame(LedPatternState& state, LedPatternExtState* ext,
+                  CRGB* leds, int numLeds, int ledOffset, int numFaces) const override;
+    LedPatternExtState* createExtState() const override;
+    String getName() const override { return "FireFlicker"; }
 };
 
+// 尾を引いて面を周回するパーティクルによるコメット
 class CometPattern : public LedPattern {
 public:
-    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) override;
-    String getName() override { return "Comet"; }
+    void runFrame(LedPatternState& state, LedPatternExtState* ext,
+                  CRGB* leds, int numLeds, int ledOffset, int numFaces) const override;
+    LedPatternExtState* createExtState() const override;
+    String getName() const override { return "Comet"; }
 };
 
 class IndividualRandomPattern : public LedPattern {
 public:
-    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) override;
-    String getName() override { return "Individual Random"; }
+    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const override;
+    String getName() const override { return "Individual Random"; }
+};
+
+// デバイスの向きに追従するパターン（ワールド座標で定義）
+// 重力方向と各面の法線（キャリブレーション値）の内積だけで面の明るさを決める。
+// 向きはWorldOrientationからロックなしで読み、法線は更新されたときだけ読み直す。
+class WorldSpacePattern : public LedPattern {
+public:
+    enum Mode {
+        POOL,         // 下を向いた面に光が溜まる
+        HORIZON,      // 水平な面（地平線）だけが光る
+        UP_GRADIENT   // 下から上へのグラデーション
+    };
+    
+    WorldSpacePattern(Mode mode) : m_mode(mode) {}
+    void runFrame(LedPatternState& state, LedPatternExtState* ext,
+                  CRGB* leds, int numLeds, int ledOffset, int numFaces) const override;
+    LedPatternExtState* createExtState() const override;
+    String getName() const override;
+    
+private:
+    Mode m_mode;
 };
 
 // FPS管理テスト用のパターン
 class FpsTestPattern : public LedPattern {
-private:
-    unsigned long m_lastLogTime;
-    int m_frameCounter;
-    uint8_t m_hue;
-    
 public:
-    FpsTestPattern() : m_lastLogTime(0), m_frameCounter(0), m_hue(0) {}
-    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) override;
-    void runFrame(CRGB* leds, int numLeds, int ledOffset, int numFaces) override;
-    String getName() override { return "FPS Test"; }
+    void run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const override;
+    void runFrame(LedPatternState& state, LedPatternExtState* ext,
+                  CRGB* leds, int numLeds, int ledOffset, int numFaces) const override;
+    String getName() const override { return "FPS Test"; }
 };
 
 class LEDManager {
@@ -251,25 +332,65 @@ private:
     int numLeds;
     int ledOffset;
     int numFaces;
-    LedPattern** patterns;
-    int patternCount;
+    LedPattern* m_activePattern;   // 再生中（または直前に再生した）パターン
+    int m_activePatternIndex;      // m_activePatternのレジストリ上の番号
+    LedPatternInstance m_playback; // m_activePatternの再生状態
     int currentPatternIndex;
     TaskHandle_t ledTaskHandle;
     uint8_t brightness;
-    bool isTaskRunning;  // タスクが実行中かどうかを追跡するフラグ
+    FastLedSink<LED_PIN> m_fastLedSink;  // LEDテープへの出力
+    volatile bool isTaskRunning;  // タスクが実行中かどうかを追跡するフラグ（falseで停止要求）
+    SemaphoreHandle_t m_taskIdle; // 描画タスクがないときに取れるセマフォ（タスクは終了時に返す）
     
     // FPS制御関連
     FpsController m_fpsController;
     uint16_t m_targetFps;
     bool m_fpsControlEnabled;
     
+    // フレーム予算の監視（再生中のパターンの品質低下の段階）
+    FrameBudgetWatchdog m_watchdog;
+    JsonBakedTimeline m_bakedTimeline;  // 最終段階で再生するJSONパターンの焼き込み
+    
     // JSONパターン関連
     JsonPatternManager m_jsonPatternManager;
     bool m_isJsonPattern;  // 現在実行中のパターンがJSONパターンかどうか
+    LedPatternState m_jsonState;  // 再生中のJSONパターンの状態
     int m_currentJsonPatternIndex;  // 現在実行中のJSONパターンのインデックス
     
+    // ゾーン再生関連
+    LedZone m_zones[LED_MAX_ZONES];
+    LedZoneRequest m_pendingZones[LED_MAX_ZONES];  // 次のフレームの区切りで反映する変更
+    std::mutex m_zoneMutex;                        // m_pendingZonesを保護
+    bool m_isZoneMode;  // 現在ゾーン再生中かどうか
+    
+    // trueなら次に開始するタスクは再生状態を初期化しない（スナップショットから再開したとき）
+    volatile bool m_resumePlayback;
+    // 描画タスクが1フレーム分の再生状態を更新する間だけ持つ（snapshotPatternが途中の状態を読まないように）
+    std::mutex m_stateMutex;
+    
+    // JSONパターンの再生位置と速度の変更要求（描画タスクが次のフレームの区切りで反映する）
+    volatile int32_t m_pendingSeekMs;  // -1なら要求なし
+    volatile uint16_t m_pendingSpeed;  // 0なら要求なし（LED_SPEED_ONEが1倍）
+    volatile bool m_playingBaked;      // 再生中のJSONパターンが焼き込んだタイムラインに切り替わったか
+    volatile uint32_t m_playbackGeneration;  // 再生の開始・停止を明示的に行った回数
+    
     static void ledTaskWrapper(void* parameter);
     static void jsonPatternTaskWrapper(void* parameter);
+    static void zoneTaskWrapper(void* parameter);
+    void createTask(TaskFunction_t task, const char* name);
+    static void exitTask(LEDManager* manager);
+    void stopTask();
+    void writeSnapshot(std::vector<uint8_t>& snapshot);
+    bool updateFrameBudget(const String& patternName, uint32_t frameUs);
+    bool requestZoneChange(int zone, const LedZoneRequest& request);
+    void applyPendingZoneChanges();
+    void releaseJsonZones(const JsonLedPattern* pattern = nullptr);
+    void releaseJsonPattern(const JsonLedPattern* pattern = nullptr);
+    void applyPendingPlayback(const JsonLedPattern* pattern, LedPatternState& state);
+    bool startPattern(int patternIndex, LedSnapshotReader* resume);
+    bool startJsonPattern(int index, LedSnapshotReader* resume);
+    // 1つのファイル（ストリーム）からJSONパターンを読み込む
+    int loadJsonPatternStream(Stream& input, const String& source);
 
 public:
     LEDManager();
@@ -280,7 +401,9 @@ public:
     void lightFace(int faceId, CRGB color);
     CRGB getFaceColor(int faceId);
     void resetAllLeds();
-    int getPatternCount() { return patternCount; }
+    // 現在のバッファを確定し、登録済みの全出力先に書き込む
+    void show();
+    int getPatternCount() { return LedPatternRegistry::getCount(); }
     void nextPattern();
     void prevPattern();
     String getPatternName(int index);
@@ -295,20 +418,81 @@ public:
     uint16_t getActualFps() const;
     void enableFpsControl(bool enable);
     bool isFpsControlEnabled() const;
+    // 再生中のパターンの品質低下の段階（フレーム予算の超過が続くと上がる）
+    FrameBudgetWatchdog::Stage getDegradationStage() const { return m_watchdog.getStage(); }
     
     // JSONパターン関連のメソッド
     bool loadJsonPatternsFromFile(const String& filename);
     bool loadJsonPatternsFromString(const String& jsonString);
     bool loadJsonPatternsFromDirectory(const String& dirPath);
+    // ホストでコンパイルしたパターンのパック（JsonPatternPack）を読み込む（JSONは解析しない）
+    bool loadJsonPatternPack(const String& filename);
     int getJsonPatternCount();
     String getJsonPatternName(int index);
     void runJsonPattern(const String& patternName);
+    // パターンを1つずつ追加・差し替え・削除する（名前で識別。他のパターンは解析し直さない）
+    // 再生中やゾーンで使用中のパターンを差し替え・削除すると、その再生は止まる。
+    bool putJsonPattern(const String& jsonString);
+    bool putJsonPattern(const JsonObject& patternObj);
+    bool removeJsonPattern(const String& patternName);
     void runJsonPatternByIndex(int index);
     bool isJsonPatternRunning() { return m_isJsonPattern && isPatternRunning(); }
     
+    // 再生中のJSONパターンの位置の移動と再生速度
+    // 位置を移動できるのは1周の長さが決まるパターン（ステップの長さが固定か、シードを指定したもの）だけ。
+    // 位置はパターンの時刻で再生開始から数えたms。速度は0.25〜8倍。
+    // 焼き込んだタイムラインの再生に切り替わった後は、位置も速度も変えられない（falseを返す）。
+    bool isJsonPlaybackBaked() { return isJsonPatternRunning() && m_playingBaked; }
+    bool seekJsonPattern(uint32_t positionMs);
+    bool setJsonPlaybackSpeed(float speed);
+    static bool isValidPlaybackSpeed(float speed) {
+        return speed * LED_SPEED_ONE >= LED_SPEED_MIN && speed * LED_SPEED_ONE <= LED_SPEED_MAX;
+    }
+    float getJsonPlaybackSpeed();
+    uint32_t getJsonPlaybackPosition();
+    // 再生中のパターンの1周の長さ（位置を移動できなければ0）
+    uint32_t getJsonTimelineLength();
+    
+    // 再生状態のスナップショット（ステップ・位相・乱数・パーティクルなど）
+    // suspendPatternは再生を止めて状態をバイト列に書き出し、resumePatternはそこから続きを再生する。
+    // snapshotPatternは再生を止めずに書き出す（フレームの区切りで読むので描画中の状態にはならない）。
+    // 時刻は保存時点からの経過時間で持つので、止めていた間は進まない。別のユニットへの引き継ぎにも使える。
+    // ゾーン再生は対象外（falseを返す）。
+    bool suspendPattern(std::vector<uint8_t>& snapshot);
+    bool snapshotPattern(std::vector<uint8_t>& snapshot);
+    bool resumePattern(const std::vector<uint8_t>& snapshot);
+    // 再生の世代（再生の開始・停止を明示的に行うたびに増える）
+    // スナップショットを取った後に、誰かが再生を選び直したり止めたりしたかを見分けるのに使う
+    uint32_t getPlaybackGeneration() const { return m_playbackGeneration; }
+    
     // 受信したJSONパターンを実行するメソッド
     bool runJsonPatternFromFile(const String& filename);
     
+    // ゾーン再生（面の集合ごとに別のパターンを再生し、1つのタスクで1フレームに合成する）
+    // faceMaskのビットiが面iに対応する。ゾーンが重なる面は番号の大きいゾーンが優先。
+    // 変更は再生中でも受け付け、描画タスクが次のフレームの区切りで反映する。
+    bool setZonePattern(int zone, uint32_t faceMask, int patternIndex);
+    bool setZoneJsonPattern(int zone, uint32_t faceMask, const String& patternName);
+    bool clearZone(int zone);
+    void runZones();
+    bool isZonePlaybackRunning() { return m_isZoneMode && isPatternRunning(); }
+    String getZonePatternName(int zone);
+    
+    // 出力先（LEDテープ以外のファイル・UDP・端末など）の追加と削除
+    bool addOutputSink(LedOutputSink* sink);
+    bool removeOutputSink(LedOutputSink* sink);
+    
+    // パレットの"audio"インデックスに使う音量レベル（0-255）
+    void setAudioLevel(uint8_t level) { PaletteColor::setAudioLevel(level); }
+    // JSONパターンの式の band0〜band7（0-255）と beat に使うBPM
+    void setAudioBands(const uint8_t* levels, float bpm) { LedExpression::setAudioBands(levels, bpm); }
+    // マイクを止めたときに呼ぶ: 音量・帯域・BPMを0に戻す（最後の値のまま残さない）
+    void clearAudioInput() {
+        const uint8_t silence[8] = {0};
+        setAudioLevel(0);
+        setAudioBands(silence, 0);
+    }
+    
     // ゲッターメソッド
     CRGB* getLeds() { return leds; }
     int getNumLeds() { return numLeds; }
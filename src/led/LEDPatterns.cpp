@@ -1,7 +1,22 @@
 #include "LEDManager.h"
 
+// 従来のrun()の共通実装
+// 1回分の再生状態をローカルに持ち、runFrame()と出力を一定間隔で繰り返す
+void LedPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const {
+    LedPatternInstance instance;
+    instance.attach(this);
+    
+    unsigned long startTime = millis();
+    while (millis() - startTime < (unsigned long)duration || duration == 0) {
+        instance.runFrame(leds, numLeds, ledOffset, numFaces);
+        LedOutputRouter::getInstance().show(leds, numLeds);
+        // 従来の実装では各パターンが独自に遅延を管理
+        vTaskDelay(50 / portTICK_PERIOD_MS); // デフォルト遅延
+    }
+}
+
 // シーケンシャルパターンの実装
-void SequentialPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) {
+void SequentialPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const {
     for (int i = 0; i < numFaces; i++) {
         for (int j = 0; j < numFaces; j++) {
             int idx1 = ledOffset + (j * 2);
@@ -14,7 +29,7 @@ void SequentialPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces
                 leds[idx2] = CRGB::Black;
             }
         }
-        FastLED.show();
+        LedOutputRouter::getInstance().show(leds, numLeds);
         for (int k = 0; k < 10; k++) {
             vTaskDelay(100 / portTICK_PERIOD_MS);
         }
@@ -22,7 +37,7 @@ void SequentialPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces
 }
 
 // On/Offパターンの実装
-void OnOffPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) {
+void OnOffPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const {
     bool state = true;
     unsigned long startTime = millis();
     while (millis() - startTime < duration) {
@@ -37,7 +52,7 @@ void OnOffPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int
                 leds[idx2] = CRGB::Black;
             }
         }
-        FastLED.show();
+        LedOutputRouter::getInstance().show(leds, numLeds);
         state = !state;
         for (int k = 0; k < 10; k++) {
             vTaskDelay(100 / portTICK_PERIOD_MS);
@@ -46,7 +61,7 @@ void OnOffPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int
 }
 
 // 奇数/偶数パターンの実装
-void OddEvenPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) {
+void OddEvenPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const {
     bool toggle = false;
     unsigned long startTime = millis();
     while (millis() - startTime < duration) {
@@ -72,98 +87,30 @@ void OddEvenPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, i
                 }
             }
         }
-        FastLED.show();
+        LedOutputRouter::getInstance().show(leds, numLeds);
         vTaskDelay(1000 / portTICK_PERIOD_MS);
     }
 }
 
 // ランダムパターンの実装
-void RandomPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) {
+void RandomPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const {
     unsigned long startTime = millis();
+    LedRandom random = LedRandom::withSeed(esp_random());
     while (millis() - startTime < duration) {
         for (int i = 0; i < numFaces; i++) {
             int idx1 = ledOffset + (i * 2);
             int idx2 = ledOffset + (i * 2) + 1;
-            CRGB randColor = CRGB(random(256), random(256), random(256));
+            CRGB randColor = CRGB(random.next8(), random.next8(), random.next8());
             leds[idx1] = randColor;
             leds[idx2] = randColor;
         }
-        FastLED.show();
+        LedOutputRouter::getInstance().show(leds, numLeds);
         vTaskDelay(500 / portTICK_PERIOD_MS);
     }
 }
 
-// ウェーブパターンの実装
-void WavePattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) {
-    unsigned long startTime = millis();
-    uint8_t wavePos = 0;
-    
-    // 明るさのテーブルを直接定義（デバッグ用に明確な値を使用）
-    uint8_t brightnessTable[8] = {255, 220, 180, 140, 100, 140, 180, 220};
-    
-    Serial.println("WavePattern: Starting pattern");
-    Serial.printf("WavePattern: numLeds=%d, ledOffset=%d, numFaces=%d\n", numLeds, ledOffset, numFaces);
-    
-    // 最初に全LEDを消灯して状態を確認
-    for (int i = 0; i < numLeds; i++) {
-        leds[i] = CRGB::Black;
-    }
-    FastLED.show();
-    Serial.println("WavePattern: All LEDs set to black");
-    vTaskDelay(500 / portTICK_PERIOD_MS);
-    
-    // テスト用に全LEDを白色に点灯
-    for (int i = 0; i < numLeds; i++) {
-        leds[i] = CRGB::White;
-    }
-    FastLED.show();
-    Serial.println("WavePattern: All LEDs set to white for testing");
-    vTaskDelay(500 / portTICK_PERIOD_MS);
-    
-    while (millis() - startTime < duration) {
-        // デバッグ出力
-        Serial.println("WavePattern: Updating LEDs");
-        
-        // 各フェイスの明るさを更新
-        for (int i = 0; i < numFaces; i++) {
-            int idx1 = ledOffset + (i * 2);
-            int idx2 = ledOffset + (i * 2) + 1;
-            
-            // インデックスの範囲チェック
-            if (idx1 >= numLeds || idx2 >= numLeds) {
-                Serial.printf("WavePattern: Index out of range - idx1=%d, idx2=%d, numLeds=%d\n", idx1, idx2, numLeds);
-                continue;
-            }
-            
-            // 現在の位置に基づいて明るさを取得
-            int brightnessIndex = (i + wavePos) % 8;
-            uint8_t brightnessVal = brightnessTable[brightnessIndex];
-            
-            // デバッグ出力
-            Serial.printf("WavePattern: Face %d (idx1=%d, idx2=%d): Brightness %d\n", i, idx1, idx2, brightnessVal);
-            
-            // 青色をベースに明るさを適用
-            CRGB color = CRGB::Blue;
-            color.nscale8_video(brightnessVal);
-            
-            leds[idx1] = color;
-            leds[idx2] = color;
-        }
-        
-        FastLED.show();
-        
-        // 波の位置を更新
-        wavePos = (wavePos + 1) % 8;
-        
-        // 更新頻度
-        vTaskDelay(100 / portTICK_PERIOD_MS);
-    }
-    
-    Serial.println("WavePattern: Pattern completed");
-}
-
 // レインボーパターンの実装
-void RainbowPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) {
+void RainbowPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const {
     uint8_t hue = 0;
     unsigned long startTime = millis();
     while (millis() - startTime < duration) {
@@ -175,14 +122,14 @@ void RainbowPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, i
             leds[idx1] = color;
             leds[idx2] = color;
         }
-        FastLED.show();
+        LedOutputRouter::getInstance().show(leds, numLeds);
         hue++;  // hue を徐々に増加させる
         vTaskDelay(50 / portTICK_PERIOD_MS);
     }
 }
 
 // ストロボパターンの実装
-void StrobePattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) {
+void StrobePattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const {
     unsigned long startTime = millis();
     bool state = false;
     while (millis() - startTime < duration) {
@@ -197,37 +144,14 @@ void StrobePattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, in
                 leds[idx2] = CRGB::Black;
             }
         }
-        FastLED.show();
+        LedOutputRouter::getInstance().show(leds, numLeds);
         state = !state;
         vTaskDelay(100 / portTICK_PERIOD_MS);
     }
 }
 
-// チェイスパターンの実装
-void ChasePattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) {
-    unsigned long startTime = millis();
-    while (millis() - startTime < duration) {
-        for (int i = 0; i < numFaces; i++) {
-            // まず全面を消灯
-            for (int j = 0; j < numFaces; j++) {
-                int idx1 = ledOffset + (j * 2);
-                int idx2 = ledOffset + (j * 2) + 1;
-                leds[idx1] = CRGB::Black;
-                leds[idx2] = CRGB::Black;
-            }
-            // face i を点灯
-            int idx1 = ledOffset + (i * 2);
-            int idx2 = ledOffset + (i * 2) + 1;
-            leds[idx1] = CRGB::White;
-            leds[idx2] = CRGB::White;
-            FastLED.show();
-            vTaskDelay(300 / portTICK_PERIOD_MS);
-        }
-    }
-}
-
 // パルスパターンの実装
-void PulsePattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) {
+void PulsePattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const {
     unsigned long startTime = millis();
     while (millis() - startTime < duration) {
         // 明るくするフェーズ
@@ -240,7 +164,7 @@ void PulsePattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int
                 leds[idx1].nscale8_video(b);
                 leds[idx2].nscale8_video(b);
             }
-            FastLED.show();
+            LedOutputRouter::getInstance().show(leds, numLeds);
             vTaskDelay(30 / portTICK_PERIOD_MS);
         }
         // 暗くするフェーズ
@@ -253,91 +177,23 @@ void PulsePattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int
                 leds[idx1].nscale8_video(b);
                 leds[idx2].nscale8_video(b);
             }
-            FastLED.show();
+            LedOutputRouter::getInstance().show(leds, numLeds);
             vTaskDelay(30 / portTICK_PERIOD_MS);
         }
     }
 }
 
-// ツインクルパターンの実装
-void TwinklePattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) {
-    unsigned long startTime = millis();
-    while (millis() - startTime < duration) {
-        for (int i = 0; i < numFaces; i++) {
-            int idx1 = ledOffset + (i * 2);
-            int idx2 = ledOffset + (i * 2) + 1;
-            // 50%の確率でツインクル
-            if (random(100) < 50) {
-                uint8_t bright = random(50, 255);
-                CRGB color = CRGB::White;
-                color.nscale8_video(bright);
-                leds[idx1] = color;
-                leds[idx2] = color;
-            } else {
-                leds[idx1] = CRGB::Black;
-                leds[idx2] = CRGB::Black;
-            }
-        }
-        FastLED.show();
-        vTaskDelay(100 / portTICK_PERIOD_MS);
-    }
-}
-
-// 炎のちらつきパターンの実装
-void FireFlickerPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) {
-    unsigned long startTime = millis();
-    while (millis() - startTime < duration) {
-        for (int i = 0; i < numFaces; i++) {
-            int idx1 = ledOffset + (i * 2);
-            int idx2 = ledOffset + (i * 2) + 1;
-            // flicker 値で明るさをランダムに決定
-            uint8_t flicker = random(100, 255);
-            // 炎っぽさを出すため、赤を主体に、緑は flicker の 0～値の一部、青はゼロ
-            CRGB color = CRGB(flicker, random(0, flicker / 2), 0);
-            leds[idx1] = color;
-            leds[idx2] = color;
-        }
-        FastLED.show();
-        vTaskDelay(50 / portTICK_PERIOD_MS);
-    }
-}
-
-// コメットパターンの実装
-void CometPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) {
-    // まず全LEDを消灯
-    for (int i = ledOffset; i < numLeds; i++) {
-        leds[i] = CRGB::Black;
-    }
-    FastLED.show();
-    unsigned long startTime = millis();
-    int cometPos = 0;
-    while (millis() - startTime < duration) {
-        // 各ループごとに全LEDを少しフェードさせる
-        for (int i = ledOffset; i < numLeds; i++) {
-            leds[i].nscale8_video(200); // 約20%程度の減衰（調整可能）
-        }
-        // 現在のコメット位置の面を白色で点灯
-        int idx1 = ledOffset + (cometPos * 2);
-        int idx2 = ledOffset + (cometPos * 2) + 1;
-        leds[idx1] = CRGB::White;
-        leds[idx2] = CRGB::White;
-        
-        FastLED.show();
-        vTaskDelay(100 / portTICK_PERIOD_MS);
-        cometPos = (cometPos + 1) % numFaces;
-    }
-}
-
 // 個別ランダムパターンの実装
-void IndividualRandomPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) {
+void IndividualRandomPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const {
     unsigned long startTime = millis();
+    LedRandom random = LedRandom::withSeed(esp_random());
     while (millis() - startTime < duration) {
         for (int i = 0; i < numFaces; i++) {
             int idx1 = ledOffset + (i * 2);
             int idx2 = ledOffset + (i * 2) + 1;
             // 50%の確率でランダムな色にする、そうでなければ消灯
-            if (random(100) < 50) {
-                CRGB randColor = CRGB(random(256), random(256), random(256));
+            if (random.below(100) < 50) {
+                CRGB randColor = CRGB(random.next8(), random.next8(), random.next8());
                 leds[idx1] = randColor;
                 leds[idx2] = randColor;
             } else {
@@ -345,7 +201,7 @@ void IndividualRandomPattern::run(CRGB* leds, int numLeds, int ledOffset, int nu
                 leds[idx2] = CRGB::Black;
             }
         }
-        FastLED.show();
+        LedOutputRouter::getInstance().show(leds, numLeds);
         vTaskDelay(100 / portTICK_PERIOD_MS);
     }
 }
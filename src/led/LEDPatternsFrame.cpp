@@ -1,204 +1,473 @@
 #include "LEDManager.h"
+#include "FaceLayout.h"
+
+namespace {
+
+// 面ごとに色を塗る描画ループ（dispatchFaceLayoutで面配置ごとに展開する）
+
+// 全面を同じ色にする
+struct FillFacesOp {
+    FillFacesOp(CRGB* leds, const CRGB& color) : leds(leds), color(color) {}
+    template <typename Layout>
+    void operator()(const Layout& layout) const {
+        for (int i = 0; i < layout.faceCount(); i++) {
+            layout.setFace(leds, i, color);
+        }
+    }
+    CRGB* leds;
+    CRGB color;
+};
+
+// 面0からlastLitまでを点灯し、残りを消灯する
+struct LitPrefixOp {
+    LitPrefixOp(CRGB* leds, int lastLit) : leds(leds), lastLit(lastLit) {}
+    template <typename Layout>
+    void operator()(const Layout& layout) const {
+        for (int i = 0; i < layout.faceCount(); i++) {
+            layout.setFace(leds, i, i <= lastLit ? CRGB(CRGB::White) : CRGB(CRGB::Black));
+        }
+    }
+    CRGB* leds;
+    int lastLit;
+};
+
+// 面ごとに色相をずらして塗る（spreadEvenlyなら全面で色相環を一周、それ以外は面ごとに32ずつ）
+struct HueRingOp {
+    HueRingOp(CRGB* leds, uint8_t baseHue, bool spreadEvenly) : leds(leds), baseHue(baseHue), spreadEvenly(spreadEvenly) {}
+    template <typename Layout>
+    void operator()(const Layout& layout) const {
+        for (int i = 0; i < layout.faceCount(); i++) {
+            uint8_t offset = spreadEvenly ? (uint8_t)(i * 256 / layout.faceCount()) : (uint8_t)(i * 32);
+            layout.setFace(leds, i, CHSV(baseHue + offset, 255, 255));
+        }
+    }
+    CRGB* leds;
+    uint8_t baseHue;
+    bool spreadEvenly;
+};
+
+// パーティクルを使うパターンの拡張状態
+class ParticleExtState : public LedPatternExtState {
+public:
+    explicit ParticleExtState(int capacity) : particles(capacity) {}
+    void saveSnapshot(LedSnapshotWriter& out) const override { particles.save(out); }
+    bool loadSnapshot(LedSnapshotReader& in, int numFaces) override { return particles.load(in, numFaces); }
+    ParticleSystem particles;
+};
+
+// 炎パターンの拡張状態
+class FireExtState : public LedPatternExtState {
+public:
+    void saveSnapshot(LedSnapshotWriter& out) const override { fire.save(out); }
+    bool loadSnapshot(LedSnapshotReader& in, int numFaces) override { return fire.load(in); }
+    FireSimulation fire;
+};
+
+// 向きに追従するパターンの拡張状態（重力方向と法線のキャッシュ）
+class WorldSpaceExtState : public LedPatternExtState {
+public:
+    WorldSpaceExtState() : hasGravity(false), normalMask(0), normalsVersion(0) {}
+    float gravity[3];
+    bool hasGravity;
+    float normals[ORIENTATION_MAX_FACES][3];
+    uint32_t normalMask;
+    uint32_t normalsVersion;
+};
+
+} // namespace
 
 // SequentialPatternのフレームベース実装
-void SequentialPattern::runFrame(CRGB* leds, int numLeds, int ledOffset, int numFaces) {
+void SequentialPattern::runFrame(LedPatternState& state, LedPatternExtState* ext, CRGB* leds, int numLeds, int ledOffset, int numFaces) const {
     // 初回フレームの場合は初期化
-    if (m_isFirstFrame) {
-        m_patternStartTime = millis();
-        m_currentStep = 0;
-        m_isFirstFrame = false;
-        m_lastStepTime = millis();
+    if (state.firstFrame) {
+        state.startTime = millis();
+        state.step = 0;
+        state.firstFrame = false;
+        state.lastStepTime = millis();
     }
     
     // ステップ間の時間（1秒）が経過したら次のステップへ
     unsigned long currentTime = millis();
-    if (currentTime - m_lastStepTime >= 1000) {
-        m_currentStep = (m_currentStep + 1) % numFaces;
-        m_lastStepTime = currentTime;
+    if (currentTime - state.lastStepTime >= 1000) {
+        state.step = (state.step + 1) % numFaces;
+        state.lastStepTime = currentTime;
     }
     
     // 現在のステップに基づいてLEDを更新
-    for (int j = 0; j < numFaces; j++) {
-        int idx1 = ledOffset + (j * 2);
-        int idx2 = ledOffset + (j * 2) + 1;
-        if (j <= m_currentStep) {
-            leds[idx1] = CRGB::White;
-            leds[idx2] = CRGB::White;
-        } else {
-            leds[idx1] = CRGB::Black;
-            leds[idx2] = CRGB::Black;
-        }
-    }
-    FastLED.show();
+    LitPrefixOp op(leds, state.step);
+    dispatchFaceLayout(numLeds, ledOffset, numFaces, op);
 }
 
-// RainbowPatternのフレームベース実装
-void RainbowPattern::runFrame(CRGB* leds, int numLeds, int ledOffset, int numFaces) {
+// WavePatternのフレームベース実装
+void WavePattern::runFrame(LedPatternState& state, LedPatternExtState* ext, CRGB* leds, int numLeds, int ledOffset, int numFaces) const {
     // 初回フレームの場合は初期化
-    if (m_isFirstFrame) {
-        m_patternStartTime = millis();
-        m_currentStep = 0; // hue値として使用
-        m_isFirstFrame = false;
+    if (state.firstFrame) {
+        state.startTime = millis();
+        state.firstFrame = false;
     }
     
-    // 各面に対してhueを適用
-    for (int i = 0; i < numFaces; i++) {
+    // 面0を波源として、隣接面づたいの距離を求める（面数が少ないので毎フレーム求める）
+    uint8_t distances[FACE_TOPOLOGY_MAX_FACES];
+    FaceTopology::forFaceCount(numFaces).computeDistances(0, distances);
+    
+    // 明るさのテーブル（1周8段階）
+    static const uint8_t brightnessTable[8] = {255, 220, 180, 140, 100, 140, 180, 220};
+    
+    // 100msごとに1段階ずつ、波源から外側へ波が広がる
+    uint8_t wavePos = (millis() - state.startTime) / 100;
+    
+    for (int i = 0; i < numFaces && i < FACE_TOPOLOGY_MAX_FACES; i++) {
         int idx1 = ledOffset + (i * 2);
         int idx2 = ledOffset + (i * 2) + 1;
-        // 各面に対して hue にオフセットを加える
-        CRGB color = CHSV(m_currentStep + i * 32, 255, 255);
+        if (idx2 >= numLeds) break;
+        
+        // 青色をベースに距離に応じた明るさを適用
+        CRGB color = CRGB::Blue;
+        color.nscale8_video(brightnessTable[(uint8_t)(wavePos - distances[i]) % 8]);
         leds[idx1] = color;
         leds[idx2] = color;
     }
-    FastLED.show();
+}
+
+// RainbowPatternのフレームベース実装
+void RainbowPattern::runFrame(LedPatternState& state, LedPatternExtState* ext, CRGB* leds, int numLeds, int ledOffset, int numFaces) const {
+    // 初回フレームの場合は初期化
+    if (state.firstFrame) {
+        state.startTime = millis();
+        state.step = 0; // hue値として使用
+        state.firstFrame = false;
+    }
+    
+    // 各面に対して hue にオフセットを加えて適用
+    HueRingOp op(leds, state.step, false);
+    dispatchFaceLayout(numLeds, ledOffset, numFaces, op);
     
     // hueを徐々に増加
-    m_currentStep = (m_currentStep + 1) % 256;
+    state.step = (state.step + 1) % 256;
 }
 
 // OnOffPatternのフレームベース実装
-void OnOffPattern::runFrame(CRGB* leds, int numLeds, int ledOffset, int numFaces) {
+void OnOffPattern::runFrame(LedPatternState& state, LedPatternExtState* ext, CRGB* leds, int numLeds, int ledOffset, int numFaces) const {
     // 初回フレームの場合は初期化
-    if (m_isFirstFrame) {
-        m_patternStartTime = millis();
-        m_currentStep = 0; // 0=OFF, 1=ON
-        m_isFirstFrame = false;
-        m_lastStepTime = millis();
+    if (state.firstFrame) {
+        state.startTime = millis();
+        state.step = 0; // 0=OFF, 1=ON
+        state.firstFrame = false;
+        state.lastStepTime = millis();
     }
     
     // 状態切り替えの時間（1秒）が経過したら状態を切り替え
     unsigned long currentTime = millis();
-    if (currentTime - m_lastStepTime >= 1000) {
-        m_currentStep = (m_currentStep + 1) % 2; // 0と1を交互に
-        m_lastStepTime = currentTime;
+    if (currentTime - state.lastStepTime >= 1000) {
+        state.step = (state.step + 1) % 2; // 0と1を交互に
+        state.lastStepTime = currentTime;
     }
     
-    // 現在の状態に基づいてLEDを更新
-    for (int i = 0; i < numFaces; i++) {
-        int idx1 = ledOffset + (i * 2);
-        int idx2 = ledOffset + (i * 2) + 1;
-        if (m_currentStep == 1) { // ON状態
-            leds[idx1] = CRGB::White;
-            leds[idx2] = CRGB::White;
-        } else { // OFF状態
-            leds[idx1] = CRGB::Black;
-            leds[idx2] = CRGB::Black;
-        }
-    }
-    FastLED.show();
+    // 現在の状態に基づいてLEDを更新（1=ON, 0=OFF）
+    FillFacesOp op(leds, state.step == 1 ? CRGB(CRGB::White) : CRGB(CRGB::Black));
+    dispatchFaceLayout(numLeds, ledOffset, numFaces, op);
 }
 
 // StrobePatternのフレームベース実装
-void StrobePattern::runFrame(CRGB* leds, int numLeds, int ledOffset, int numFaces) {
+void StrobePattern::runFrame(LedPatternState& state, LedPatternExtState* ext, CRGB* leds, int numLeds, int ledOffset, int numFaces) const {
     // 初回フレームの場合は初期化
-    if (m_isFirstFrame) {
-        m_patternStartTime = millis();
-        m_currentStep = 0; // 0=OFF, 1=ON
-        m_isFirstFrame = false;
-        m_lastStepTime = millis();
+    if (state.firstFrame) {
+        state.startTime = millis();
+        state.step = 0; // 0=OFF, 1=ON
+        state.firstFrame = false;
+        state.lastStepTime = millis();
     }
     
     // 状態切り替えの時間（100ms）が経過したら状態を切り替え
     unsigned long currentTime = millis();
-    if (currentTime - m_lastStepTime >= 100) {
-        m_currentStep = (m_currentStep + 1) % 2; // 0と1を交互に
-        m_lastStepTime = currentTime;
+    if (currentTime - state.lastStepTime >= 100) {
+        state.step = (state.step + 1) % 2; // 0と1を交互に
+        state.lastStepTime = currentTime;
     }
     
-    // 現在の状態に基づいてLEDを更新
-    for (int i = 0; i < numFaces; i++) {
-        int idx1 = ledOffset + (i * 2);
-        int idx2 = ledOffset + (i * 2) + 1;
-        if (m_currentStep == 1) { // ON状態
-            leds[idx1] = CRGB::White;
-            leds[idx2] = CRGB::White;
-        } else { // OFF状態
-            leds[idx1] = CRGB::Black;
-            leds[idx2] = CRGB::Black;
-        }
-    }
-    FastLED.show();
+    // 現在の状態に基づいてLEDを更新（1=ON, 0=OFF）
+    FillFacesOp op(leds, state.step == 1 ? CRGB(CRGB::White) : CRGB(CRGB::Black));
+    dispatchFaceLayout(numLeds, ledOffset, numFaces, op);
 }
 
 // PulsePatternのフレームベース実装
-void PulsePattern::runFrame(CRGB* leds, int numLeds, int ledOffset, int numFaces) {
+void PulsePattern::runFrame(LedPatternState& state, LedPatternExtState* ext, CRGB* leds, int numLeds, int ledOffset, int numFaces) const {
     // 初回フレームの場合は初期化
-    if (m_isFirstFrame) {
-        m_patternStartTime = millis();
-        m_currentStep = 0; // 明るさ値として使用
-        m_isFirstFrame = false;
-        m_pulseDirection = 1; // 1=明るくする, -1=暗くする
+    if (state.firstFrame) {
+        state.startTime = millis();
+        state.step = 0; // 明るさ値として使用
+        state.firstFrame = false;
+        state.direction = 1; // 1=明るくする, -1=暗くする
     }
     
     // 明るさを更新
-    if (m_pulseDirection > 0) {
-        m_currentStep += 5;
-        if (m_currentStep >= 255) {
-            m_currentStep = 255;
-            m_pulseDirection = -1;
+    if (state.direction > 0) {
+        state.step += 5;
+        if (state.step >= 255) {
+            state.step = 255;
+            state.direction = -1;
         }
     } else {
-        m_currentStep -= 5;
-        if (m_currentStep <= 0) {
-            m_currentStep = 0;
-            m_pulseDirection = 1;
+        state.step -= 5;
+        if (state.step <= 0) {
+            state.step = 0;
+            state.direction = 1;
         }
     }
     
     // 現在の明るさに基づいてLEDを更新
-    for (int i = 0; i < numFaces; i++) {
-        int idx1 = ledOffset + (i * 2);
-        int idx2 = ledOffset + (i * 2) + 1;
-        leds[idx1] = CRGB::White;
-        leds[idx2] = CRGB::White;
-        leds[idx1].nscale8_video(m_currentStep);
-        leds[idx2].nscale8_video(m_currentStep);
-    }
-    FastLED.show();
+    CRGB color = CRGB::White;
+    color.nscale8_video(state.step);
+    FillFacesOp op(leds, color);
+    dispatchFaceLayout(numLeds, ledOffset, numFaces, op);
+}
+
+// FireFlickerPatternの拡張状態（炎の熱量）
+LedPatternExtState* FireFlickerPattern::createExtState() const {
+    return new FireExtState();
 }
 
 // FireFlickerPatternのフレームベース実装
-void FireFlickerPattern::runFrame(CRGB* leds, int numLeds, int ledOffset, int numFaces) {
+void FireFlickerPattern::runFrame(LedPatternState& state, LedPatternExtState* ext, CRGB* leds, int numLeds, int ledOffset, int numFaces) const {
+    if (ext == nullptr) return;
+    FireSimulation& fire = static_cast<FireExtState*>(ext)->fire;
+    
     // 初回フレームの場合は初期化
-    if (m_isFirstFrame) {
-        m_patternStartTime = millis();
-        m_isFirstFrame = false;
+    if (state.firstFrame) {
+        state.startTime = millis();
+        state.firstFrame = false;
+        state.lastStepTime = 0;
+        
+        // 面ごとに2つのLED、面0を火元として隣接面づたいに炎の配置を構築
+        fire.begin(FaceTopology::forFaceCount(numFaces), 2, 0);
     }
     
-    // 各面に対してランダムなちらつきを適用
-    for (int i = 0; i < numFaces; i++) {
+    // シミュレーションは約60Hzで進め、目標FPSが変わっても炎の速さを保つ
+    unsigned long currentTime = millis();
+    if (state.lastStepTime == 0 || currentTime - state.lastStepTime >= 16) {
+        fire.update(state.random);
+        state.lastStepTime = currentTime;
+    }
+    
+    // 熱量をヒートパレットで色に変換
+    fire.render(leds, ledOffset);
+}
+
+// ChasePatternの拡張状態（パーティクル1個）
+LedPatternExtState* ChasePattern::createExtState() const {
+    return new ParticleExtState(1);
+}
+
+// ChasePatternのフレームベース実装
+void ChasePattern::runFrame(LedPatternState& state, LedPatternExtState* ext, CRGB* leds, int numLeds, int ledOffset, int numFaces) const {
+    if (ext == nullptr) return;
+    ParticleSystem& particles = static_cast<ParticleExtState*>(ext)->particles;
+    
+    // 初回フレームの場合は初期化
+    if (state.firstFrame) {
+        state.startTime = millis();
+        state.firstFrame = false;
+        state.lastFrameTime = state.startTime;
+        
+        // 300msごとに1面進む白いパーティクル（面の間は補間しない）
+        particles.clear();
+        particles.setTourPath(FaceTopology::forFaceCount(numFaces));
+        particles.setInterpolation(false);
+        particles.spawn(0, 256 * 1000 / 300, 0, CRGB::White);
+    }
+    
+    unsigned long currentTime = millis();
+    particles.update(currentTime - state.lastFrameTime);
+    state.lastFrameTime = currentTime;
+    
+    // 全面を消灯してからパーティクルを描画
+    for (int i = ledOffset; i < numLeds; i++) {
+        leds[i] = CRGB::Black;
+    }
+    particles.render(leds, ledOffset, 2);
+}
+
+// TwinklePatternの拡張状態（同時に光るパーティクル最大32個）
+LedPatternExtState* TwinklePattern::createExtState() const {
+    return new ParticleExtState(32);
+}
+
+// TwinklePatternのフレームベース実装
+void TwinklePattern::runFrame(LedPatternState& state, LedPatternExtState* ext, CRGB* leds, int numLeds, int ledOffset, int numFaces) const {
+    if (ext == nullptr) return;
+    ParticleSystem& particles = static_cast<ParticleExtState*>(ext)->particles;
+    
+    // 初回フレームの場合は初期化
+    if (state.firstFrame) {
+        state.startTime = millis();
+        state.firstFrame = false;
+        state.lastFrameTime = state.startTime;
+        state.accumulator = 0;
+        
+        particles.clear();
+        particles.setTourPath(FaceTopology::forFaceCount(numFaces));
+    }
+    
+    unsigned long currentTime = millis();
+    uint16_t dt = currentTime - state.lastFrameTime;
+    state.lastFrameTime = currentTime;
+    particles.update(dt);
+    
+    // 平均寿命400msで常に約半数の面が光るよう、1秒あたり面数×1.25個を生成
+    state.accumulator += (uint32_t)dt * numFaces;
+    while (state.accumulator >= 800) {
+        state.accumulator -= 800;
+        CRGB color = CRGB::White;
+        color.nscale8_video(state.random.next8(50, 255));
+        particles.spawn(state.random.next8(numFaces) << 8, 0, state.random.next16(200, 600), color, ParticleSystem::TRIANGLE);
+    }
+    
+    // 全面を消灯してからパーティクルを描画
+    for (int i = ledOffset; i < numLeds; i++) {
+        leds[i] = CRGB::Black;
+    }
+    particles.render(leds, ledOffset, 2);
+}
+
+// CometPatternの拡張状態（パーティクル1個）
+LedPatternExtState* CometPattern::createExtState() const {
+    return new ParticleExtState(1);
+}
+
+// CometPatternのフレームベース実装
+void CometPattern::runFrame(LedPatternState& state, LedPatternExtState* ext, CRGB* leds, int numLeds, int ledOffset, int numFaces) const {
+    if (ext == nullptr) return;
+    ParticleSystem& particles = static_cast<ParticleExtState*>(ext)->particles;
+    
+    // 初回フレームの場合は初期化
+    if (state.firstFrame) {
+        state.startTime = millis();
+        state.firstFrame = false;
+        state.lastFrameTime = state.startTime;
+        
+        // 1秒で10面進む白いパーティクル
+        particles.clear();
+        particles.setTourPath(FaceTopology::forFaceCount(numFaces));
+        particles.spawn(0, 10 * 256, 0, CRGB::White);
+        
+        // まず全LEDを消灯
+        for (int i = ledOffset; i < numLeds; i++) {
+            leds[i] = CRGB::Black;
+        }
+    }
+    
+    unsigned long currentTime = millis();
+    uint16_t dt = currentTime - state.lastFrameTime;
+    state.lastFrameTime = currentTime;
+    
+    // 尾: 線形光で100msあたり約40%減衰（見た目では約20%。FPSに依存しないよう経過時間で減衰量を決める）
+    // 線形光で減衰させると暗部でも段差なく消えていく
+    uint8_t fade = std::min<uint32_t>((uint32_t)dt, 255);
+    LinearLight::fadeToBlackBy(leds + ledOffset, numLeds - ledOffset, fade);
+    
+    particles.update(dt);
+    particles.render(leds, ledOffset, 2);
+}
+
+// WorldSpacePatternのフレームベース実装
+void WorldSpacePattern::runFrame(LedPatternState& state, LedPatternExtState* ext, CRGB* leds, int numLeds, int ledOffset, int numFaces) const {
+    if (ext == nullptr) return;
+    WorldSpaceExtState* cache = static_cast<WorldSpaceExtState*>(ext);
+    WorldOrientation& orientation = WorldOrientation::getInstance();
+    
+    // 初回フレームの場合は初期化
+    if (state.firstFrame) {
+        state.startTime = millis();
+        state.firstFrame = false;
+        cache->hasGravity = false;
+        cache->normalMask = 0;
+        cache->normalsVersion = orientation.getNormalsVersion() + 1; // 必ず読み込ませる
+    }
+    
+    // 法線はキャリブレーションで変わったときだけ読み直す
+    uint32_t version = orientation.getNormalsVersion();
+    if (version != cache->normalsVersion) {
+        orientation.readFaceNormals(cache->normals, ORIENTATION_MAX_FACES, cache->normalMask, cache->normalsVersion);
+    }
+    
+    // 重力方向（書き込み中に当たった場合は前回の値を使う）
+    if (orientation.readGravity(cache->gravity)) {
+        cache->hasGravity = true;
+    }
+    
+    for (int i = 0; i < numFaces && i < ORIENTATION_MAX_FACES; i++) {
         int idx1 = ledOffset + (i * 2);
         int idx2 = ledOffset + (i * 2) + 1;
-        // flicker 値で明るさをランダムに決定
-        uint8_t flicker = random(100, 255);
-        // 炎っぽさを出すため、赤を主体に、緑は flicker の 0～値の一部、青はゼロ
-        CRGB color = CRGB(flicker, random(0, flicker / 2), 0);
+        if (idx2 >= numLeds) break;
+        
+        // 未キャリブレーションの面、または向きが未取得の場合は暗く点灯
+        if (!cache->hasGravity || !(cache->normalMask & (1UL << i))) {
+            leds[idx1] = CRGB(16, 16, 16);
+            leds[idx2] = CRGB(16, 16, 16);
+            continue;
+        }
+        
+        // 1.0: 真下を向いている、0.0: 水平、-1.0: 真上を向いている
+        const float* n = cache->normals[i];
+        float down = cache->gravity[0] * n[0] + cache->gravity[1] * n[1] + cache->gravity[2] * n[2];
+        
+        CRGB color;
+        switch (m_mode) {
+            case POOL: {
+                // 下向きの面ほど明るく（2乗で底に集める）
+                float level = down > 0.0f ? down * down : 0.0f;
+                color = CHSV(150, 200, (uint8_t)(level * 255.0f));
+                break;
+            }
+            case HORIZON: {
+                // 水平から約20度以内の面を光らせる
+                float tilt = fabsf(down);
+                float level = tilt < 0.35f ? 1.0f - tilt / 0.35f : 0.0f;
+                color = CHSV(30, 180, (uint8_t)(level * 255.0f));
+                break;
+            }
+            case UP_GRADIENT:
+            default: {
+                // 下（赤）から上（青）へ（線形光で補間して中間が暗く濁らないようにする）
+                uint8_t height = (uint8_t)((1.0f - down) * 127.5f);
+                color = LinearLight::blend(CRGB(255, 40, 0), CRGB(0, 80, 255), height);
+                break;
+            }
+        }
         leds[idx1] = color;
         leds[idx2] = color;
     }
-    FastLED.show();
+}
+
+// WorldSpacePatternの拡張状態（重力方向と法線のキャッシュ）
+LedPatternExtState* WorldSpacePattern::createExtState() const {
+    return new WorldSpaceExtState();
+}
+
+String WorldSpacePattern::getName() const {
+    switch (m_mode) {
+        case POOL: return "World Pool";
+        case HORIZON: return "World Horizon";
+        case UP_GRADIENT:
+        default: return "World Gradient";
+    }
 }
 
 // FpsTestPatternの実装
-void FpsTestPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) {
-    // 初期化
-    m_lastLogTime = millis();
-    m_frameCounter = 0;
-    m_hue = 0;
-    
-    // 親クラスのrun()メソッドを呼び出す（runFrame()を使用）
+void FpsTestPattern::run(CRGB* leds, int numLeds, int ledOffset, int numFaces, int duration) const {
+    // 親クラスのrun()メソッドを呼び出す（runFrame()を使用、状態は初回フレームで初期化）
     LedPattern::run(leds, numLeds, ledOffset, numFaces, duration);
 }
 
 // FpsTestPatternのフレームベース実装
-void FpsTestPattern::runFrame(CRGB* leds, int numLeds, int ledOffset, int numFaces) {
+void FpsTestPattern::runFrame(LedPatternState& state, LedPatternExtState* ext, CRGB* leds, int numLeds, int ledOffset, int numFaces) const {
     // 初回フレームの場合は初期化
-    if (m_isFirstFrame) {
-        m_patternStartTime = millis();
-        m_lastLogTime = millis();
-        m_frameCounter = 0;
-        m_hue = 0;
-        m_isFirstFrame = false;
+    if (state.firstFrame) {
+        state.startTime = millis();
+        state.lastStepTime = millis();
+        state.accumulator = 0;
+        state.step = 0;
+        state.firstFrame = false;
         
         // 初期状態をログ出力
         Serial.println("FpsTestPattern: Starting FPS test");
@@ -206,34 +475,22 @@ void FpsTestPattern::runFrame(CRGB* leds, int numLeds, int ledOffset, int numFac
     }
     
     // フレームカウンターを更新
-    m_frameCounter++;
+    state.accumulator++;
     
     // 1秒ごとにFPS情報をログ出力
     unsigned long currentTime = millis();
-    if (currentTime - m_lastLogTime >= 1000) {
-        float fps = m_frameCounter * 1000.0f / (currentTime - m_lastLogTime);
+    if (currentTime - state.lastStepTime >= 1000) {
+        float fps = state.accumulator * 1000.0f / (currentTime - state.lastStepTime);
         Serial.printf("FpsTestPattern: FPS = %.2f (frames: %d, time: %lu ms)\n", 
-                     fps, m_frameCounter, currentTime - m_lastLogTime);
-        m_lastLogTime = currentTime;
-        m_frameCounter = 0;
+                     fps, state.accumulator, currentTime - state.lastStepTime);
+        state.lastStepTime = currentTime;
+        state.accumulator = 0;
     }
     
-    // 各面に対して色相を変化させながら色を適用
-    for (int i = 0; i < numFaces; i++) {
-        int idx1 = ledOffset + (i * 2);
-        int idx2 = ledOffset + (i * 2) + 1;
-        
-        // 各面に異なる色相を適用（色相環を一周）
-        uint8_t faceHue = m_hue + (i * 256 / numFaces);
-        CRGB color = CHSV(faceHue, 255, 255);
-        
-        leds[idx1] = color;
-        leds[idx2] = color;
-    }
+    // 各面に異なる色相を適用（色相環を一周）
+    HueRingOp op(leds, state.step, true);
+    dispatchFaceLayout(numLeds, ledOffset, numFaces, op);
     
     // 色相を徐々に変化させる
-    m_hue++;
-    
-    // LEDを更新
-    FastLED.show();
+    state.step++;
 }
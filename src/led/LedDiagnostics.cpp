@@ -0,0 +1,68 @@
+#include "LedDiagnostics.h"
+#include "FrameBudgetWatchdog.h"
+
+LedDiagnostics& LedDiagnostics::getInstance() {
+    static LedDiagnostics instance;
+    return instance;
+}
+
+LedDiagnostics::LedDiagnostics() : m_head(0), m_count(0), m_totalCount(0) {
+}
+
+void LedDiagnostics::record(LedDiagnosticEvent::Type type, const String& pattern, uint8_t stage,
+                            uint32_t frameUs, uint32_t budgetUs) {
+    LedDiagnosticEvent event;
+    event.timeMs = millis();
+    event.frameUs = frameUs;
+    event.budgetUs = budgetUs;
+    event.type = type;
+    event.stage = stage;
+    strncpy(event.pattern, pattern.c_str(), sizeof(event.pattern) - 1);
+    event.pattern[sizeof(event.pattern) - 1] = '\0';
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_events[m_head] = event;
+        m_head = (m_head + 1) % LED_DIAGNOSTICS_CAPACITY;
+        if (m_count < LED_DIAGNOSTICS_CAPACITY) {
+            m_count++;
+        }
+        m_totalCount++;
+    }
+
+    Serial.printf("LedDiagnostics: %s '%s' stage=%s frame=%luus budget=%luus\n",
+                 getTypeName(type), event.pattern,
+                 FrameBudgetWatchdog::getStageName((FrameBudgetWatchdog::Stage)stage),
+                 (unsigned long)frameUs, (unsigned long)budgetUs);
+}
+
+int LedDiagnostics::copyEvents(LedDiagnosticEvent* out, int maxEvents) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int count = min(m_count, maxEvents);
+    // 古い順: 書き込み位置からm_count個前が最も古い
+    int start = (m_head - m_count + LED_DIAGNOSTICS_CAPACITY) % LED_DIAGNOSTICS_CAPACITY;
+    int skip = m_count - count;
+    for (int i = 0; i < count; i++) {
+        out[i] = m_events[(start + skip + i) % LED_DIAGNOSTICS_CAPACITY];
+    }
+    return count;
+}
+
+uint32_t LedDiagnostics::getTotalCount() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_totalCount;
+}
+
+void LedDiagnostics::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_head = 0;
+    m_count = 0;
+}
+
+const char* LedDiagnostics::getTypeName(LedDiagnosticEvent::Type type) {
+    switch (type) {
+        case LedDiagnosticEvent::DEGRADED:         return "degraded";
+        case LedDiagnosticEvent::BAKE_UNAVAILABLE: return "bake-unavailable";
+        default:                                   return "unknown";
+    }
+}
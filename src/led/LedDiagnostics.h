@@ -0,0 +1,54 @@
+#ifndef LED_DIAGNOSTICS_H
+#define LED_DIAGNOSTICS_H
+
+#include <Arduino.h>
+#include <mutex>
+
+// 保持する診断イベントの数（古いものから上書き）
+#define LED_DIAGNOSTICS_CAPACITY 32
+
+// LEDエンジンの診断イベント（フレーム予算の超過による品質低下など）
+struct LedDiagnosticEvent {
+    enum Type : uint8_t {
+        DEGRADED = 0,       // フレーム予算の超過が続いて段階を上げた
+        BAKE_UNAVAILABLE    // 焼き込みに対応していないので段階を上げられなかった
+    };
+
+    uint32_t timeMs;        // 発生時刻（起動からのms）
+    uint32_t frameUs;       // 直近の超過フレームの処理時間
+    uint32_t budgetUs;      // フレーム予算
+    Type type;
+    uint8_t stage;          // 変更後の段階（FrameBudgetWatchdog::Stage）
+    char pattern[24];       // パターン名（切り詰め）
+};
+
+// 診断イベントのリングバッファ
+// 描画タスクが記録し、Web APIなどが読み出す。現場で重いパターンを特定するためのもの。
+class LedDiagnostics {
+public:
+    static LedDiagnostics& getInstance();
+
+    void record(LedDiagnosticEvent::Type type, const String& pattern, uint8_t stage,
+                uint32_t frameUs, uint32_t budgetUs);
+
+    // 古い順にコピーする（コピーした数を返す）
+    int copyEvents(LedDiagnosticEvent* out, int maxEvents);
+    // 起動してからの記録の総数（上書きされたものも含む）
+    uint32_t getTotalCount();
+    void clear();
+
+    static const char* getTypeName(LedDiagnosticEvent::Type type);
+
+private:
+    LedDiagnostics();
+    LedDiagnostics(const LedDiagnostics&);
+    LedDiagnostics& operator=(const LedDiagnostics&);
+
+    std::mutex m_mutex;
+    LedDiagnosticEvent m_events[LED_DIAGNOSTICS_CAPACITY];
+    int m_head;         // 次に書き込む位置
+    int m_count;
+    uint32_t m_totalCount;
+};
+
+#endif // LED_DIAGNOSTICS_H
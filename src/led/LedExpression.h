@@ -0,0 +1,433 @@
+#ifndef LED_EXPRESSION_H
+#define LED_EXPRESSION_H
+
+#include <Arduino.h>
+#include <math.h>
+#include <cmath>
+#include <string.h>
+#include <vector>
+#include "LedSnapshot.h"
+
+// 式の評価に使うスタックの深さと、1つの式の命令列・定数の上限
+#define LED_EXPR_STACK_SIZE 16
+#define LED_EXPR_MAX_CODE 255
+#define LED_EXPR_MAX_CONSTANTS 64
+
+// JSONパターンの値に書ける小さな式（例: "t*0.1 + face*32"）
+// 読み込み時にスタックマシンの命令列に変換し、描画ではLEDごと・フレームごとに評価する。
+// 評価は固定長の配列のスタックだけを使い、メモリを確保しない。値はfloat（ESP32-S3はFPUを持つ）。
+//
+//   演算子: + - * / %（%は除数と同じ符号の剰余）、単項の -、括弧
+//   関数:   sin(x) cos(x)（ラジアン） abs(x) floor(x) min(a, b) max(a, b)
+//   変数:   t（再生開始からのms） face（面の番号） led（パターンの先頭からのLEDの番号）
+//           beat（拍の位相 0-1） audio（音量 0-255） band0〜band7（周波数帯ごとの音量 0-255）
+class LedExpression {
+public:
+    // 変数の番号（evaluate()に渡す配列の位置）
+    enum Variable : uint8_t {
+        VAR_T,
+        VAR_FACE,
+        VAR_LED,
+        VAR_BEAT,
+        VAR_AUDIO,
+        VAR_BAND0,
+        VAR_COUNT = VAR_BAND0 + 8
+    };
+
+    LedExpression() : m_source(nullptr), m_pos(0), m_depth(0), m_lastConstAt(-1), m_prevConstAt(-1) {}
+
+    // 式を命令列に変換する（失敗したらfalseで、errorに理由と位置）
+    bool compile(const char* source, String& error) {
+        m_code.clear();
+        m_constants.clear();
+        m_source = source;
+        m_pos = 0;
+        m_error = "";
+        m_depth = 0;
+        m_lastConstAt = m_prevConstAt = -1;
+
+        parseSum();
+        skipSpaces();
+        if (m_error.length() == 0 && m_source[m_pos] != '\0') {
+            fail("unexpected character");
+        }
+        if (m_error.length() == 0 && m_code.size() > LED_EXPR_MAX_CODE) {
+            m_error = "expression is too long";
+        }
+        m_source = nullptr;
+        if (m_error.length() > 0) {
+            error = m_error;
+            m_code.clear();
+            m_constants.clear();
+            return false;
+        }
+        return true;
+    }
+
+    // 変数の値（VAR_COUNT個）を渡して評価する
+    float evaluate(const float* vars) const {
+        float stack[LED_EXPR_STACK_SIZE];
+        int sp = 0;
+        const uint8_t* pc = m_code.data();
+        const uint8_t* end = pc + m_code.size();
+        while (pc < end) {
+            switch (*pc++) {
+                case OP_CONST: stack[sp++] = m_constants[*pc++]; break;
+                case OP_VAR:   stack[sp++] = vars[*pc++]; break;
+                case OP_ADD:   sp--; stack[sp - 1] += stack[sp]; break;
+                case OP_SUB:   sp--; stack[sp - 1] -= stack[sp]; break;
+                case OP_MUL:   sp--; stack[sp - 1] *= stack[sp]; break;
+                case OP_DIV:   sp--; stack[sp - 1] = divide(stack[sp - 1], stack[sp]); break;
+                case OP_MOD:   sp--; stack[sp - 1] = modulo(stack[sp - 1], stack[sp]); break;
+                case OP_MIN:   sp--; stack[sp - 1] = min(stack[sp - 1], stack[sp]); break;
+                case OP_MAX:   sp--; stack[sp - 1] = max(stack[sp - 1], stack[sp]); break;
+                case OP_NEG:   stack[sp - 1] = -stack[sp - 1]; break;
+                case OP_SIN:   stack[sp - 1] = sinf(stack[sp - 1]); break;
+                case OP_COS:   stack[sp - 1] = cosf(stack[sp - 1]); break;
+                case OP_ABS:   stack[sp - 1] = fabsf(stack[sp - 1]); break;
+                case OP_FLOOR: stack[sp - 1] = floorf(stack[sp - 1]); break;
+            }
+        }
+        return sp > 0 ? stack[0] : 0.0f;
+    }
+
+    bool isEmpty() const { return m_code.empty(); }
+    size_t getCodeSize() const { return m_code.size(); }
+    // 1回の評価で実行する命令の数
+    size_t getInstructionCount() const {
+        size_t count = 0;
+        for (size_t pc = 0; pc < m_code.size(); pc++, count++) {
+            if (m_code[pc] == OP_CONST || m_code[pc] == OP_VAR) pc++;
+        }
+        return count;
+    }
+
+    // バイナリ形式（JsonPatternPack）への書き出しと読み込み（読み込んだ命令列は検証する）
+    void save(LedSnapshotWriter& out) const {
+        out.put8(m_code.size());
+        out.putBytes(m_code.data(), m_code.size());
+        out.put8(m_constants.size());
+        for (float value : m_constants) {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            out.put32(bits);
+        }
+    }
+
+    bool load(LedSnapshotReader& in) {
+        m_code.resize(in.get8());
+        in.getBytes(m_code.data(), m_code.size());
+        m_constants.resize(in.get8());
+        for (size_t i = 0; i < m_constants.size(); i++) {
+            uint32_t bits = in.get32();
+            memcpy(&m_constants[i], &bits, sizeof(bits));
+        }
+        return in.ok() && verify();
+    }
+
+    // 値を色の成分にする（色相は一周で折り返し、それ以外は0-255に収める）
+    // NaNと無限大（t*t*t*t*tの桁あふれやinf-infなど）は0にする（NaNはconstrainを素通りし、整数への変換が未定義になる）
+    static uint8_t toHue(float value) {
+        if (!std::isfinite(value)) return 0;
+        return (uint8_t)((int32_t)floorf(constrain(value, -1.0e9f, 1.0e9f)) & 0xFF);
+    }
+    static uint8_t toLevel(float value) {
+        if (!std::isfinite(value)) return 0;
+        return (uint8_t)constrain(value, 0.0f, 255.0f);
+    }
+
+    // 音の入力（マイクのタスクから更新し、描画タスクが読む）
+    static void setAudioBands(const uint8_t* levels, float bpm) {
+        for (int i = 0; i < 8; i++) {
+            audioInputs().bands[i] = levels[i];
+        }
+        audioInputs().bpm = bpm;
+    }
+
+    // 1フレーム分の共通の変数（t、beat、audio、band0〜7）を埋める（faceとledは呼び出し側が埋める）
+    static void loadFrameInputs(float* vars, uint32_t timeMs, uint8_t audioLevel) {
+        const volatile AudioInputs& audio = audioInputs();
+        vars[VAR_T] = (float)timeMs;
+        vars[VAR_FACE] = 0.0f;
+        vars[VAR_LED] = 0.0f;
+        float beats = (float)timeMs * audio.bpm / 60000.0f;
+        vars[VAR_BEAT] = beats - floorf(beats);
+        vars[VAR_AUDIO] = audioLevel;
+        for (int i = 0; i < 8; i++) {
+            vars[VAR_BAND0 + i] = audio.bands[i];
+        }
+    }
+
+private:
+    enum Op : uint8_t {
+        OP_CONST,   // 続く1バイトが定数の番号
+        OP_VAR,     // 続く1バイトが変数の番号
+        OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD, OP_MIN, OP_MAX,
+        OP_NEG, OP_SIN, OP_COS, OP_ABS, OP_FLOOR,
+        OP_COUNT
+    };
+
+    struct AudioInputs {
+        uint8_t bands[8];
+        float bpm;
+    };
+
+    static volatile AudioInputs& audioInputs() {
+        static volatile AudioInputs inputs = {{0}, 0.0f};
+        return inputs;
+    }
+
+    static float divide(float a, float b) {
+        return b == 0.0f ? 0.0f : a / b;
+    }
+    static float modulo(float a, float b) {
+        if (b == 0.0f) return 0.0f;
+        float r = fmodf(a, b);
+        return (r != 0.0f && (r < 0.0f) != (b < 0.0f)) ? r + b : r;
+    }
+
+    // 命令列がスタックをあふれさせず、最後に値を1つ残すかを調べる
+    bool verify() {
+        int depth = 0;
+        for (size_t pc = 0; pc < m_code.size(); pc++) {
+            uint8_t op = m_code[pc];
+            if (op == OP_CONST || op == OP_VAR) {
+                if (pc + 1 >= m_code.size()) return false;
+                uint8_t operand = m_code[++pc];
+                if (op == OP_CONST ? operand >= m_constants.size() : operand >= VAR_COUNT) return false;
+                depth++;
+            } else if (op <= OP_MAX) {
+                depth--;
+            } else if (op >= OP_COUNT) {
+                return false;
+            }
+            if (depth < 1 || depth > LED_EXPR_STACK_SIZE) return false;
+        }
+        return depth == 1;
+    }
+
+    // ---- 構文解析（再帰下降。命令を後置順に出力する） ----
+    // sum := product (('+' | '-') product)*
+    // product := unary (('*' | '/' | '%') unary)*
+    // unary := '-' unary | primary
+    // primary := number | name | name '(' sum (',' sum)* ')' | '(' sum ')'
+
+    void parseSum() {
+        parseProduct();
+        for (;;) {
+            skipSpaces();
+            char c = m_source[m_pos];
+            if (c != '+' && c != '-') return;
+            m_pos++;
+            parseProduct();
+            emitBinary(c == '+' ? OP_ADD : OP_SUB);
+        }
+    }
+
+    void parseProduct() {
+        parseUnary();
+        for (;;) {
+            skipSpaces();
+            char c = m_source[m_pos];
+            if (c != '*' && c != '/' && c != '%') return;
+            m_pos++;
+            parseUnary();
+            emitBinary(c == '*' ? OP_MUL : c == '/' ? OP_DIV : OP_MOD);
+        }
+    }
+
+    void parseUnary() {
+        skipSpaces();
+        if (m_source[m_pos] == '-') {
+            m_pos++;
+            parseUnary();
+            emitUnary(OP_NEG);
+            return;
+        }
+        parsePrimary();
+    }
+
+    void parsePrimary() {
+        if (m_error.length() > 0) return;
+        skipSpaces();
+        char c = m_source[m_pos];
+        if (c == '(') {
+            m_pos++;
+            parseSum();
+            expect(')');
+        } else if (isdigit((unsigned char)c) || c == '.') {
+            char* end = nullptr;
+            float value = strtof(m_source + m_pos, &end);
+            if (end == m_source + m_pos) {
+                fail("invalid number");
+                return;
+            }
+            m_pos = end - m_source;
+            emitConstant(value);
+        } else if (isalpha((unsigned char)c)) {
+            size_t start = m_pos;
+            while (isalnum((unsigned char)m_source[m_pos])) m_pos++;
+            String name = String(m_source + start).substring(0, m_pos - start);
+            skipSpaces();
+            if (m_source[m_pos] == '(') {
+                m_pos++;
+                parseCall(name, start);
+            } else {
+                int var = findVariable(name);
+                if (var < 0) {
+                    m_pos = start;
+                    fail("unknown variable '" + name + "'");
+                    return;
+                }
+                emitOperand(OP_VAR, var);
+            }
+        } else {
+            fail(c == '\0' ? "unexpected end" : "unexpected character");
+        }
+    }
+
+    void parseCall(const String& name, size_t start) {
+        static const struct { const char* name; Op op; int args; } functions[] = {
+            {"sin", OP_SIN, 1}, {"cos", OP_COS, 1}, {"abs", OP_ABS, 1}, {"floor", OP_FLOOR, 1},
+            {"min", OP_MIN, 2}, {"max", OP_MAX, 2},
+        };
+        for (const auto& function : functions) {
+            if (name == function.name) {
+                for (int i = 0; i < function.args; i++) {
+                    if (i > 0) expect(',');
+                    parseSum();
+                }
+                expect(')');
+                if (function.args == 1) {
+                    emitUnary(function.op);
+                } else {
+                    emitBinary(function.op);
+                }
+                return;
+            }
+        }
+        m_pos = start;
+        fail("unknown function '" + name + "'");
+    }
+
+    static int findVariable(const String& name) {
+        if (name == "t") return VAR_T;
+        if (name == "face") return VAR_FACE;
+        if (name == "led") return VAR_LED;
+        if (name == "beat") return VAR_BEAT;
+        if (name == "audio") return VAR_AUDIO;
+        if (name.length() == 5 && name.startsWith("band") && name[4] >= '0' && name[4] <= '7') {
+            return VAR_BAND0 + (name[4] - '0');
+        }
+        return -1;
+    }
+
+    // ---- 命令の出力（定数どうしの演算はその場で畳み込む） ----
+
+    void emitConstant(float value) {
+        if (m_constants.size() >= LED_EXPR_MAX_CONSTANTS) {
+            fail("too many constants");
+            return;
+        }
+        m_constants.push_back(value);
+        int previous = m_lastConstAt;
+        int at = m_code.size();
+        emitOperand(OP_CONST, m_constants.size() - 1);
+        m_prevConstAt = previous;
+        m_lastConstAt = at;
+    }
+
+    void emitOperand(Op op, int operand) {
+        m_code.push_back(op);
+        m_code.push_back(operand);
+        m_lastConstAt = m_prevConstAt = -1;
+        push(1);
+    }
+
+    void emitUnary(Op op) {
+        if (m_error.length() > 0) return;
+        if (endsWithConstants(1)) {
+            // 定数の読み込みはそのまま残り、値だけが変わる
+            LedExpression folded;
+            const uint8_t code[] = {OP_CONST, 0, op};
+            folded.m_code.assign(code, code + sizeof(code));
+            folded.m_constants.push_back(m_constants.back());
+            m_constants.back() = folded.evaluate(nullptr);
+            return;
+        }
+        m_code.push_back(op);
+        m_lastConstAt = m_prevConstAt = -1;
+    }
+
+    void emitBinary(Op op) {
+        if (m_error.length() > 0) return;
+        if (endsWithConstants(2)) {
+            float b = m_constants.back();
+            m_constants.pop_back();
+            m_code.resize(m_code.size() - 2);
+            float a = m_constants.back();
+            LedExpression folded;
+            const uint8_t code[] = {OP_CONST, 0, OP_CONST, 1, op};
+            folded.m_code.assign(code, code + sizeof(code));
+            folded.m_constants.push_back(a);
+            folded.m_constants.push_back(b);
+            m_constants.back() = folded.evaluate(nullptr);
+            // 畳み込んだ定数の前の命令は記録していないので、次は畳み込まない
+            m_lastConstAt = m_code.size() - 2;
+            m_prevConstAt = -1;
+            push(-1);
+            return;
+        }
+        m_code.push_back(op);
+        m_lastConstAt = m_prevConstAt = -1;
+        push(-1);
+    }
+
+    // 直前に出力した命令（countが2ならその前の命令も）が定数の読み込みか
+    // （命令の境界は出力した位置で覚える。オペランドのバイトは命令と区別できないので見ない）
+    bool endsWithConstants(int count) const {
+        int end = m_code.size();
+        if (m_lastConstAt != end - 2) return false;
+        return count == 1 || m_prevConstAt == end - 4;
+    }
+
+    void push(int delta) {
+        m_depth += delta;
+        if (m_depth > LED_EXPR_STACK_SIZE) {
+            fail("expression is too deep");
+        }
+    }
+
+    void skipSpaces() {
+        while (m_source[m_pos] == ' ' || m_source[m_pos] == '\t') m_pos++;
+    }
+
+    void expect(char c) {
+        skipSpaces();
+        if (m_source[m_pos] != c) {
+            const char quoted[] = {'\'', c, '\'', '\0'};
+            fail(String("expected ") + quoted);
+            return;
+        }
+        m_pos++;
+    }
+
+    void fail(const String& message) {
+        if (m_error.length() == 0) {
+            m_error = message + " at " + String((int)m_pos);
+        }
+    }
+
+    std::vector<uint8_t> m_code;
+    std::vector<float> m_constants;
+
+    // 変換中だけ使う作業用の状態
+    const char* m_source;
+    size_t m_pos;
+    int m_depth;
+    int m_lastConstAt;   // 直前の命令が定数の読み込みならその位置（それ以外は-1）
+    int m_prevConstAt;   // その前の命令が定数の読み込みならその位置（それ以外は-1）
+    String m_error;
+};
+
+#endif // LED_EXPRESSION_H
@@ -0,0 +1,202 @@
+#include "LedOutput.h"
+
+// ---- FileSink ----
+
+FileSink::FileSink(fs::FS& fs, const String& path)
+    : m_fs(fs), m_path(path), m_frameCount(0) {
+}
+
+bool FileSink::begin(int numLeds) {
+    m_file = m_fs.open(m_path, "w");
+    if (!m_file) {
+        Serial.printf("FileSink: Failed to open %s\n", m_path.c_str());
+        return false;
+    }
+
+    uint8_t header[7] = {'L', 'U', 'M', 'F', 1, (uint8_t)(numLeds & 0xFF), (uint8_t)(numLeds >> 8)};
+    m_file.write(header, sizeof(header));
+    m_frameCount = 0;
+    return true;
+}
+
+void FileSink::end() {
+    if (m_file) {
+        m_file.close();
+    }
+}
+
+void FileSink::write(const CRGB* leds, int numLeds, uint8_t brightness) {
+    if (!m_file) return;
+
+    uint32_t timestamp = millis();
+    m_file.write((const uint8_t*)&timestamp, sizeof(timestamp));
+
+    if (brightness == 255) {
+        m_file.write((const uint8_t*)leds, sizeof(CRGB) * numLeds);
+    } else {
+        // 明るさを反映した値を記録する（実機の見た目に合わせる）
+        for (int i = 0; i < numLeds; i++) {
+            CRGB color = leds[i];
+            color.nscale8_video(brightness);
+            m_file.write((const uint8_t*)&color, sizeof(CRGB));
+        }
+    }
+    m_frameCount++;
+}
+
+// ---- UdpSink ----
+
+UdpSink::UdpSink(const IPAddress& host, uint16_t port)
+    : m_host(host), m_port(port), m_sequence(0) {
+}
+
+bool UdpSink::begin(int numLeds) {
+    // 送信専用なので任意のローカルポートでよい
+    m_udp.begin(0);
+    m_sequence = 0;
+    return true;
+}
+
+void UdpSink::end() {
+    m_udp.stop();
+}
+
+void UdpSink::write(const CRGB* leds, int numLeds, uint8_t brightness) {
+    if (!m_udp.beginPacket(m_host, m_port)) return;
+
+    uint8_t header[8] = {
+        'L', 'U', 'M', 'U',
+        (uint8_t)(m_sequence & 0xFF), (uint8_t)(m_sequence >> 8),
+        (uint8_t)(numLeds & 0xFF), (uint8_t)(numLeds >> 8)
+    };
+    m_udp.write(header, sizeof(header));
+
+    for (int i = 0; i < numLeds; i++) {
+        CRGB color = leds[i];
+        color.nscale8_video(brightness);
+        m_udp.write((const uint8_t*)&color, sizeof(CRGB));
+    }
+    m_udp.endPacket();
+    m_sequence++;
+}
+
+// ---- TerminalSink ----
+
+TerminalSink::TerminalSink(Print& out, uint16_t minIntervalMs)
+    : m_out(out), m_minIntervalMs(minIntervalMs), m_lastWriteTime(0) {
+}
+
+void TerminalSink::end() {
+    // 色をリセットして改行
+    m_out.print("\x1b[0m\r\n");
+}
+
+void TerminalSink::write(const CRGB* leds, int numLeds, uint8_t brightness) {
+    unsigned long currentTime = millis();
+    if (m_lastWriteTime != 0 && currentTime - m_lastWriteTime < m_minIntervalMs) {
+        return;
+    }
+    m_lastWriteTime = currentTime;
+
+    // 行頭に戻って同じ行を上書きする（LED1個を背景色付きの空白2文字で表示）
+    m_out.print('\r');
+    char cell[32];
+    for (int i = 0; i < numLeds; i++) {
+        CRGB color = leds[i];
+        color.nscale8_video(brightness);
+        snprintf(cell, sizeof(cell), "\x1b[48;2;%u;%u;%um  ", color.r, color.g, color.b);
+        m_out.print(cell);
+    }
+    m_out.print("\x1b[0m");
+}
+
+// ---- LedOutputRouter ----
+
+LedOutputRouter& LedOutputRouter::getInstance() {
+    static LedOutputRouter instance;
+    return instance;
+}
+
+LedOutputRouter::LedOutputRouter() : m_sinkCount(0), m_brightness(255), m_correctionEnabled(false) {
+    for (int i = 0; i < LED_OUTPUT_MAX_SINKS; i++) {
+        m_sinks[i] = nullptr;
+    }
+    for (int i = 0; i < LED_OUTPUT_MAX_CORRECTED_LEDS; i++) {
+        m_correction[i] = LedColorMatrix::identity();
+    }
+}
+
+bool LedOutputRouter::addSink(LedOutputSink* sink, int numLeds) {
+    if (sink == nullptr) return false;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int count = m_sinkCount.load();
+    for (int i = 0; i < count; i++) {
+        if (m_sinks[i] == sink) return true; // 登録済み
+    }
+    if (count >= LED_OUTPUT_MAX_SINKS) {
+        Serial.printf("LedOutputRouter: Too many sinks, '%s' not added\n", sink->getName());
+        return false;
+    }
+    if (!sink->begin(numLeds)) {
+        Serial.printf("LedOutputRouter: Failed to start sink '%s'\n", sink->getName());
+        return false;
+    }
+
+    // 書き込んでから数を増やす（show()が未設定の要素を読まないように）
+    m_sinks[count] = sink;
+    m_sinkCount.store(count + 1, std::memory_order_release);
+    Serial.printf("LedOutputRouter: Added sink '%s'\n", sink->getName());
+    return true;
+}
+
+bool LedOutputRouter::removeSink(LedOutputSink* sink) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int count = m_sinkCount.load();
+    for (int i = 0; i < count; i++) {
+        if (m_sinks[i] != sink) continue;
+
+        // 先に数を減らしてから登録順を保って詰める
+        m_sinkCount.store(count - 1, std::memory_order_release);
+        for (int j = i; j < count - 1; j++) {
+            m_sinks[j] = m_sinks[j + 1];
+        }
+        m_sinks[count - 1] = nullptr;
+        sink->end();
+        return true;
+    }
+    return false;
+}
+
+void LedOutputRouter::setColorCorrection(int led, const LedColorMatrix& matrix) {
+    if (led < 0 || led >= LED_OUTPUT_MAX_CORRECTED_LEDS) return;
+    m_correction[led] = matrix;
+    m_correctionEnabled = true;
+}
+
+void LedOutputRouter::clearColorCorrection() {
+    m_correctionEnabled = false;
+    for (int i = 0; i < LED_OUTPUT_MAX_CORRECTED_LEDS; i++) {
+        m_correction[i] = LedColorMatrix::identity();
+    }
+}
+
+void LedOutputRouter::show(const CRGB* leds, int numLeds) {
+    // 色補正は確定したフレームのコピーに1パスで掛ける
+    // （補正中に行列が書き換えられても、そのLEDが1フレームだけ新旧どちらかになるだけ）
+    if (m_correctionEnabled && numLeds <= LED_OUTPUT_MAX_CORRECTED_LEDS) {
+        for (int i = 0; i < numLeds; i++) {
+            m_correctedFrame[i] = m_correction[i].apply(leds[i]);
+        }
+        leds = m_correctedFrame;
+    }
+
+    uint8_t brightness = m_brightness;
+    int count = m_sinkCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++) {
+        LedOutputSink* sink = m_sinks[i];
+        if (sink != nullptr) {
+            sink->write(leds, numLeds, brightness);
+        }
+    }
+}
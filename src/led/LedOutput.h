@@ -0,0 +1,200 @@
+#ifndef LED_OUTPUT_H
+#define LED_OUTPUT_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include <FS.h>
+#include <WiFiUdp.h>
+#include <mutex>
+#include <atomic>
+
+// 同時に接続できる出力先の最大数
+#define LED_OUTPUT_MAX_SINKS 4
+// 色補正を適用できるLEDの最大数（これより多いLEDは補正せずに出力する）
+#define LED_OUTPUT_MAX_CORRECTED_LEDS 64
+
+// LED1個ぶんの色補正行列（3×3、Q8固定小数点で256 = 1.0）
+// 出力 = 行列 × (R, G, B)。対角成分だけなら色ごとのゲイン、非対角成分で色ずれも補正できる。
+struct LedColorMatrix {
+    int16_t m[9];
+
+    static LedColorMatrix identity() {
+        LedColorMatrix matrix = {{256, 0, 0, 0, 256, 0, 0, 0, 256}};
+        return matrix;
+    }
+
+    // 浮動小数点の行列（行優先、1.0 = 変化なし）から作る
+    static LedColorMatrix fromFloats(const float values[9]) {
+        LedColorMatrix matrix;
+        for (int i = 0; i < 9; i++) {
+            float v = values[i] * 256.0f;
+            v = v > 32767.0f ? 32767.0f : (v < -32768.0f ? -32768.0f : v);
+            matrix.m[i] = (int16_t)(v >= 0 ? v + 0.5f : v - 0.5f);
+        }
+        return matrix;
+    }
+
+    CRGB apply(const CRGB& color) const {
+        return CRGB(
+            channel(m[0] * color.r + m[1] * color.g + m[2] * color.b),
+            channel(m[3] * color.r + m[4] * color.g + m[5] * color.b),
+            channel(m[6] * color.r + m[7] * color.g + m[8] * color.b)
+        );
+    }
+
+private:
+    static uint8_t channel(int32_t value) {
+        value = (value + 128) >> 8;
+        return value < 0 ? 0 : (value > 255 ? 255 : (uint8_t)value);
+    }
+};
+
+// 確定したフレームの出力先のインターフェース
+// LEDエンジンはフレームを描き終えたらLedOutputRouter::show()を呼び、
+// ルーターが登録済みの全出力先に同じフレームを渡す。
+class LedOutputSink {
+public:
+    virtual ~LedOutputSink() {}
+
+    // ルーターに登録されたときに呼ばれる（falseなら登録しない）
+    virtual bool begin(int numLeds) { return true; }
+    // ルーターから外されたときに呼ばれる
+    virtual void end() {}
+
+    // 確定したフレームを出力する（brightnessは全体の明るさ 0-255）
+    virtual void write(const CRGB* leds, int numLeds, uint8_t brightness) = 0;
+
+    virtual const char* getName() const = 0;
+};
+
+// WS2812BのLEDテープへの出力（FastLED）
+// FastLEDのコントローラーは専用のバッファに登録し、書き込み時にフレームをコピーする
+template <uint8_t DATA_PIN>
+class FastLedSink : public LedOutputSink {
+public:
+    FastLedSink() : m_buffer(nullptr), m_numLeds(0) {}
+    ~FastLedSink() { delete[] m_buffer; }
+
+    bool begin(int numLeds) override {
+        // FastLEDのコントローラーは解除できないので、登録は最初の1回だけ
+        if (m_buffer != nullptr) {
+            return numLeds == m_numLeds;
+        }
+        m_numLeds = numLeds;
+        m_buffer = new CRGB[numLeds];
+        FastLED.addLeds<WS2812B, DATA_PIN, GRB>(m_buffer, numLeds);
+        return true;
+    }
+
+    void write(const CRGB* leds, int numLeds, uint8_t brightness) override {
+        memcpy(m_buffer, leds, sizeof(CRGB) * min(numLeds, m_numLeds));
+        FastLED.show(brightness);
+    }
+
+    const char* getName() const override { return "fastled"; }
+
+private:
+    CRGB* m_buffer;
+    int m_numLeds;
+};
+
+// フレームをバイナリファイルに記録する出力（SPIFFS/SD）
+// 形式: ヘッダー "LUMF" + バージョン(1) + LED数(uint16)、
+//       以降フレームごとに 時刻ms(uint32) + LED数 × RGB
+class FileSink : public LedOutputSink {
+public:
+    FileSink(fs::FS& fs, const String& path);
+
+    bool begin(int numLeds) override;
+    void end() override;
+    void write(const CRGB* leds, int numLeds, uint8_t brightness) override;
+    const char* getName() const override { return "file"; }
+
+    uint32_t getFrameCount() const { return m_frameCount; }
+
+private:
+    fs::FS& m_fs;
+    String m_path;
+    File m_file;
+    uint32_t m_frameCount;
+};
+
+// ビジュアライザー向けにフレームをUDPで送る出力
+// パケット: "LUMU" + シーケンス番号(uint16) + LED数(uint16) + LED数 × RGB
+class UdpSink : public LedOutputSink {
+public:
+    UdpSink(const IPAddress& host, uint16_t port);
+
+    bool begin(int numLeds) override;
+    void end() override;
+    void write(const CRGB* leds, int numLeds, uint8_t brightness) override;
+    const char* getName() const override { return "udp"; }
+
+private:
+    WiFiUDP m_udp;
+    IPAddress m_host;
+    uint16_t m_port;
+    uint16_t m_sequence;
+};
+
+// ANSIエスケープシーケンス（24ビットカラー）で端末にLEDを表示する出力
+// シリアルは遅いので、表示はminIntervalMsごとに間引く
+class TerminalSink : public LedOutputSink {
+public:
+    TerminalSink(Print& out, uint16_t minIntervalMs = 100);
+
+    void end() override;
+    void write(const CRGB* leds, int numLeds, uint8_t brightness) override;
+    const char* getName() const override { return "terminal"; }
+
+private:
+    Print& m_out;
+    uint16_t m_minIntervalMs;
+    unsigned long m_lastWriteTime;
+};
+
+// 確定したフレームを登録済みの全出力先に配るルーター
+// 出力先の追加・削除はどのタスクからでもよい（追加・削除どうしは排他）。
+// show()はロックを取らないので、描画タスクがどこで停止されても出力が止まらない。
+// そのかわり外した直後の出力先に1フレームだけ書き込まれることがあるので、
+// 出力先を破棄するのはパターンを止めてからにする。
+class LedOutputRouter {
+public:
+    static LedOutputRouter& getInstance();
+
+    // 出力先を追加（sink->begin()が失敗した場合や満杯の場合はfalse）
+    // 所有権は呼び出し側が持つ
+    bool addSink(LedOutputSink* sink, int numLeds);
+    // 出力先を外す（sink->end()が呼ばれる）
+    bool removeSink(LedOutputSink* sink);
+    int getSinkCount() const { return m_sinkCount.load(); }
+
+    void setBrightness(uint8_t brightness) { m_brightness = brightness; }
+    uint8_t getBrightness() const { return m_brightness; }
+
+    // LEDごとの色補正（面ごとのLEDの個体差の補正）
+    // 補正はshow()で確定したフレームのコピーに1回だけ掛けるので、パターンのバッファは変わらない
+    void setColorCorrection(int led, const LedColorMatrix& matrix);
+    // すべての補正を外す
+    void clearColorCorrection();
+    bool hasColorCorrection() const { return m_correctionEnabled; }
+
+    // フレームを確定して全出力先に書き込む
+    void show(const CRGB* leds, int numLeds);
+
+private:
+    LedOutputRouter();
+    LedOutputRouter(const LedOutputRouter&);
+    LedOutputRouter& operator=(const LedOutputRouter&);
+
+    std::mutex m_mutex;
+    LedOutputSink* volatile m_sinks[LED_OUTPUT_MAX_SINKS];
+    std::atomic<int> m_sinkCount;
+    volatile uint8_t m_brightness;
+
+    LedColorMatrix m_correction[LED_OUTPUT_MAX_CORRECTED_LEDS];
+    CRGB m_correctedFrame[LED_OUTPUT_MAX_CORRECTED_LEDS];
+    volatile bool m_correctionEnabled;
+};
+
+#endif // LED_OUTPUT_H
@@ -0,0 +1,74 @@
+#include "LedPatternRegistry.h"
+#include "LEDManager.h"
+
+namespace {
+
+template <class T>
+LedPattern* createPattern() {
+    return new T();
+}
+
+LedPattern* createWorldPool() {
+    return new WorldSpacePattern(WorldSpacePattern::POOL);
+}
+
+LedPattern* createWorldHorizon() {
+    return new WorldSpacePattern(WorldSpacePattern::HORIZON);
+}
+
+LedPattern* createWorldGradient() {
+    return new WorldSpacePattern(WorldSpacePattern::UP_GRADIENT);
+}
+
+// 組み込みパターンの表（この順番がパターン番号になる）
+constexpr LedPatternEntry kBuiltinPatterns[] = {
+    {"Sequential",        &createPattern<SequentialPattern>},
+    {"On/Off",            &createPattern<OnOffPattern>},
+    {"Odd/Even",          &createPattern<OddEvenPattern>},
+    {"Random",            &createPattern<RandomPattern>},
+    {"Wave",              &createPattern<WavePattern>},
+    {"Rainbow",           &createPattern<RainbowPattern>},
+    {"Strobe",            &createPattern<StrobePattern>},
+    {"Chase",             &createPattern<ChasePattern>},
+    {"Pulse",             &createPattern<PulsePattern>},
+    {"Twinkle",           &createPattern<TwinklePattern>},
+    {"FireFlicker",       &createPattern<FireFlickerPattern>},
+    {"Comet",             &createPattern<CometPattern>},
+    {"Individual Random", &createPattern<IndividualRandomPattern>},
+    {"FPS Test",          &createPattern<FpsTestPattern>},   // FPS管理テスト用
+    {"World Pool",        &createWorldPool},
+    {"World Horizon",     &createWorldHorizon},
+    {"World Gradient",    &createWorldGradient},
+};
+
+constexpr int kBuiltinPatternCount = sizeof(kBuiltinPatterns) / sizeof(kBuiltinPatterns[0]);
+
+} // namespace
+
+int LedPatternRegistry::getCount() {
+    return kBuiltinPatternCount;
+}
+
+const LedPatternEntry* LedPatternRegistry::getEntry(int index) {
+    if (index < 0 || index >= kBuiltinPatternCount) {
+        return nullptr;
+    }
+    return &kBuiltinPatterns[index];
+}
+
+int LedPatternRegistry::findByName(const String& name) {
+    for (int i = 0; i < kBuiltinPatternCount; i++) {
+        if (name == kBuiltinPatterns[i].name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+LedPattern* LedPatternRegistry::create(int index) {
+    const LedPatternEntry* entry = getEntry(index);
+    if (entry == nullptr) {
+        return nullptr;
+    }
+    return entry->create();
+}
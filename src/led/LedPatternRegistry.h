@@ -0,0 +1,31 @@
+#ifndef LED_PATTERN_REGISTRY_H
+#define LED_PATTERN_REGISTRY_H
+
+#include <Arduino.h>
+
+class LedPattern;
+
+// パターンを生成する関数
+typedef LedPattern* (*LedPatternFactory)();
+
+// 組み込みパターンの登録情報（名前と生成関数）
+struct LedPatternEntry {
+    const char* name;
+    LedPatternFactory create;
+};
+
+// 組み込みパターンの一覧
+// 表はLedPatternRegistry.cppの定数配列（フラッシュ上）で、パターンのオブジェクトは
+// 再生するときに初めて生成する。新しいパターンは表に1行追加するだけで登録できる。
+class LedPatternRegistry {
+public:
+    static int getCount();
+    // 範囲外のindexにはnullptrを返す
+    static const LedPatternEntry* getEntry(int index);
+    // 名前からインデックスを探す（見つからなければ-1）
+    static int findByName(const String& name);
+    // パターンを生成する（呼び出し側がdeleteする）
+    static LedPattern* create(int index);
+};
+
+#endif // LED_PATTERN_REGISTRY_H
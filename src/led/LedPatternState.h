@@ -0,0 +1,110 @@
+#ifndef LED_PATTERN_STATE_H
+#define LED_PATTERN_STATE_H
+
+#include <Arduino.h>
+#include <string.h>
+#include "LedRandom.h"
+#include "LedSnapshot.h"
+
+// LedPatternState::flagsのビット（再生ごとの品質設定）
+#define LED_STATE_NO_POST_FILTERS 0x01  // フェード・ブラーなどの後処理を省略する
+
+// 再生速度（LedPatternState::speed）の固定小数点の1倍と範囲（0.25倍〜8倍）
+#define LED_SPEED_ONE 256
+#define LED_SPEED_MIN 64
+#define LED_SPEED_MAX 2048
+
+// パターン1回分の再生状態（POD）
+// パターンの定義（LedPattern / JsonLedPattern）は再生中に変更しない不変オブジェクトで、
+// 時刻やステップなど再生ごとに変わる値はすべてこの構造体に持つ。
+// 同じ定義を複数の場所（ゾーンやクロスフェード）で同時に再生するときは、
+// 再生ごとにこの構造体を1つ用意するだけでよい。各フィールドの意味はパターンごとに異なる。
+struct LedPatternState {
+    uint32_t startTime;      // 再生開始時刻（ms）
+    uint32_t lastStepTime;   // 直前にステップを進めた時刻（ms）
+    uint32_t lastFrameTime;  // 直前のフレームの時刻（ms）
+    int32_t step;            // 現在のステップ（色相・明るさなどにも使う）
+    uint32_t accumulator;    // 積算値（生成待ちの量・フレーム数など）
+    uint32_t stepSeed;       // 現在のステップの描画に使う乱数のシード
+    int8_t direction;        // 増減の向き（+1 / -1）
+    bool firstFrame;         // 次のフレームが最初のフレームか
+    uint8_t flags;           // LED_STATE_*の組み合わせ（reset()では0に戻る）
+    uint16_t speed;          // 再生速度（LED_SPEED_ONEが1倍。clock()を使うパターンだけが従う）
+    uint32_t clockBase;      // 速度を変えた時刻（millis()）
+    uint32_t clockTime;      // clockBaseの時点のパターンの時刻
+    LedRandom random;        // この再生専用の乱数
+
+    // 状態を初期化する。seedが0ならハードウェア乱数から毎回異なるシードを取る
+    void reset(uint32_t seed = 0) {
+        memset(this, 0, sizeof(*this));
+        direction = 1;
+        firstFrame = true;
+        speed = LED_SPEED_ONE;
+        random.seed(seed != 0 ? seed : esp_random());
+    }
+    
+    // パターンの時刻（速度を掛けた時計）。1倍のまま速度を変えていなければmillis()と同じ値になる
+    uint32_t clock(uint32_t now) const {
+        return clockTime + (uint32_t)(((uint64_t)(now - clockBase) * speed) / LED_SPEED_ONE);
+    }
+    
+    // 速度を変える（それまでに進んだパターンの時刻はそのまま）
+    void setSpeed(uint16_t newSpeed, uint32_t now) {
+        clockTime = clock(now);
+        clockBase = now;
+        speed = constrain(newSpeed, LED_SPEED_MIN, LED_SPEED_MAX);
+    }
+    
+    // スナップショットに書く（時刻はnow時点からの経過時間にする。flagsと速度は再生ごとの設定なので書かない）
+    // 経過時間はパターンの時刻で数える
+    void save(LedSnapshotWriter& out, uint32_t now) const {
+        uint32_t patternNow = clock(now);
+        out.putTime(startTime, patternNow);
+        out.putTime(lastStepTime, patternNow);
+        out.putTime(lastFrameTime, patternNow);
+        out.put32((uint32_t)step);
+        out.put32(accumulator);
+        out.put32(stepSeed);
+        out.put8((uint8_t)direction);
+        out.put8(firstFrame ? 1 : 0);
+        out.put32(random.state);
+    }
+    
+    // スナップショットから読む（時刻はnow時点の時計に載せ替え、パターンの時刻もnowから数え直す）
+    bool load(LedSnapshotReader& in, uint32_t now) {
+        LedPatternState loaded;
+        loaded.reset(1);
+        loaded.startTime = in.getTime(now);
+        loaded.lastStepTime = in.getTime(now);
+        loaded.lastFrameTime = in.getTime(now);
+        loaded.step = (int32_t)in.get32();
+        loaded.accumulator = in.get32();
+        loaded.stepSeed = in.get32();
+        loaded.direction = (int8_t)in.get8();
+        loaded.firstFrame = in.get8() != 0;
+        loaded.random.state = in.get32();
+        if (!in.ok()) {
+            return false;
+        }
+        loaded.flags = flags;
+        loaded.speed = speed != 0 ? speed : LED_SPEED_ONE;
+        loaded.clockBase = now;
+        loaded.clockTime = now;
+        *this = loaded;
+        return true;
+    }
+};
+
+// PODに収まらない作業領域を持つパターン用の拡張状態
+// （炎の熱量やパーティクルのプールなど）。LedPattern::createExtState()で再生ごとに生成する。
+class LedPatternExtState {
+public:
+    virtual ~LedPatternExtState() {}
+    
+    // スナップショットへの書き込みと読み込み（キャッシュだけの拡張状態は何もしなくてよい）
+    // numFacesは再生先の面の数（別の本体のスナップショットで範囲外を参照しないよう確かめる）
+    virtual void saveSnapshot(LedSnapshotWriter& out) const {}
+    virtual bool loadSnapshot(LedSnapshotReader& in, int numFaces) { return true; }
+};
+
+#endif // LED_PATTERN_STATE_H
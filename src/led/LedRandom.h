@@ -0,0 +1,68 @@
+#ifndef LED_RANDOM_H
+#define LED_RANDOM_H
+
+#include <stdint.h>
+
+// パターン用の高速で再現可能な疑似乱数（xorshift32）
+// Arduinoのrandom()はESP32ではハードウェア乱数を経由するため遅く、再現もできない。
+// パターンの再生状態ごとに1つ持ち、同じシードからは同じ系列を返す。
+// 状態は4バイトのPODなので、LedPatternStateに埋め込んでそのまま保存・復元できる。
+struct LedRandom {
+    uint32_t state;
+
+    // シードを設定する（近いシード値でも系列が似ないように攪拌し、0は避ける）
+    void seed(uint32_t value) {
+        value ^= value >> 16;
+        value *= 0x7FEB352DUL;
+        value ^= value >> 15;
+        value *= 0x846CA68BUL;
+        value ^= value >> 16;
+        state = value != 0 ? value : 0x9E3779B9UL;
+    }
+
+    uint32_t next32() {
+        uint32_t x = state;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        state = x;
+        return x;
+    }
+
+    // [0, bound) の一様な整数（Lemireの乗算による範囲変換。除算は偏りが出るときだけ）
+    uint32_t below(uint32_t bound) {
+        if (bound == 0) return 0;
+        uint64_t m = (uint64_t)next32() * bound;
+        uint32_t low = (uint32_t)m;
+        if (low < bound) {
+            uint32_t threshold = (uint32_t)(-bound) % bound;
+            while (low < threshold) {
+                m = (uint64_t)next32() * bound;
+                low = (uint32_t)m;
+            }
+        }
+        return (uint32_t)(m >> 32);
+    }
+
+    // [min, max) の整数（Arduinoのrandom(min, max)と同じ範囲。max <= minならminを返す）
+    int32_t range(int32_t min, int32_t max) {
+        if (max <= min) return min;
+        return min + (int32_t)below((uint32_t)(max - min));
+    }
+
+    // FastLEDのrandom8()/random16()と同じ範囲の値（範囲の上限は含まない）
+    uint8_t next8() { return (uint8_t)(next32() >> 24); }
+    uint8_t next8(uint8_t lim) { return (uint8_t)(((uint32_t)next8() * lim) >> 8); }
+    uint8_t next8(uint8_t min, uint8_t lim) { return min + next8((uint8_t)(lim - min)); }
+    uint16_t next16() { return (uint16_t)(next32() >> 16); }
+    uint16_t next16(uint16_t lim) { return (uint16_t)(((uint32_t)next16() * lim) >> 16); }
+    uint16_t next16(uint16_t min, uint16_t lim) { return min + next16((uint16_t)(lim - min)); }
+
+    static LedRandom withSeed(uint32_t value) {
+        LedRandom random;
+        random.seed(value);
+        return random;
+    }
+};
+
+#endif // LED_RANDOM_H
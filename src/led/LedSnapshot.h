@@ -0,0 +1,165 @@
+#ifndef LED_SNAPSHOT_H
+#define LED_SNAPSHOT_H
+
+#include <Arduino.h>
+#include <string.h>
+#include <vector>
+
+// 再生状態のスナップショット（バイト列）の読み書き
+// 設定画面やスクリーンセーバーから戻ったときの再開や、別のユニットへの再生の引き継ぎに使う。
+// 値はすべてリトルエンディアンで詰めて書く（構造体をそのまま書かないので機種やビルドに依存しない）。
+
+// スナップショットの形式のバージョン（互換性のない変更をしたら上げる）
+#define LED_SNAPSHOT_VERSION 3
+
+// 時刻をスナップショット時点からの経過時間で書くときの「未設定（0）」の印
+#define LED_SNAPSHOT_UNSET_TIME 0xFFFFFFFFUL
+
+class LedSnapshotWriter {
+public:
+    explicit LedSnapshotWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+    void put8(uint8_t value) { m_out.push_back(value); }
+    void put16(uint16_t value) {
+        put8(value & 0xFF);
+        put8(value >> 8);
+    }
+    void put32(uint32_t value) {
+        put16(value & 0xFFFF);
+        put16(value >> 16);
+    }
+    void putBytes(const void* data, size_t length) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        m_out.insert(m_out.end(), bytes, bytes + length);
+    }
+    // 可変長の整数（下位から7ビットずつ、続きがあれば最上位ビットを立てる。小さい値ほど短い）
+    void putVarint(uint32_t value) {
+        while (value >= 0x80) {
+            put8((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        put8(value);
+    }
+    // 符号付きの可変長の整数（0に近い値ほど短い）
+    void putSignedVarint(int32_t value) {
+        putVarint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+    }
+    // 文字列（255バイトまで、長さ1バイト + 本体）
+    void putString(const String& value) {
+        size_t length = min<size_t>(value.length(), 255);
+        put8(length);
+        putBytes(value.c_str(), length);
+    }
+
+    // millis()の時刻を、now時点からの経過時間として書く（読み込み側の時計に載せ替えるため）
+    void putTime(uint32_t time, uint32_t now) {
+        put32(time == 0 ? LED_SNAPSHOT_UNSET_TIME : now - time);
+    }
+
+    // 長さ付きの区間: beginSection()の戻り値をendSection()に渡すと区間の長さ（16ビット）を埋める
+    size_t beginSection() {
+        size_t position = m_out.size();
+        put16(0);
+        return position;
+    }
+    void endSection(size_t position) {
+        size_t length = m_out.size() - position - 2;
+        m_out[position] = length & 0xFF;
+        m_out[position + 1] = (length >> 8) & 0xFF;
+    }
+
+    size_t size() const { return m_out.size(); }
+
+private:
+    std::vector<uint8_t>& m_out;
+};
+
+// 範囲外を読もうとするとok()がfalseになり、以降は0を返す
+class LedSnapshotReader {
+public:
+    LedSnapshotReader(const uint8_t* data, size_t length) : m_data(data), m_length(length), m_position(0), m_ok(true) {}
+
+    uint8_t get8() {
+        if (!require(1)) return 0;
+        return m_data[m_position++];
+    }
+    uint16_t get16() {
+        uint16_t low = get8();
+        return low | ((uint16_t)get8() << 8);
+    }
+    uint32_t get32() {
+        uint32_t low = get16();
+        return low | ((uint32_t)get16() << 16);
+    }
+    uint32_t getVarint() {
+        uint32_t value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            uint8_t byte = get8();
+            value |= (uint32_t)(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        m_ok = false;
+        return 0;
+    }
+    int32_t getSignedVarint() {
+        uint32_t value = getVarint();
+        return (int32_t)((value >> 1) ^ (0 - (value & 1)));
+    }
+    bool getBytes(void* out, size_t length) {
+        if (!require(length)) return false;
+        memcpy(out, m_data + m_position, length);
+        m_position += length;
+        return true;
+    }
+    String getString() {
+        size_t length = get8();
+        if (!require(length)) return String();
+        String value;
+        value.reserve(length);
+        for (size_t i = 0; i < length; i++) {
+            value += (char)m_data[m_position++];
+        }
+        return value;
+    }
+
+    // putTime()で書いた時刻をnow時点の時計に載せ替えて読む
+    uint32_t getTime(uint32_t now) {
+        uint32_t age = get32();
+        return age == LED_SNAPSHOT_UNSET_TIME ? 0 : now - age;
+    }
+
+    // 長さ付きの区間を切り出す（区間の分だけ読み進める）
+    LedSnapshotReader section() {
+        size_t length = get16();
+        if (!require(length)) return LedSnapshotReader(nullptr, 0, false);
+        LedSnapshotReader sub(m_data + m_position, length);
+        m_position += length;
+        return sub;
+    }
+
+    bool ok() const { return m_ok; }
+    size_t remaining() const { return m_length - m_position; }
+    // 読み込み元のバイト列（区間ならその区間）
+    const uint8_t* data() const { return m_data; }
+    size_t length() const { return m_length; }
+
+private:
+    LedSnapshotReader(const uint8_t* data, size_t length, bool ok) : m_data(data), m_length(length), m_position(0), m_ok(ok) {}
+
+    bool require(size_t length) {
+        if (!m_ok || m_length - m_position < length) {
+            m_ok = false;
+            return false;
+        }
+        return true;
+    }
+
+    const uint8_t* m_data;
+    size_t m_length;
+    size_t m_position;
+    bool m_ok;
+};
+
+#endif // LED_SNAPSHOT_H
@@ -0,0 +1,110 @@
+#include "LedZone.h"
+#include "LEDManager.h"
+#include "FaceLayout.h"
+
+namespace {
+
+// マスクした面（32面まで）のLEDをキャンバスからフレームへコピーする
+struct MaskedCopyOp {
+    MaskedCopyOp(CRGB* frame, const CRGB* canvas, uint32_t mask) : frame(frame), canvas(canvas), mask(mask) {}
+    template <typename Layout>
+    void operator()(const Layout& layout) const {
+        for (int face = 0; face < layout.faceCount() && face < 32; face++) {
+            if (mask & (1UL << face)) {
+                layout.copyFace(frame, canvas, face);
+            }
+        }
+    }
+    CRGB* frame;
+    const CRGB* canvas;
+    uint32_t mask;
+};
+
+} // namespace
+
+LedZone::LedZone()
+    : m_faceMask(0), m_canvas(nullptr), m_numLeds(0),
+      m_pattern(nullptr), m_patternIndex(-1), m_playback(new LedPatternInstance()),
+      m_jsonPattern(nullptr) {
+    m_jsonState.reset();
+}
+
+LedZone::~LedZone() {
+    // 再生状態を先に外してから定義を解放する
+    m_playback->attach(nullptr);
+    delete m_playback;
+    delete m_pattern;
+    delete[] m_canvas;
+}
+
+bool LedZone::begin(int numLeds) {
+    if (m_canvas != nullptr && m_numLeds == numLeds) {
+        return true;
+    }
+    delete[] m_canvas;
+    m_canvas = new CRGB[numLeds];
+    m_numLeds = numLeds;
+    fill_solid(m_canvas, numLeds, CRGB::Black);
+    return true;
+}
+
+void LedZone::setBuiltinPattern(int patternIndex) {
+    m_jsonPattern = nullptr;
+
+    if (m_patternIndex != patternIndex || m_pattern == nullptr) {
+        m_playback->attach(nullptr);
+        delete m_pattern;
+        m_pattern = LedPatternRegistry::create(patternIndex);
+        m_patternIndex = m_pattern ? patternIndex : -1;
+    }
+    m_playback->attach(m_pattern);
+
+    if (m_canvas != nullptr) {
+        fill_solid(m_canvas, m_numLeds, CRGB::Black);
+    }
+}
+
+void LedZone::setJsonPattern(const JsonLedPattern* pattern) {
+    // 組み込みパターンの定義は次に使うときのために残しておく
+    m_playback->attach(nullptr);
+    m_jsonPattern = pattern;
+    m_jsonState.reset();
+
+    if (m_canvas != nullptr) {
+        fill_solid(m_canvas, m_numLeds, CRGB::Black);
+    }
+}
+
+void LedZone::clear() {
+    m_playback->attach(nullptr);
+    m_jsonPattern = nullptr;
+    m_faceMask = 0;
+}
+
+String LedZone::getPatternName() const {
+    if (m_jsonPattern != nullptr) {
+        return m_jsonPattern->getName();
+    }
+    const LedPattern* pattern = m_playback->getPattern();
+    if (pattern != nullptr) {
+        return pattern->getName();
+    }
+    return "None";
+}
+
+void LedZone::render(CRGB* frame, int numLeds, int ledOffset, int numFaces) {
+    if (!isActive() || m_canvas == nullptr) {
+        return;
+    }
+
+    int canvasLeds = min(numLeds, m_numLeds);
+    if (m_jsonPattern != nullptr) {
+        m_jsonPattern->renderFrame(m_jsonState, m_canvas, canvasLeds, ledOffset, numFaces);
+    } else {
+        m_playback->runFrame(m_canvas, canvasLeds, ledOffset, numFaces);
+    }
+
+    // マスクした面のLEDだけをフレームにコピー
+    MaskedCopyOp op(frame, m_canvas, m_faceMask);
+    dispatchFaceLayout(canvasLeds, ledOffset, numFaces, op);
+}
@@ -0,0 +1,72 @@
+#ifndef LED_ZONE_H
+#define LED_ZONE_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include "LedPatternState.h"
+
+class LedPattern;
+class LedPatternInstance;
+class JsonLedPattern;
+
+// 同時に再生できるゾーンの最大数
+#define LED_MAX_ZONES 4
+
+// ゾーンへの変更要求（描画タスクがフレームの区切りでまとめて反映する）
+struct LedZoneRequest {
+    bool pending;
+    bool clear;                        // trueならゾーンを無効にする
+    uint32_t faceMask;
+    int patternIndex;                  // 組み込みパターン（jsonPatternがnullptrのとき）
+    const JsonLedPattern* jsonPattern;
+};
+
+// ゾーン: 面の集合（ビットマスク）と、そこで再生するパターン1つ
+// パターンは全面ぶんの自分専用のキャンバスに描き、合成時にマスクした面だけを
+// フレームにコピーする。キャンバスは前フレームの内容を保つので、
+// 残像を作るパターン（Twinkle、Cometなど）も他のゾーンの影響を受けない。
+class LedZone {
+public:
+    LedZone();
+    ~LedZone();
+
+    // キャンバスを確保する（LED数が変わらなければ何もしない）
+    bool begin(int numLeds);
+
+    // 組み込みパターンを割り当てる（同じパターンなら定義を再利用して最初から再生）
+    void setBuiltinPattern(int patternIndex);
+    // JSONパターンを割り当てる（パターンはJsonPatternManagerが所有する）
+    void setJsonPattern(const JsonLedPattern* pattern);
+    // パターンを外して無効にする
+    void clear();
+
+    void setFaceMask(uint32_t faceMask) { m_faceMask = faceMask; }
+    uint32_t getFaceMask() const { return m_faceMask; }
+
+    bool isActive() const { return m_faceMask != 0 && (m_pattern != nullptr || m_jsonPattern != nullptr); }
+    bool usesJsonPattern() const { return m_jsonPattern != nullptr; }
+    bool usesJsonPattern(const JsonLedPattern* pattern) const { return m_jsonPattern != nullptr && m_jsonPattern == pattern; }
+    String getPatternName() const;
+
+    // 1フレーム分をキャンバスに描き、マスクした面をframeにコピーする
+    void render(CRGB* frame, int numLeds, int ledOffset, int numFaces);
+
+private:
+    LedZone(const LedZone&);
+    LedZone& operator=(const LedZone&);
+
+    uint32_t m_faceMask;
+    CRGB* m_canvas;
+    int m_numLeds;
+
+    // 組み込みパターン（定義と再生状態）
+    LedPattern* m_pattern;
+    int m_patternIndex;
+    LedPatternInstance* m_playback;
+
+    // JSONパターン
+    const JsonLedPattern* m_jsonPattern;
+    LedPatternState m_jsonState;
+};
+
+#endif // LED_ZONE_H
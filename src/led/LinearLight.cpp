@@ -0,0 +1,32 @@
+#include "LinearLight.h"
+#include <math.h>
+
+uint16_t LinearLight::s_toLinear[256];
+uint8_t LinearLight::s_fromLinear[LinearLight::INVERSE_TABLE_SIZE];
+
+// 表を作る（起動時の静的初期化で1回だけ実行する）
+// 伝達特性はsRGB: 暗部は直線なので、符号化値1でも線形値が0に潰れない
+struct LinearLightTables {
+    LinearLightTables() {
+        for (int i = 0; i < 256; i++) {
+            float encoded = i / 255.0f;
+            float linear = encoded <= 0.04045f
+                ? encoded / 12.92f
+                : powf((encoded + 0.055f) / 1.055f, 2.4f);
+            LinearLight::s_toLinear[i] = (uint16_t)(linear * 65535.0f + 0.5f);
+        }
+
+        // 逆変換は区間の中央の値で求める
+        for (int i = 0; i < LinearLight::INVERSE_TABLE_SIZE; i++) {
+            float linear = ((i << LinearLight::LINEAR_SHIFT) + (1 << (LinearLight::LINEAR_SHIFT - 1))) / 65535.0f;
+            if (i == 0) linear = 0.0f;
+            float encoded = linear <= 0.0031308f
+                ? linear * 12.92f
+                : 1.055f * powf(linear, 1.0f / 2.4f) - 0.055f;
+            int value = (int)(encoded * 255.0f + 0.5f);
+            LinearLight::s_fromLinear[i] = (uint8_t)(value > 255 ? 255 : value);
+        }
+    }
+};
+
+static LinearLightTables s_linearLightTables;
@@ -0,0 +1,76 @@
+#ifndef LINEAR_LIGHT_H
+#define LINEAR_LIGHT_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+// 線形光（リニア）空間での色の合成
+// LEDバッファの値はガンマ（sRGBの伝達特性）で符号化された8ビット値なので、
+// そのまま補間・加算・減衰すると中間が暗く濁り、暗部で段差が目立つ。
+// ここでは表引きで16ビットの線形値に変換してから計算し、8ビットに戻す。
+// 表はどちらも起動時に1回だけ作る（変換 256×2バイト、逆変換 4096バイト）。整数演算のみ。
+class LinearLight {
+public:
+    // 8ビットの符号化値 → 16ビットの線形値（0-65535）
+    static uint16_t toLinear(uint8_t value) { return s_toLinear[value]; }
+    // 16ビットの線形値 → 8ビットの符号化値（下位4ビットは丸める）
+    static uint8_t fromLinear(uint16_t linear) { return s_fromLinear[linear >> LINEAR_SHIFT]; }
+
+    // 光量をscale/255倍にする（nscale8の線形光版）
+    // 繰り返し適用しても必ず黒まで減衰する（再符号化の丸めで値が戻らないようにしている）
+    static void scale(CRGB& color, uint8_t scale) {
+        color.r = scaleChannel(color.r, scale);
+        color.g = scaleChannel(color.g, scale);
+        color.b = scaleChannel(color.b, scale);
+    }
+
+    // aからbへamount/255だけ線形光で補間する（クロスフェード・レイヤーの合成用）
+    static CRGB blend(const CRGB& a, const CRGB& b, uint8_t amount) {
+        return CRGB(mix(a.r, b.r, amount), mix(a.g, b.g, amount), mix(a.b, b.b, amount));
+    }
+
+    // 光を加算する（飽和あり）。重なったパーティクルの合成用
+    static void add(CRGB& dst, const CRGB& src) {
+        dst.r = fromLinear(addSaturate(toLinear(dst.r), toLinear(src.r)));
+        dst.g = fromLinear(addSaturate(toLinear(dst.g), toLinear(src.g)));
+        dst.b = fromLinear(addSaturate(toLinear(dst.b), toLinear(src.b)));
+    }
+
+    // 全LEDの光量をfadeBy/255だけ減らす（fadeToBlackByの線形光版。残像の減衰用）
+    static void fadeToBlackBy(CRGB* leds, int count, uint8_t fadeBy) {
+        uint8_t keep = 255 - fadeBy;
+        for (int i = 0; i < count; i++) {
+            scale(leds[i], keep);
+        }
+    }
+
+private:
+    static const int LINEAR_SHIFT = 4;
+    static const int INVERSE_TABLE_SIZE = 65536 >> LINEAR_SHIFT;
+
+    static uint8_t scaleChannel(uint8_t value, uint8_t scale) {
+        uint8_t result = fromLinear((uint16_t)((uint32_t)toLinear(value) * scale / 255));
+        if (result >= value && scale < 255 && value > 0) {
+            result = value - 1;
+        }
+        return result;
+    }
+
+    static uint8_t mix(uint8_t a, uint8_t b, uint8_t amount) {
+        int32_t la = toLinear(a);
+        int32_t lb = toLinear(b);
+        return fromLinear((uint16_t)(la + (lb - la) * (int32_t)amount / 255));
+    }
+
+    static uint16_t addSaturate(uint16_t a, uint16_t b) {
+        uint32_t sum = (uint32_t)a + b;
+        return sum > 0xFFFF ? 0xFFFF : (uint16_t)sum;
+    }
+
+    static uint16_t s_toLinear[256];
+    static uint8_t s_fromLinear[INVERSE_TABLE_SIZE];
+
+    friend struct LinearLightTables;
+};
+
+#endif // LINEAR_LIGHT_H
@@ -0,0 +1,213 @@
+#include "ParticleSystem.h"
+#include "LinearLight.h"
+
+ParticleSystem::ParticleSystem(int capacity)
+    : m_pool(nullptr), m_capacity(capacity), m_activeCount(0),
+      m_pathLength(0), m_loop(true), m_interpolate(true) {
+    if (m_capacity < 1) m_capacity = 1;
+    m_pool = new Particle[m_capacity];
+}
+
+ParticleSystem::~ParticleSystem() {
+    delete[] m_pool;
+}
+
+void ParticleSystem::setPath(const uint8_t* faces, int length, bool loop) {
+    m_pathLength = constrain(length, 0, PARTICLE_MAX_PATH);
+    memcpy(m_path, faces, m_pathLength);
+    m_loop = loop;
+}
+
+void ParticleSystem::setRingPath(int numFaces) {
+    m_pathLength = constrain(numFaces, 0, PARTICLE_MAX_PATH);
+    for (int i = 0; i < m_pathLength; i++) {
+        m_path[i] = i;
+    }
+    m_loop = true;
+}
+
+void ParticleSystem::setTourPath(const FaceTopology& topology) {
+    m_pathLength = topology.buildTour(m_path, PARTICLE_MAX_PATH);
+    m_loop = true;
+}
+
+bool ParticleSystem::spawn(int32_t position, int16_t velocity, uint16_t lifetime, const CRGB& color, Envelope envelope) {
+    if (m_activeCount >= m_capacity || m_pathLength == 0) {
+        return false;
+    }
+
+    // 生存中のパーティクルはプールの先頭に詰めて管理する
+    Particle& p = m_pool[m_activeCount++];
+    p.position = position << 8;
+    p.velocity = velocity;
+    p.age = 0;
+    p.lifetime = lifetime;
+    p.color = color;
+    p.envelope = envelope;
+    return true;
+}
+
+void ParticleSystem::update(uint16_t dtMs) {
+    // 長時間の停止後でも積分が桁あふれしないよう1回の進みを制限する
+    if (dtMs > 250) dtMs = 250;
+    const int32_t pathEnd = (int32_t)m_pathLength << 16;
+
+    int i = 0;
+    while (i < m_activeCount) {
+        Particle& p = m_pool[i];
+
+        // 経過時間と寿命
+        uint32_t age = (uint32_t)p.age + dtMs;
+        p.age = age > 0xFFFF ? 0xFFFF : age;
+        bool dead = (p.lifetime != 0 && p.age >= p.lifetime);
+
+        // 移動（面/秒 × 256 の速度をミリ秒で積分。端数が消えないよう位置は16ビット小数）
+        if (!dead && p.velocity != 0) {
+            p.position += ((int32_t)p.velocity * 256 * dtMs) / 1000;
+            if (m_loop) {
+                p.position %= pathEnd;
+                if (p.position < 0) p.position += pathEnd;
+            } else if (p.position < 0 || p.position >= pathEnd) {
+                dead = true;
+            }
+        }
+
+        if (dead) {
+            // 末尾のパーティクルで穴を埋める（順序は保持しない）
+            m_pool[i] = m_pool[--m_activeCount];
+        } else {
+            i++;
+        }
+    }
+}
+
+uint8_t ParticleSystem::envelopeLevel(const Particle& p) {
+    if (p.lifetime == 0) return 255;
+
+    switch (p.envelope) {
+        case FADE_OUT:
+            return 255 - (uint32_t)p.age * 255 / p.lifetime;
+        case TRIANGLE: {
+            uint32_t half = p.lifetime / 2;
+            if (half == 0) return 255;
+            if (p.age < half) return (uint32_t)p.age * 255 / half;
+            return (uint32_t)(p.lifetime - p.age) * 255 / half;
+        }
+        case CONSTANT:
+        default:
+            return 255;
+    }
+}
+
+void ParticleSystem::addToFace(CRGB* leds, int ledOffset, int ledsPerFace, int pathIndex, const CRGB& color) const {
+    int base = ledOffset + m_path[pathIndex] * ledsPerFace;
+    for (int led = 0; led < ledsPerFace; led++) {
+        LinearLight::add(leds[base + led], color);
+    }
+}
+
+void ParticleSystem::render(CRGB* leds, int ledOffset, int ledsPerFace) const {
+    for (int i = 0; i < m_activeCount; i++) {
+        const Particle& p = m_pool[i];
+        uint8_t level = envelopeLevel(p);
+        if (level == 0) continue;
+
+        int index = p.position >> 16;
+        uint8_t frac = (p.position >> 8) & 0xFF;
+
+        if (!m_interpolate || frac == 0) {
+            CRGB color = p.color;
+            color.nscale8_video(level);
+            addToFace(leds, ledOffset, ledsPerFace, index, color);
+            continue;
+        }
+
+        // 隣の面との間を位置の端数で按分する
+        // 線形光で分けるので、面の間を移動しても2面の合計の明るさは変わらない
+        CRGB front = p.color;
+        front.nscale8_video(level);
+        CRGB back = front;
+        LinearLight::scale(back, 255 - frac);
+        LinearLight::scale(front, frac);
+        addToFace(leds, ledOffset, ledsPerFace, index, back);
+
+        int next = index + 1;
+        if (next >= m_pathLength) {
+            if (!m_loop) continue;
+            next = 0;
+        }
+        addToFace(leds, ledOffset, ledsPerFace, next, front);
+    }
+}
+
+void ParticleSystem::clear() {
+    m_activeCount = 0;
+}
+
+void ParticleSystem::save(LedSnapshotWriter& out) const {
+    out.put8(m_pathLength);
+    out.putBytes(m_path, m_pathLength);
+    out.put8((m_loop ? 0x01 : 0) | (m_interpolate ? 0x02 : 0));
+    out.put16(m_activeCount);
+    for (int i = 0; i < m_activeCount; i++) {
+        const Particle& p = m_pool[i];
+        out.put32((uint32_t)p.position);
+        out.put16((uint16_t)p.velocity);
+        out.put16(p.age);
+        out.put16(p.lifetime);
+        out.put8(p.color.r);
+        out.put8(p.color.g);
+        out.put8(p.color.b);
+        out.put8(p.envelope);
+    }
+}
+
+bool ParticleSystem::load(LedSnapshotReader& in, int numFaces) {
+    int pathLength = in.get8();
+    uint8_t path[PARTICLE_MAX_PATH];
+    if (pathLength > PARTICLE_MAX_PATH || !in.getBytes(path, pathLength)) {
+        return false;
+    }
+    uint8_t options = in.get8();
+    int activeCount = in.get16();
+    if (!in.ok() || activeCount > m_capacity) {
+        return false;
+    }
+
+    // 壊れたデータや別の本体のデータで範囲外を参照しないよう、面の番号を確かめる
+    for (int i = 0; i < pathLength; i++) {
+        if (path[i] >= numFaces) {
+            return false;
+        }
+    }
+
+    // 途中で失敗しても再生中のパーティクルを壊さないよう、すべて確かめてからプールに反映する
+    // （位置がパスの中にあることも確かめる。パスが空ならパーティクルは持てない）
+    const int32_t pathEnd = (int32_t)pathLength << 16;
+    LedSnapshotReader check = in;
+    for (int i = 0; i < activeCount; i++) {
+        int32_t position = (int32_t)check.get32();
+        uint8_t rest[10];  // 位置に続く速度・経過時間・寿命・色・Envelope
+        if (!check.getBytes(rest, sizeof(rest)) || position < 0 || position >= pathEnd) {
+            return false;
+        }
+    }
+    for (int i = 0; i < activeCount; i++) {
+        Particle& p = m_pool[i];
+        p.position = (int32_t)in.get32();
+        p.velocity = (int16_t)in.get16();
+        p.age = in.get16();
+        p.lifetime = in.get16();
+        p.color.r = in.get8();
+        p.color.g = in.get8();
+        p.color.b = in.get8();
+        p.envelope = in.get8();
+    }
+
+    memcpy(m_path, path, pathLength);
+    m_pathLength = pathLength;
+    m_loop = (options & 0x01) != 0;
+    m_interpolate = (options & 0x02) != 0;
+    m_activeCount = activeCount;
+    return true;
+}
@@ -0,0 +1,81 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include "FaceTopology.h"
+#include "LedSnapshot.h"
+
+// パス（面の並び）の最大長
+#define PARTICLE_MAX_PATH 32
+
+// パーティクル1個分の状態（16バイト）
+struct Particle {
+    int32_t position;   // パス上の位置（面インデックス × 65536）
+    int16_t velocity;   // 速度（面/秒 × 256）
+    uint16_t age;       // 経過時間（ms）
+    uint16_t lifetime;  // 寿命（ms）。0なら無期限
+    CRGB color;
+    uint8_t envelope;   // 明るさの時間変化（Envelope）
+};
+
+// 面の並びに沿って動くパーティクルを固定数のプールで管理するエンジン
+// プールは生成時に一度だけ確保し、実行中のメモリ確保は行わない。
+// 描画は加算合成（飽和）なので、複数のパーティクルが重なると明るくなる。
+class ParticleSystem {
+public:
+    // 寿命に対する明るさの変化
+    enum Envelope : uint8_t {
+        CONSTANT,   // 一定
+        FADE_OUT,   // 徐々に暗くなる
+        TRIANGLE    // 明るくなってから暗くなる（ツインクル向け）
+    };
+
+    explicit ParticleSystem(int capacity);
+    ~ParticleSystem();
+
+    // 面の並びを設定（loop=trueでパスの端から反対側の端へ回り込む）
+    void setPath(const uint8_t* faces, int length, bool loop);
+    // 0..numFaces-1 のリングをパスにする
+    void setRingPath(int numFaces);
+    // 形状の隣接面づたいに全面を巡る閉路をパスにする
+    void setTourPath(const FaceTopology& topology);
+
+    // 面の間を補間して描画するか（falseなら現在の面だけを点灯）
+    void setInterpolation(bool enabled) { m_interpolate = enabled; }
+
+    // パーティクルを追加（プールが満杯ならfalse）
+    // position: パス上の位置（面インデックス × 256）
+    bool spawn(int32_t position, int16_t velocity, uint16_t lifetime, const CRGB& color, Envelope envelope = CONSTANT);
+
+    // 経過時間dtMsだけ全パーティクルを進め、寿命切れを解放する
+    void update(uint16_t dtMs);
+
+    // 全パーティクルをLEDバッファに加算描画する（加算と面の間の按分は線形光で行う）
+    void render(CRGB* leds, int ledOffset, int ledsPerFace) const;
+
+    void clear();
+
+    // パスと生存中のパーティクルをスナップショットに書く／読む（プールの容量は変えない）
+    // 読み込みはパスの面がnumFaces未満で、位置がパスの中にあるものだけを受け付ける
+    void save(LedSnapshotWriter& out) const;
+    bool load(LedSnapshotReader& in, int numFaces);
+
+    int getActiveCount() const { return m_activeCount; }
+    int getCapacity() const { return m_capacity; }
+    int getPathLength() const { return m_pathLength; }
+
+private:
+    void addToFace(CRGB* leds, int ledOffset, int ledsPerFace, int pathIndex, const CRGB& color) const;
+    static uint8_t envelopeLevel(const Particle& p);
+
+    Particle* m_pool;
+    int m_capacity;
+    int m_activeCount;
+    uint8_t m_path[PARTICLE_MAX_PATH];
+    int m_pathLength;
+    bool m_loop;
+    bool m_interpolate;
+};
+
+#endif // PARTICLE_SYSTEM_H
@@ -143,6 +143,34 @@ void WebServerManager::setupAPIEndpoints() {
         request->send(200, "application/json", response);
     });
     
+    // LED診断API - フレーム予算の超過による品質低下の記録を取得
+    _server->on("/api/led/diagnostics", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        Serial.println("[API] LED diagnostics API called");
+        LedDiagnostics& diagnostics = LedDiagnostics::getInstance();
+        static LedDiagnosticEvent events[LED_DIAGNOSTICS_CAPACITY];
+        int count = diagnostics.copyEvents(events, LED_DIAGNOSTICS_CAPACITY);
+
+        DynamicJsonDocument doc(4096);
+        doc["total"] = diagnostics.getTotalCount();
+        doc["stage"] = FrameBudgetWatchdog::getStageName(_ledManager->getDegradationStage());
+        JsonArray list = doc.createNestedArray("events");
+
+        for (int i = 0; i < count; i++) {
+            JsonObject event = list.createNestedObject();
+            event["time"] = events[i].timeMs;
+            event["type"] = LedDiagnostics::getTypeName(events[i].type);
+            event["pattern"] = events[i].pattern;
+            event["stage"] = FrameBudgetWatchdog::getStageName((FrameBudgetWatchdog::Stage)events[i].stage);
+            event["frameUs"] = events[i].frameUs;
+            event["budgetUs"] = events[i].budgetUs;
+        }
+
+        String response;
+        serializeJson(doc, response);
+
+        request->send(200, "application/json", response);
+    });
+
     // LED制御API - JSONパターンを受け取って実行
     _server->on("/api/led/pattern/json", HTTP_POST, [](AsyncWebServerRequest *request) {}, NULL, [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
         if (index == 0) {
@@ -161,6 +189,90 @@ void WebServerManager::setupAPIEndpoints() {
             handleJsonPatternControl(request, data, total);
         }
     });
+
+    // LED制御API - JSONパターンをライブラリから削除（name=パターン名）
+    _server->on("/api/led/pattern/json", HTTP_DELETE, [this](AsyncWebServerRequest *request) {
+        Serial.println("[API] JSON LED pattern delete API called");
+        
+        StaticJsonDocument<256> doc;
+        int code = 200;
+        if (!request->hasParam("name")) {
+            code = 400;
+            doc["status"] = "error";
+            doc["message"] = "Missing parameter: name";
+        } else if (!_ledManager->removeJsonPattern(request->getParam("name")->value())) {
+            code = 404;
+            doc["status"] = "error";
+            doc["message"] = "Unknown pattern";
+        } else {
+            doc["status"] = "ok";
+            doc["patterns"] = _ledManager->getJsonPatternCount();
+        }
+        
+        String response;
+        serializeJson(doc, response);
+
+        request->send(code, "application/json", response);
+    });
+
+    // LED制御API - 再生中のJSONパターンの位置と速度（position=ms, speed=0.25〜8。どちらも省略可）
+    // /api/led/pattern/json の下に置くと上のPOSTのハンドラーに前方一致で取られるので別のパスにする
+    _server->on("/api/led/playback", HTTP_POST, [this](AsyncWebServerRequest *request) {
+        Serial.println("[API] LED playback API called");
+
+        // 両方の値を確かめてから反映する（片方だけ反映してエラーを返さないように）
+        bool hasSpeed = request->hasParam("speed");
+        bool hasPosition = request->hasParam("position");
+        float speed = hasSpeed ? request->getParam("speed")->value().toFloat() : 1.0f;
+        String position = hasPosition ? request->getParam("position")->value() : String();
+        bool positionValid = position.length() > 0;
+        for (size_t i = 0; i < position.length(); i++) {
+            if (position[i] < '0' || position[i] > '9') {
+                positionValid = false;  // 負の値や数でない値は受け付けない
+            }
+        }
+
+        StaticJsonDocument<256> doc;
+        int code = 200;
+        if (!_ledManager->isJsonPatternRunning()) {
+            code = 409;
+            doc["status"] = "error";
+            doc["message"] = "No JSON pattern is playing";
+        } else if (_ledManager->isJsonPlaybackBaked()) {
+            // フレーム予算を超えて焼き込んだフレームを再生している間は、位置も速度も変えられない
+            code = 409;
+            doc["status"] = "error";
+            doc["message"] = "Pattern is playing baked frames";
+        } else if (hasSpeed && !LEDManager::isValidPlaybackSpeed(speed)) {
+            code = 400;
+            doc["status"] = "error";
+            doc["message"] = "Speed must be between 0.25 and 8";
+        } else if (hasPosition && !positionValid) {
+            code = 400;
+            doc["status"] = "error";
+            doc["message"] = "Position must be a non-negative number of milliseconds";
+        } else if (hasPosition && _ledManager->getJsonTimelineLength() == 0) {
+            code = 400;
+            doc["status"] = "error";
+            doc["message"] = "Pattern is not seekable";
+        } else if ((hasSpeed && !_ledManager->setJsonPlaybackSpeed(speed)) ||
+                   (hasPosition && !_ledManager->seekJsonPattern(strtoul(position.c_str(), nullptr, 10)))) {
+            // 確かめている間にパターンが止まった
+            code = 409;
+            doc["status"] = "error";
+            doc["message"] = "No JSON pattern is playing";
+        } else {
+            doc["status"] = "ok";
+        }
+        doc["position"] = _ledManager->getJsonPlaybackPosition();
+        doc["length"] = _ledManager->getJsonTimelineLength();
+        doc["speed"] = _ledManager->getJsonPlaybackSpeed();
+
+        String response;
+        serializeJson(doc, response);
+
+        request->send(code, "application/json", response);
+    });
 }
 
 
@@ -276,6 +388,19 @@ void WebServerManager::setupNotFoundHandler() {
 void WebServerManager::handleJsonPatternControl(AsyncWebServerRequest *request, uint8_t *data, size_t len) {
     Serial.println("handleJsonPatternControl");
     
+    // 解析に使うメモリを抑えるため、大きすぎる定義は解析しない
+    if (len > JSON_PATTERN_MAX_SOURCE_SIZE) {
+        StaticJsonDocument<256> response;
+        response["status"] = "error";
+        response["message"] = "Pattern is too large";
+        
+        String responseStr;
+        serializeJson(response, responseStr);
+        
+        request->send(413, "application/json", responseStr);
+        return;
+    }
+    
     // JSONデータを文字列に変換
     String jsonString = "";
     for (size_t i = 0; i < len; i++) {
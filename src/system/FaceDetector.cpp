@@ -1,5 +1,7 @@
 #include "FaceDetector.h"
 #include "Constants.h"
+#include "WorldOrientation.h"
+#include "LedOutput.h"
 
 // CRGB型をJSONから読み取るためのヘルパー関数
 uint32_t getCRGBColorFromJson(JsonObject& faceObj, const char* key, uint32_t defaultColor = 0xFFFFFF) {
@@ -144,8 +146,11 @@ bool FaceDetector::calibrateNewFace() {
     faceList[calibratedFaces].ledColor = CRGB::White;
     faceList[calibratedFaces].ledState = 0;
     faceList[calibratedFaces].isActive = true;
+    faceList[calibratedFaces].hasColorCorrection = false;
     
     calibratedFaces++;
+    publishNormals();
+    publishColorCorrection();
     return true;
 }
 
@@ -187,10 +192,30 @@ bool FaceDetector::loadFaces() {
         faceList[calibratedFaces].ledState = faceObj["state"];
         faceList[calibratedFaces].isActive = faceObj["isActive"];
         
+        // 色補正: [R, G, B]のゲイン、または3×3の行列（9要素）
+        faceList[calibratedFaces].hasColorCorrection = false;
+        JsonArray correction = faceObj["colorCorrection"].as<JsonArray>();
+        if (correction.size() == 3) {
+            float matrix[9] = {
+                correction[0].as<float>(), 0, 0,
+                0, correction[1].as<float>(), 0,
+                0, 0, correction[2].as<float>()
+            };
+            memcpy(faceList[calibratedFaces].colorCorrection, matrix, sizeof(matrix));
+            faceList[calibratedFaces].hasColorCorrection = true;
+        } else if (correction.size() == 9) {
+            for (int i = 0; i < 9; i++) {
+                faceList[calibratedFaces].colorCorrection[i] = correction[i].as<float>();
+            }
+            faceList[calibratedFaces].hasColorCorrection = true;
+        }
+        
         calibratedFaces++;
     }
     
     file.close();
+    publishNormals();
+    publishColorCorrection();
     Serial.println("Loaded " + String(calibratedFaces) + " faces from SD card");
     return true;
 }
@@ -212,6 +237,12 @@ bool FaceDetector::saveFaces() {
         faceObj["color"] = (uint32_t)faceList[i].ledColor;
         faceObj["state"] = faceList[i].ledState;
         faceObj["isActive"] = faceList[i].isActive;
+        if (faceList[i].hasColorCorrection) {
+            JsonArray correction = faceObj["colorCorrection"].to<JsonArray>();
+            for (int j = 0; j < 9; j++) {
+                correction.add(faceList[i].colorCorrection[j]);
+            }
+        }
     }
     
     if (!SD.begin(GPIO_NUM_4, SPI, 25000000)) {
@@ -244,6 +275,8 @@ bool FaceDetector::saveFaces() {
 void FaceDetector::resetFaces() {
     calibratedFaces = 0;
     memset(faceList, 0, sizeof(FaceData) * maxFaces);
+    publishNormals();
+    publishColorCorrection();
     
     // SDカードのデータを削除
     if (!SD.begin(GPIO_NUM_4, SPI, 25000000)) {
@@ -257,4 +290,59 @@ void FaceDetector::resetFaces() {
     } else {
         Serial.println("No face data found on SD card");
     }
-}
\ No newline at end of file
+}
+
+void FaceDetector::publishNormals() {
+    WorldOrientation& orientation = WorldOrientation::getInstance();
+    orientation.clearFaceNormals();
+    
+    // 面のIDはOctagonRingViewの面IDで、LEDの面IDと同じ並び
+    for (int i = 0; i < calibratedFaces; i++) {
+        orientation.setFaceNormal(faceList[i].id, faceList[i].x, faceList[i].y, faceList[i].z);
+    }
+}
+
+bool FaceDetector::setFaceColorGains(int faceId, float r, float g, float b) {
+    float matrix[9] = {r, 0, 0, 0, g, 0, 0, 0, b};
+    return setFaceColorMatrix(faceId, matrix);
+}
+
+bool FaceDetector::setFaceColorMatrix(int faceId, const float matrix[9]) {
+    for (int i = 0; i < calibratedFaces; i++) {
+        if (faceList[i].id != faceId) continue;
+        
+        memcpy(faceList[i].colorCorrection, matrix, sizeof(float) * 9);
+        faceList[i].hasColorCorrection = true;
+        publishColorCorrection();
+        return true;
+    }
+    return false;
+}
+
+bool FaceDetector::clearFaceColorCorrection(int faceId) {
+    for (int i = 0; i < calibratedFaces; i++) {
+        if (faceList[i].id != faceId) continue;
+        
+        faceList[i].hasColorCorrection = false;
+        publishColorCorrection();
+        return true;
+    }
+    return false;
+}
+
+void FaceDetector::publishColorCorrection() {
+    LedOutputRouter& router = LedOutputRouter::getInstance();
+    router.clearColorCorrection();
+    
+    // 面のLEDアドレスはLEDテープ上のオフセットを除いた番号
+    for (int i = 0; i < calibratedFaces; i++) {
+        if (!faceList[i].hasColorCorrection) continue;
+        
+        LedColorMatrix matrix = LedColorMatrix::fromFloats(faceList[i].colorCorrection);
+        int numLEDs = constrain(faceList[i].numLEDs, 0, 3);
+        for (int j = 0; j < numLEDs; j++) {
+            if (faceList[i].ledAddress[j] < 0) continue;
+            router.setColorCorrection(LED_ADDRESS_OFFSET + faceList[i].ledAddress[j], matrix);
+        }
+    }
+}
@@ -37,6 +37,8 @@ struct FaceData {
     CRGB ledColor;        // LEDの色
     int ledState;         // LEDの状態（ON=1, OFF=0）
     bool isActive;        // この面がアクティブか
+    bool hasColorCorrection;    // 色補正を使うか（falseなら補正なし）
+    float colorCorrection[9];   // 色補正行列（行優先、1.0 = 変化なし）
 };
 
 class FaceDetector {
@@ -58,6 +60,16 @@ public:
     int getNearestFace(float x, float y, float z);
     FaceData* getFaceList() { return faceList; }
     int getCalibratedFacesCount() { return calibratedFaces; }
+    // 登録済みの面の法線をWorldOrientationに反映（LEDパターンから参照される）
+    void publishNormals();
+    
+    // 面ごとの色補正（LEDの個体差の補正。saveFaces()で面のデータと一緒に保存される）
+    // gains: R, G, Bのゲイン（1.0 = 変化なし）/ matrix: 3×3の行列（行優先）
+    bool setFaceColorGains(int faceId, float r, float g, float b);
+    bool setFaceColorMatrix(int faceId, const float matrix[9]);
+    bool clearFaceColorCorrection(int faceId);
+    // 色補正をLEDの出力段（LedOutputRouter）に反映
+    void publishColorCorrection();
 };
 
 #endif // FACE_DETECTOR_H
\ No newline at end of file
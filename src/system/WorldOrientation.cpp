@@ -0,0 +1,90 @@
+#include "WorldOrientation.h"
+
+// 読み取り競合時に読み直す回数
+#define ORIENTATION_READ_RETRIES 3
+
+WorldOrientation& WorldOrientation::getInstance() {
+    static WorldOrientation instance;
+    return instance;
+}
+
+WorldOrientation::WorldOrientation()
+    : m_gravitySeq(0), m_normalsSeq(0), m_normalMask(0) {
+    m_gravity[0] = m_gravity[1] = m_gravity[2] = 0.0f;
+    memset(m_normals, 0, sizeof(m_normals));
+}
+
+void WorldOrientation::publishGravity(float x, float y, float z) {
+    float mag = sqrt(x * x + y * y + z * z);
+    if (mag < 0.01f) return; // 自由落下中などは向きが定まらない
+
+    uint32_t seq = m_gravitySeq.load(std::memory_order_relaxed);
+    m_gravitySeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_gravity[0] = x / mag;
+    m_gravity[1] = y / mag;
+    m_gravity[2] = z / mag;
+    m_gravitySeq.store(seq + 2, std::memory_order_release);
+}
+
+void WorldOrientation::setFaceNormal(int face, float x, float y, float z) {
+    if (face < 0 || face >= ORIENTATION_MAX_FACES) return;
+    float mag = sqrt(x * x + y * y + z * z);
+    if (mag < 0.01f) return;
+
+    uint32_t seq = m_normalsSeq.load(std::memory_order_relaxed);
+    m_normalsSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_normals[face][0] = x / mag;
+    m_normals[face][1] = y / mag;
+    m_normals[face][2] = z / mag;
+    m_normalMask |= (1UL << face);
+    m_normalsSeq.store(seq + 2, std::memory_order_release);
+}
+
+void WorldOrientation::clearFaceNormals() {
+    uint32_t seq = m_normalsSeq.load(std::memory_order_relaxed);
+    m_normalsSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_normalMask = 0;
+    m_normalsSeq.store(seq + 2, std::memory_order_release);
+}
+
+bool WorldOrientation::readGravity(float gravity[3]) const {
+    for (int attempt = 0; attempt < ORIENTATION_READ_RETRIES; attempt++) {
+        uint32_t before = m_gravitySeq.load(std::memory_order_acquire);
+        if (before == 0) return false; // まだ一度も書き込まれていない
+        if (before & 1) continue;      // 書き込み中
+
+        gravity[0] = m_gravity[0];
+        gravity[1] = m_gravity[1];
+        gravity[2] = m_gravity[2];
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_gravitySeq.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WorldOrientation::readFaceNormals(float normals[][3], int maxFaces, uint32_t& mask, uint32_t& version) const {
+    if (maxFaces > ORIENTATION_MAX_FACES) maxFaces = ORIENTATION_MAX_FACES;
+
+    for (int attempt = 0; attempt < ORIENTATION_READ_RETRIES; attempt++) {
+        uint32_t before = m_normalsSeq.load(std::memory_order_acquire);
+        if (before & 1) continue;
+
+        uint32_t readMask = m_normalMask;
+        memcpy(normals, m_normals, sizeof(float) * 3 * maxFaces);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_normalsSeq.load(std::memory_order_relaxed) == before) {
+            if (maxFaces < 32) readMask &= (1UL << maxFaces) - 1;
+            mask = readMask;
+            version = before;
+            return true;
+        }
+    }
+    return false;
+}
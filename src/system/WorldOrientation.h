@@ -0,0 +1,49 @@
+#ifndef WORLD_ORIENTATION_H
+#define WORLD_ORIENTATION_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// 法線を保持できる最大面数
+#define ORIENTATION_MAX_FACES 32
+
+// 重力方向と面の法線を、IMUを読むタスクからLEDタスクへ受け渡すクラス
+// 書き込みはメインループの1タスクのみ、読み取りはどのタスクからでも可能。
+// シーケンスロック方式で、読み取り側は書き込みを待たずに一貫した値を得る
+// （書き込み中に当たった場合は数回だけ読み直し、だめなら前回値を使ってもらう）。
+class WorldOrientation {
+public:
+    static WorldOrientation& getInstance();
+
+    // ---- 書き込み側（メインループ） ----
+    // 現在の重力方向（デバイス座標、正規化前の加速度でよい）
+    void publishGravity(float x, float y, float z);
+    // 面faceが下を向いているときの重力方向（FaceDataのx/y/z）
+    void setFaceNormal(int face, float x, float y, float z);
+    void clearFaceNormals();
+
+    // ---- 読み取り側（LEDタスク） ----
+    // 正規化済みの重力方向（下向き）を取得。未取得または読み取り競合時はfalse
+    bool readGravity(float gravity[3]) const;
+    // 法線の更新回数（変化したときだけreadFaceNormalsで読み直せばよい）
+    uint32_t getNormalsVersion() const { return m_normalsSeq.load(std::memory_order_acquire); }
+    // 面の法線を取得。mask: 登録済みの面のビットマスク、version: 読み取った時点の更新回数
+    // 読み取り競合時はfalse
+    bool readFaceNormals(float normals[][3], int maxFaces, uint32_t& mask, uint32_t& version) const;
+
+private:
+    WorldOrientation();
+    WorldOrientation(const WorldOrientation&);
+    WorldOrientation& operator=(const WorldOrientation&);
+
+    // 重力方向（m_gravitySeqが奇数の間は書き込み中）
+    std::atomic<uint32_t> m_gravitySeq;
+    float m_gravity[3];
+
+    // 面の法線（m_normalsSeqが奇数の間は書き込み中）
+    std::atomic<uint32_t> m_normalsSeq;
+    float m_normals[ORIENTATION_MAX_FACES][3];
+    uint32_t m_normalMask;
+};
+
+#endif // WORLD_ORIENTATION_H
@@ -0,0 +1,173 @@
+#ifndef LUMI_HOST_ARDUINO_H
+#define LUMI_HOST_ARDUINO_H
+
+// ホスト（PC）でLEDエンジンのヘッダーをビルドするための最小限のArduino互換層
+// tools/のツールがJSONパターンの解析・IRへの変換を本体と同じコードで行うためのもので、
+// 描画・出力は行わない（色の変換などは近似、出力先は何もしない）。
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <algorithm>
+
+// ArduinoJsonにArduinoのString・Stream・Printを使わせる（ARDUINOが定義されないため）
+#define ARDUINOJSON_ENABLE_ARDUINO_STRING 1
+#define ARDUINOJSON_ENABLE_ARDUINO_STREAM 1
+#define ARDUINOJSON_ENABLE_ARDUINO_PRINT 1
+
+using std::min;
+using std::max;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define F(string_literal) (string_literal)
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+// ESP-IDF（本体ではArduino.hから見える）
+uint32_t esp_random();
+
+// FreeRTOS（本体ではArduino.hから見える）
+typedef uint32_t TickType_t;
+#define portTICK_PERIOD_MS 1
+void vTaskDelay(TickType_t ticks);
+
+class String {
+public:
+    String() {}
+    String(const char* value) : m_value(value ? value : "") {}
+    String(const std::string& value) : m_value(value) {}
+    explicit String(char value) : m_value(1, value) {}
+    explicit String(int value) : m_value(std::to_string(value)) {}
+    explicit String(unsigned int value) : m_value(std::to_string(value)) {}
+    explicit String(long value) : m_value(std::to_string(value)) {}
+    explicit String(unsigned long value) : m_value(std::to_string(value)) {}
+
+    const char* c_str() const { return m_value.c_str(); }
+    unsigned int length() const { return m_value.length(); }
+    bool reserve(unsigned int size) { m_value.reserve(size); return true; }
+
+    bool concat(const char* value) { m_value += value; return true; }
+    bool concat(const char* value, unsigned int length) { m_value.append(value, length); return true; }
+    bool concat(char value) { m_value += value; return true; }
+    bool concat(const String& value) { m_value += value.m_value; return true; }
+    String& operator+=(const char* value) { concat(value); return *this; }
+    String& operator+=(char value) { concat(value); return *this; }
+    String& operator+=(const String& value) { concat(value); return *this; }
+
+    bool operator==(const String& other) const { return m_value == other.m_value; }
+    bool operator==(const char* other) const { return m_value == (other ? other : ""); }
+    bool operator!=(const String& other) const { return m_value != other.m_value; }
+    bool operator!=(const char* other) const { return !(*this == other); }
+    bool operator<(const String& other) const { return m_value < other.m_value; }
+
+    char operator[](unsigned int index) const { return index < m_value.size() ? m_value[index] : 0; }
+
+    String substring(unsigned int from) const { return substring(from, m_value.size()); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) std::swap(from, to);
+        if (from >= m_value.size()) return String();
+        return String(m_value.substr(from, std::min<size_t>(to, m_value.size()) - from));
+    }
+    bool startsWith(const String& prefix) const { return m_value.compare(0, prefix.m_value.size(), prefix.m_value) == 0; }
+    bool endsWith(const String& suffix) const {
+        return m_value.size() >= suffix.m_value.size() &&
+               m_value.compare(m_value.size() - suffix.m_value.size(), suffix.m_value.size(), suffix.m_value) == 0;
+    }
+    int indexOf(char value) const {
+        size_t position = m_value.find(value);
+        return position == std::string::npos ? -1 : (int)position;
+    }
+    long toInt() const { return atol(m_value.c_str()); }
+
+private:
+    std::string m_value;
+};
+
+inline String operator+(const String& a, const String& b) { String result(a); result += b; return result; }
+inline String operator+(const String& a, const char* b) { String result(a); result += b; return result; }
+inline String operator+(const char* a, const String& b) { String result(a); result += b; return result; }
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t value) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t written = 0;
+        while (size--) written += write(*buffer++);
+        return written;
+    }
+    size_t write(const char* value) { return write((const uint8_t*)value, strlen(value)); }
+
+    size_t print(const char* value) { return write(value); }
+    size_t print(const String& value) { return write(value.c_str()); }
+    size_t print(char value) { return write((uint8_t)value); }
+    size_t print(int value) { return print(String(value)); }
+    size_t print(unsigned int value) { return print(String(value)); }
+    size_t print(long value) { return print(String(value)); }
+    size_t print(unsigned long value) { return print(String(value)); }
+    template <typename T>
+    size_t println(const T& value) { return print(value) + println(); }
+    size_t println() { return write("\n"); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    size_t readBytes(char* buffer, size_t length) {
+        size_t count = 0;
+        int value;
+        while (count < length && (value = read()) >= 0) {
+            buffer[count++] = (char)value;
+        }
+        return count;
+    }
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+    String readString() {
+        String result;
+        int value;
+        while ((value = read()) >= 0) {
+            result += (char)value;
+        }
+        return result;
+    }
+};
+
+// ログの出力先（標準エラー出力。標準出力はツールの結果に使う）
+class HostSerial : public Stream {
+public:
+    HostSerial() : m_enabled(true) {}
+    using Print::write;
+    size_t write(uint8_t value) override { return m_enabled ? fwrite(&value, 1, 1, stderr) : 1; }
+    size_t write(const uint8_t* buffer, size_t size) override { return m_enabled ? fwrite(buffer, 1, size, stderr) : size; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void begin(unsigned long) {}
+    // 本体のログを止める（ツールの-qオプション）
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+private:
+    bool m_enabled;
+};
+extern HostSerial Serial;
+
+class IPAddress {
+public:
+    IPAddress() { memset(m_bytes, 0, sizeof(m_bytes)); }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { m_bytes[0] = a; m_bytes[1] = b; m_bytes[2] = c; m_bytes[3] = d; }
+    uint8_t operator[](int index) const { return m_bytes[index]; }
+private:
+    uint8_t m_bytes[4];
+};
+
+#endif // LUMI_HOST_ARDUINO_H
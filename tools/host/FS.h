@@ -0,0 +1,30 @@
+#ifndef LUMI_HOST_FS_H
+#define LUMI_HOST_FS_H
+
+// ホストビルド用のファイルシステムの代替（LedOutput.hのFileSinkのための型だけ。開けるファイルはない）
+
+#include <Arduino.h>
+
+namespace fs {
+
+class File : public Stream {
+public:
+    size_t write(uint8_t) override { return 0; }
+    size_t write(const uint8_t*, size_t) override { return 0; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    operator bool() const { return false; }
+    void close() {}
+};
+
+class FS {
+public:
+    File open(const String&, const char*) { return File(); }
+};
+
+} // namespace fs
+
+using fs::File;
+
+#endif // LUMI_HOST_FS_H
@@ -0,0 +1,139 @@
+#ifndef LUMI_HOST_FASTLED_H
+#define LUMI_HOST_FASTLED_H
+
+// ホストビルド用のFastLEDの最小限の代替（Arduino.hの説明を参照）
+// 型と、LEDエンジンのヘッダーが使う関数の宣言・簡易な実装だけを持つ。
+// 色の変換とパレットは近似で、ホストのツールは色の値を結果に使わない。
+
+#include <Arduino.h>
+
+typedef uint8_t fract8;
+
+struct CHSV {
+    uint8_t h, s, v;
+    CHSV() : h(0), s(0), v(0) {}
+    CHSV(uint8_t hue, uint8_t saturation, uint8_t value) : h(hue), s(saturation), v(value) {}
+};
+
+struct CRGB {
+    union {
+        struct {
+            uint8_t r;
+            uint8_t g;
+            uint8_t b;
+        };
+        uint8_t raw[3];
+    };
+
+    enum HTMLColorCode : uint32_t {
+        Black = 0x000000,
+        White = 0xFFFFFF,
+        Red = 0xFF0000,
+        Green = 0x008000,
+        Blue = 0x0000FF
+    };
+
+    CRGB() : r(0), g(0), b(0) {}
+    CRGB(uint8_t red, uint8_t green, uint8_t blue) : r(red), g(green), b(blue) {}
+    CRGB(uint32_t code) : r((code >> 16) & 0xFF), g((code >> 8) & 0xFF), b(code & 0xFF) {}
+    CRGB(const CHSV& hsv) { *this = hsv; }
+
+    // HSV → RGB（単純な6区間の変換。FastLEDのrainbow変換とは値が一致しない）
+    CRGB& operator=(const CHSV& hsv) {
+        uint8_t region = hsv.h / 43;
+        uint8_t remainder = (hsv.h - region * 43) * 6;
+        uint8_t p = (hsv.v * (255 - hsv.s)) >> 8;
+        uint8_t q = (hsv.v * (255 - ((hsv.s * remainder) >> 8))) >> 8;
+        uint8_t t = (hsv.v * (255 - ((hsv.s * (255 - remainder)) >> 8))) >> 8;
+        switch (region) {
+            case 0:  r = hsv.v; g = t; b = p; break;
+            case 1:  r = q; g = hsv.v; b = p; break;
+            case 2:  r = p; g = hsv.v; b = t; break;
+            case 3:  r = p; g = q; b = hsv.v; break;
+            case 4:  r = t; g = p; b = hsv.v; break;
+            default: r = hsv.v; g = p; b = q; break;
+        }
+        return *this;
+    }
+
+    CRGB& nscale8_video(uint8_t scale) {
+        for (int i = 0; i < 3; i++) {
+            raw[i] = raw[i] == 0 ? 0 : (uint8_t)(((raw[i] * scale) >> 8) + (scale != 0 ? 1 : 0));
+        }
+        return *this;
+    }
+    CRGB& fadeToBlackBy(uint8_t fadeBy) {
+        for (int i = 0; i < 3; i++) {
+            raw[i] = (raw[i] * (255 - fadeBy)) >> 8;
+        }
+        return *this;
+    }
+};
+
+inline bool operator==(const CRGB& a, const CRGB& b) { return a.r == b.r && a.g == b.g && a.b == b.b; }
+inline bool operator!=(const CRGB& a, const CRGB& b) { return !(a == b); }
+
+inline void fill_solid(CRGB* leds, int count, const CRGB& color) {
+    for (int i = 0; i < count; i++) leds[i] = color;
+}
+
+// パレット（ホストでは元データから色を作らず、単色の近似のまま持つ）
+typedef const uint32_t TProgmemRGBPalette16[16];
+typedef const uint8_t* TDynamicRGBGradientPalette_bytes;
+
+class CRGBPalette16 {
+public:
+    CRGB entries[16];
+
+    CRGBPalette16() {}
+    CRGBPalette16(const TProgmemRGBPalette16& values) { *this = values; }
+    CRGBPalette16& operator=(const TProgmemRGBPalette16& values) {
+        for (int i = 0; i < 16; i++) entries[i] = CRGB(values[i]);
+        return *this;
+    }
+    // 停止点の色をそのまま16エントリに割り振る（補間しない）
+    CRGBPalette16& loadDynamicGradientPalette(TDynamicRGBGradientPalette_bytes gradient) {
+        for (int i = 0; i < 16; i++) {
+            const uint8_t* stop = gradient;
+            while (stop[0] < i * 16 + 15 && stop[0] != 255) stop += 4;
+            entries[i] = CRGB(stop[1], stop[2], stop[3]);
+        }
+        return *this;
+    }
+};
+
+enum TBlendType { NOBLEND = 0, LINEARBLEND = 1 };
+
+inline CRGB ColorFromPalette(const CRGBPalette16& palette, uint8_t index, uint8_t brightness = 255, TBlendType = LINEARBLEND) {
+    CRGB color = palette.entries[index >> 4];
+    return CRGB((color.r * brightness) >> 8, (color.g * brightness) >> 8, (color.b * brightness) >> 8);
+}
+
+// 組み込みパレット（ホストでは色を使わないので代表色のみ）
+#define LUMI_HOST_PALETTE(name, color) \
+    const TProgmemRGBPalette16 name = {color, color, color, color, color, color, color, color, \
+                                       color, color, color, color, color, color, color, color}
+LUMI_HOST_PALETTE(HeatColors_p, 0xFF4000);
+LUMI_HOST_PALETTE(RainbowColors_p, 0xFF0000);
+LUMI_HOST_PALETTE(LavaColors_p, 0x800000);
+LUMI_HOST_PALETTE(OceanColors_p, 0x000080);
+LUMI_HOST_PALETTE(ForestColors_p, 0x006400);
+LUMI_HOST_PALETTE(PartyColors_p, 0x5500AB);
+LUMI_HOST_PALETTE(CloudColors_p, 0x87CEEB);
+#undef LUMI_HOST_PALETTE
+
+// 出力（ホストでは何もしない）
+enum EOrder { RGB = 0012, GRB = 0102 };
+template <uint8_t DATA_PIN, EOrder RGB_ORDER> class WS2812B {};
+
+class CFastLED {
+public:
+    template <template <uint8_t, EOrder> class CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER>
+    void addLeds(CRGB*, int) {}
+    void show() {}
+    void show(uint8_t) {}
+    void setBrightness(uint8_t) {}
+};
+extern CFastLED FastLED;
+
+#endif // LUMI_HOST_FASTLED_H
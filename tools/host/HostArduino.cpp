@@ -0,0 +1,50 @@
+// ホストビルド用のArduino互換層の実装（Arduino.hの説明を参照）
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include <stdarg.h>
+#include <chrono>
+#include <thread>
+#include <random>
+
+HostSerial Serial;
+CFastLED FastLED;
+
+namespace {
+
+const std::chrono::steady_clock::time_point s_start = std::chrono::steady_clock::now();
+
+} // namespace
+
+unsigned long millis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - s_start).count();
+}
+
+unsigned long micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - s_start).count();
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+uint32_t esp_random() {
+    static std::random_device device;
+    return device();
+}
+
+void vTaskDelay(TickType_t ticks) {
+    delay(ticks * portTICK_PERIOD_MS);
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length < 0) {
+        return 0;
+    }
+    return write((const uint8_t*)buffer, min((size_t)length, sizeof(buffer) - 1));
+}
@@ -0,0 +1,51 @@
+#ifndef LUMI_HOST_FILE_STREAM_H
+#define LUMI_HOST_FILE_STREAM_H
+
+// ホストのファイルをArduinoのStreamとして読む（本体でSPIFFSのFileを渡すのと同じ経路で解析するため）
+
+#include <Arduino.h>
+
+class HostFileStream : public Stream {
+public:
+    explicit HostFileStream(const char* path) : m_file(fopen(path, "rb")), m_size(0) {}
+    ~HostFileStream() {
+        if (m_file) fclose(m_file);
+    }
+
+    bool isOpen() const { return m_file != nullptr; }
+    // 読んだバイト数
+    size_t getSize() const { return m_size; }
+
+    size_t write(uint8_t) override { return 0; }
+    size_t write(const uint8_t*, size_t) override { return 0; }
+    // 本体のFileと同じく、残りのバイト数を返す
+    int available() override {
+        if (!m_file) return 0;
+        long position = ftell(m_file);
+        if (position < 0 || fseek(m_file, 0, SEEK_END) != 0) return 0;
+        long end = ftell(m_file);
+        fseek(m_file, position, SEEK_SET);
+        return end > position ? (int)(end - position) : 0;
+    }
+    int read() override {
+        int value = m_file ? fgetc(m_file) : EOF;
+        if (value == EOF) return -1;
+        m_size++;
+        return value;
+    }
+    int peek() override {
+        int value = m_file ? fgetc(m_file) : EOF;
+        if (value == EOF) return -1;
+        ungetc(value, m_file);
+        return value;
+    }
+
+private:
+    HostFileStream(const HostFileStream&);
+    HostFileStream& operator=(const HostFileStream&);
+
+    FILE* m_file;
+    size_t m_size;
+};
+
+#endif // LUMI_HOST_FILE_STREAM_H
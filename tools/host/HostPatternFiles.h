@@ -0,0 +1,33 @@
+#ifndef LUMI_HOST_PATTERN_FILES_H
+#define LUMI_HOST_PATTERN_FILES_H
+
+// ホストのツールでJSONパターンのファイルを読み込む（本体と同じJsonPatternManagerの解析を使う）
+
+#include <Arduino.h>
+#include <vector>
+#include "JsonLEDPatterns.h"
+#include "HostFileStream.h"
+
+// ファイルを順に読み込み、読めなかったファイルの数を返す（理由はstderrに出す）
+// jsonBytesには読み込んだバイト数の合計を足す
+inline int loadHostPatternFiles(const std::vector<const char*>& inputs, JsonPatternManager& manager, size_t& jsonBytes) {
+    int failed = 0;
+    for (const char* input : inputs) {
+        HostFileStream stream(input);
+        if (!stream.isOpen()) {
+            fprintf(stderr, "%s: cannot open\n", input);
+            failed++;
+            continue;
+        }
+        String error;
+        int added = manager.loadPatternsFromStream(stream, error);
+        jsonBytes += stream.getSize();
+        if (added <= 0) {
+            fprintf(stderr, "%s: %s\n", input, added < 0 ? error.c_str() : "no valid pattern");
+            failed++;
+        }
+    }
+    return failed;
+}
+
+#endif // LUMI_HOST_PATTERN_FILES_H
@@ -0,0 +1,19 @@
+#ifndef LUMI_HOST_WIFI_UDP_H
+#define LUMI_HOST_WIFI_UDP_H
+
+// ホストビルド用のUDPの代替（LedOutput.hのUdpSinkのための型だけ。送信はしない）
+
+#include <Arduino.h>
+
+class WiFiUDP : public Print {
+public:
+    using Print::write;
+    uint8_t begin(uint16_t) { return 1; }
+    void stop() {}
+    int beginPacket(const IPAddress&, uint16_t) { return 0; }
+    int endPacket() { return 0; }
+    size_t write(uint8_t) override { return 0; }
+    size_t write(const uint8_t*, size_t) override { return 0; }
+};
+
+#endif // LUMI_HOST_WIFI_UDP_H
@@ -0,0 +1,89 @@
+// lumianalyze: JSONパターンの1フレームあたりの処理量とステップの速さを見積もるホストのツール
+//
+//   lumianalyze [-q] [-f fps] [-n faces] data/leds/*.json
+//
+// 本体と同じ解析でIRに変換し、JsonLedPattern::estimateCostで数える（再生時と同じIRを見る）。
+// 目標のFPSで表示しきれないステップ（1フレームより短いステップ）があるパターンを報告し、
+// そのようなパターンか解析できないファイルがあれば終了コード1。
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include <vector>
+#include "JsonLEDPatterns.h"
+#include "HostPatternFiles.h"
+
+// 本体の既定値（OctaController.hのTARGET_FPS、LEDManagerの面の数と先頭のLEDの位置）
+#define ANALYZE_DEFAULT_FPS 30
+#define ANALYZE_DEFAULT_FACES 8
+#define ANALYZE_LED_OFFSET 1
+
+namespace {
+
+void printUsage() {
+    fprintf(stderr, "usage: lumianalyze [-q] [-f fps] [-n faces] <pattern.json>...\n");
+}
+
+String formatRate(uint32_t rate) {
+    return rate == 0xFFFFFFFFUL ? String("inf") : String(rate);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int fps = ANALYZE_DEFAULT_FPS;
+    int faces = ANALYZE_DEFAULT_FACES;
+    std::vector<const char*> inputs;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            fps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            faces = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-q") == 0) {
+            Serial.setEnabled(false);
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if (inputs.empty() || fps <= 0 || faces <= 0 || faces > 32) {
+        printUsage();
+        return 2;
+    }
+    uint32_t frameInterval = 1000 / fps;
+
+    JsonPatternManager manager;
+    size_t jsonBytes = 0;
+    int failed = loadHostPatternFiles(inputs, manager, jsonBytes);
+
+    printf("target %d fps (%u ms/frame), %d faces\n", fps, (unsigned)frameInterval, faces);
+    printf("  %-24s %6s %8s %9s %11s %5s %6s %6s %7s %6s\n",
+           "pattern", "steps", "min ms", "steps/s", "steps/frame", "faces", "writes", "colors", "effects", "expr");
+    int flagged = 0;
+    for (int i = 0; i < manager.getPatternCount(); i++) {
+        JsonLedPattern* pattern = manager.getPatternByIndex(i);
+        JsonPatternCost cost;
+        if (!pattern->estimateCost(faces, ANALYZE_LED_OFFSET, frameInterval, cost)) {
+            printf("  %-24s (not analyzable)\n", pattern->getName().c_str());
+            continue;
+        }
+        printf("  %-24s %6u %8u %9s %11s %5u %6u %6u %7u %6u\n", pattern->getName().c_str(),
+               (unsigned)cost.stepCount, (unsigned)cost.minStepInterval, formatRate(cost.peakStepsPerSecond).c_str(),
+               formatRate(cost.peakStepsPerFrame).c_str(),
+               (unsigned)cost.maxLitFaces, (unsigned)cost.ledWritesPerFrame, (unsigned)cost.colorOpsPerFrame,
+               (unsigned)cost.effectOpsPerFrame, (unsigned)cost.exprOpsPerFrame);
+
+        // 1フレームより短いステップは、フレームの時刻によっては一度も描かれない
+        // （1フレームの間に始まるステップのうち描かれるのは最後の1つだけ）
+        if (cost.shortSteps > 0) {
+            printf("    ! %u of %u steps are shorter than one frame (%u ms); up to %s steps start within one frame\n",
+                   (unsigned)cost.shortSteps, (unsigned)cost.stepCount, (unsigned)frameInterval,
+                   formatRate(cost.peakStepsPerFrame).c_str());
+            flagged++;
+        }
+    }
+
+    if (failed > 0 || flagged > 0) {
+        fprintf(stderr, "%d file(s) failed, %d pattern(s) cannot meet %d fps\n", failed, flagged, fps);
+        return 1;
+    }
+    return 0;
+}
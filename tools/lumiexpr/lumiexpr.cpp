@@ -0,0 +1,125 @@
+// lumiexpr: JSONパターンの色の式を変換し、1回の評価の時間（ns）を測るホストのツール
+//
+//   lumiexpr [-n evaluations] ["expression"...]
+//
+// 本体と同じLedExpressionで命令列に変換し、LEDごとの評価と同じく変数を変えながら繰り返し評価する。
+// 式を省略すると代表的な式を測り、あわせて見本の入力での値をC++で計算した値と比べる（変換の誤りの検出）。
+// 変換できない式か、値が合わない式があれば終了コード1。
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include "LedExpression.h"
+
+// 既定の評価回数と、測る式
+#define EXPR_DEFAULT_EVALUATIONS 1000000
+// 本体の面とLEDの数（LEDManagerの既定値）
+#define EXPR_FACES 8
+
+namespace {
+
+// 見本の入力（t=10ms、face=1、led=2、audio=128、下のbandsとBPM）
+#define EXPR_SAMPLE_T 10
+#define EXPR_SAMPLE_FACE 1
+#define EXPR_SAMPLE_LED 2
+#define EXPR_SAMPLE_AUDIO 128
+
+const uint8_t kSampleBands[8] = {200, 160, 120, 90, 60, 40, 20, 10};
+const float kSampleBpm = 120.0f;
+
+// 既定の式と、見本の入力での値をC++で求める関数
+struct DefaultExpression {
+    const char* source;
+    float (*reference)(float t, float face, float led, float beat, float audio);
+};
+
+const DefaultExpression kDefaultExpressions[] = {
+    {"t*0.1 + face*32", [](float t, float face, float, float, float) { return t * 0.1f + face * 32; }},
+    {"led*16 - t/8", [](float t, float, float led, float, float) { return led * 16 - t / 8; }},
+    {"128 + sin(t*0.002 + led*0.5)*band0/2",
+     [](float t, float, float led, float, float) { return 128 + sinf(t * 0.002f + led * 0.5f) * kSampleBands[0] / 2; }},
+    {"max(audio, beat*255)", [](float, float, float, float beat, float audio) { return max(audio, beat * 255); }},
+    {"abs((t/4 + face*32) % 256 - 128)*2",
+     [](float t, float face, float, float, float) { return fabsf(fmodf(t / 4 + face * 32, 256) - 128) * 2; }},
+    // 変数の後に命令が続く場合の畳み込み（オペランドのバイトを命令と取り違えないか）
+    {"-(face*3 + face*5 + face*7 + t)", [](float t, float face, float, float, float) { return -(face * 15 + t); }},
+    {"face*7 - t*t", [](float t, float face, float, float, float) { return face * 7 - t * t; }},
+};
+
+void printUsage() {
+    fprintf(stderr, "usage: lumiexpr [-n evaluations] [\"expression\"...]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    long evaluations = EXPR_DEFAULT_EVALUATIONS;
+    std::vector<const char*> sources;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            evaluations = atol(argv[++i]);
+        } else {
+            sources.push_back(argv[i]);
+        }
+    }
+    if (evaluations <= 0) {
+        printUsage();
+        return 2;
+    }
+    std::vector<const DefaultExpression*> references;
+    if (sources.empty()) {
+        for (const DefaultExpression& expression : kDefaultExpressions) {
+            sources.push_back(expression.source);
+            references.push_back(&expression);
+        }
+    }
+
+    // 音の入力は固定の値にする（評価の時間は値によらない）
+    LedExpression::setAudioBands(kSampleBands, kSampleBpm);
+
+    printf("  %-40s %5s %6s %10s %10s\n", "expression", "ops", "bytes", "sample", "ns/eval");
+    int failed = 0;
+    for (size_t n = 0; n < sources.size(); n++) {
+        const char* source = sources[n];
+        LedExpression expression;
+        String error;
+        if (!expression.compile(source, error)) {
+            printf("  %-40s %s\n", source, error.c_str());
+            failed++;
+            continue;
+        }
+
+        float vars[LedExpression::VAR_COUNT];
+        LedExpression::loadFrameInputs(vars, EXPR_SAMPLE_T, EXPR_SAMPLE_AUDIO);
+        vars[LedExpression::VAR_FACE] = EXPR_SAMPLE_FACE;
+        vars[LedExpression::VAR_LED] = EXPR_SAMPLE_LED;
+        float sample = expression.evaluate(vars);
+        float expected = sample;
+        if (n < references.size()) {
+            expected = references[n]->reference(EXPR_SAMPLE_T, EXPR_SAMPLE_FACE, EXPR_SAMPLE_LED,
+                                                vars[LedExpression::VAR_BEAT], EXPR_SAMPLE_AUDIO);
+        }
+
+        // フレームごとにtを進め、面とLEDを順に変える（描画と同じ変数の変わり方）
+        volatile float sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < evaluations; i++) {
+            int led = i % (EXPR_FACES * 2);
+            if (led == 0) {
+                LedExpression::loadFrameInputs(vars, (uint32_t)(i / (EXPR_FACES * 2)) * 33, EXPR_SAMPLE_AUDIO);
+            }
+            vars[LedExpression::VAR_FACE] = led / 2;
+            vars[LedExpression::VAR_LED] = led;
+            sink = sink + expression.evaluate(vars);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        printf("  %-40s %5u %6u %10.2f %10.2f\n", source, (unsigned)expression.getInstructionCount(),
+               (unsigned)expression.getCodeSize(), sample, ns / evaluations);
+        if (fabsf(sample - expected) > 1e-3f * max(1.0f, fabsf(expected))) {
+            printf("    ! expected %.2f\n", expected);
+            failed++;
+        }
+    }
+    return failed > 0 ? 1 : 0;
+}
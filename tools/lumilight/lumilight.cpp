@@ -0,0 +1,103 @@
+// lumilight: 線形光の変換と合成（LinearLight）を確かめるホストのツール
+//
+//   lumilight
+//
+// 本体と同じLinearLightの表で、次の3つを確かめる。
+//   - 往復: 8ビットの値を線形値にして戻すと元の値になる
+//   - 黒への減衰: どの値からでも、繰り返し減衰させると毎回暗くなり、決まった回数以内に黒になる
+//   - クロスフェードの中間: 赤と青の中間の光量の合計が、端の色の光量とほぼ同じになる（中間が暗くならない）
+// 確かめられない項目があれば終了コード1。
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include "LinearLight.h"
+
+// 減衰の強さ（fadeToBlackByのfadeBy）ごとに、黒になるまでの回数の上限
+// 1回に少なくとも1段階は暗くなるので、どの強さでも255回を超えない
+#define LIGHT_MAX_FADE_STEPS 255
+// クロスフェードの中間の光量の許容範囲（端の色の光量に対する%）
+#define LIGHT_MIDPOINT_MIN_PERCENT 98
+#define LIGHT_MIDPOINT_MAX_PERCENT 102
+
+namespace {
+
+int checkRoundTrip() {
+    int failed = 0;
+    for (int value = 0; value < 256; value++) {
+        uint8_t back = LinearLight::fromLinear(LinearLight::toLinear(value));
+        if (back != value) {
+            printf("  round trip: %d -> %u -> %d\n", value, (unsigned)LinearLight::toLinear(value), back);
+            failed++;
+        }
+    }
+    // 線形値は符号化値に対して単調に増える
+    for (int value = 1; value < 256; value++) {
+        if (LinearLight::toLinear(value) <= LinearLight::toLinear(value - 1)) {
+            printf("  linear value does not increase at %d\n", value);
+            failed++;
+        }
+    }
+    printf("  %-28s %s\n", "round trip (256 values)", failed == 0 ? "ok" : "FAILED");
+    return failed;
+}
+
+int checkFadeToBlack() {
+    const uint8_t fadeAmounts[] = {1, 20, 64, 128, 254};
+    int failed = 0;
+    int slowest = 0;
+    for (uint8_t fadeBy : fadeAmounts) {
+        for (int start = 1; start < 256; start++) {
+            CRGB color(start, start, start);
+            int steps = 0;
+            while (color.r > 0 && steps <= LIGHT_MAX_FADE_STEPS) {
+                uint8_t before = color.r;
+                LinearLight::fadeToBlackBy(&color, 1, fadeBy);
+                steps++;
+                if (color.r >= before) {
+                    printf("  fade by %u from %d: step %d stays at %d\n", fadeBy, start, steps, color.r);
+                    failed++;
+                    break;
+                }
+            }
+            if (color.r > 0) {
+                printf("  fade by %u from %d: not black after %d steps\n", fadeBy, start, steps);
+                failed++;
+            }
+            slowest = max(slowest, steps);
+        }
+    }
+    printf("  %-28s %s (at most %d steps)\n", "fade to black", failed == 0 ? "ok" : "FAILED", slowest);
+    return failed;
+}
+
+int checkCrossfadeMidpoint() {
+    const CRGB red(255, 0, 0);
+    const CRGB blue(0, 0, 255);
+    int failed = 0;
+
+    // 端はそのままの色になる
+    CRGB start = LinearLight::blend(red, blue, 0);
+    CRGB end = LinearLight::blend(red, blue, 255);
+    if (start != red || end != blue) {
+        printf("  crossfade ends: (%d,%d,%d) (%d,%d,%d)\n", start.r, start.g, start.b, end.r, end.g, end.b);
+        failed++;
+    }
+
+    // 中間では2色の光量の合計が端の色1つ分に近い
+    CRGB mid = LinearLight::blend(red, blue, 128);
+    uint32_t ends = LinearLight::toLinear(255);
+    uint32_t light = (uint32_t)LinearLight::toLinear(mid.r) + LinearLight::toLinear(mid.b);
+    uint32_t percent = light * 100 / ends;
+    if (percent < LIGHT_MIDPOINT_MIN_PERCENT || percent > LIGHT_MIDPOINT_MAX_PERCENT) {
+        failed++;
+    }
+    printf("  %-28s %s (%u%% light)\n", "crossfade midpoint", failed == 0 ? "ok" : "FAILED", (unsigned)percent);
+    return failed;
+}
+
+} // namespace
+
+int main() {
+    int failed = checkRoundTrip() + checkFadeToBlack() + checkCrossfadeMidpoint();
+    return failed > 0 ? 1 : 0;
+}
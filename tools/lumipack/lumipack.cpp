@@ -0,0 +1,89 @@
+// lumipack: JSONパターンをコンパイル済みのパック（JsonPatternPack）に変換するホストのツール
+//
+//   lumipack [-q] -o data/leds.lpk data/leds/*.json
+//
+// 解析・IRへの変換は本体と同じコード（src/led/JsonLEDPatterns.h）で行う。
+// 書き出したパックは読み直して、各パターンのIRが一致することを確かめる。
+// 解析できないファイルが1つでもあれば終了コード1（パックは書き出さない）。
+
+#include <Arduino.h>
+#include <vector>
+#include "JsonLEDPatterns.h"
+#include "JsonPatternPack.h"
+#include "HostPatternFiles.h"
+
+namespace {
+
+void printUsage() {
+    fprintf(stderr, "usage: lumipack [-q] -o <output.lpk> <pattern.json>...\n");
+}
+
+// パターンのIRをバイト列にする（読み直したパックとの比較用）
+std::vector<uint8_t> compiledBytes(JsonLedPattern* pattern) {
+    std::vector<uint8_t> bytes;
+    LedSnapshotWriter writer(bytes);
+    pattern->saveCompiled(writer);
+    return bytes;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* output = nullptr;
+    std::vector<const char*> inputs;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "-q") == 0) {
+            Serial.setEnabled(false);
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if (output == nullptr || inputs.empty()) {
+        printUsage();
+        return 2;
+    }
+
+    JsonPatternManager manager;
+    size_t jsonBytes = 0;
+    int failed = loadHostPatternFiles(inputs, manager, jsonBytes);
+    if (failed > 0) {
+        fprintf(stderr, "%d file(s) failed, pack not written\n", failed);
+        return 1;
+    }
+
+    std::vector<uint8_t> pack;
+    int written = JsonPatternPack::write(manager, pack);
+
+    // 読み直して同じIRになることを確かめる
+    JsonPatternManager check;
+    if (JsonPatternPack::read(pack.data(), pack.size(), check) != written) {
+        fprintf(stderr, "verification failed: pack could not be read back\n");
+        return 1;
+    }
+    for (int i = 0; i < manager.getPatternCount(); i++) {
+        JsonLedPattern* original = manager.getPatternByIndex(i);
+        JsonLedPattern* loaded = check.getPatternByName(original->getName());
+        if (loaded == nullptr || compiledBytes(original) != compiledBytes(loaded)) {
+            fprintf(stderr, "verification failed: %s\n", original->getName().c_str());
+            return 1;
+        }
+    }
+
+    FILE* file = fopen(output, "wb");
+    if (file == nullptr || fwrite(pack.data(), 1, pack.size(), file) != pack.size()) {
+        fprintf(stderr, "%s: cannot write\n", output);
+        if (file) fclose(file);
+        return 1;
+    }
+    fclose(file);
+
+    for (int i = 0; i < manager.getPatternCount(); i++) {
+        JsonLedPattern* pattern = manager.getPatternByIndex(i);
+        printf("  %-24s %5u bytes\n", pattern->getName().c_str(), (unsigned)compiledBytes(pattern).size());
+    }
+    printf("%d patterns: JSON %u bytes -> pack %u bytes (%s)\n", written, (unsigned)jsonBytes,
+           (unsigned)pack.size(), output);
+    return 0;
+}